@@ -6,13 +6,46 @@
 // Inicializa el archivo CSV con los encabezados
 void Analysis_Init(void);
 
-// Calcula y guarda métricas globales (Energía, Masa)
-// Retorna el 'residual' (cambio promedio de velocidad) para ver convergencia
+// Guarda métricas globales (Energía, Masa, residual, |u| máximo). Si se pidió
+// Solver_RequestDiagnostics antes del paso usa lo que acumuló el solver; si no,
+// las calcula recorriendo la grilla y el residual queda en 0.
+// Retorna el residual (cambio relativo de la velocidad) para ver convergencia
 float Analysis_ComputeAndSave(SimulationState *state, int time_step);
 
-// Guarda el estado completo de la grilla (para abrir con Python/Matlab/Paraview)
+// Agrega una línea al log con métricas ya calculadas (p.ej. sumadas entre
+// procesos en el modo distribuido)
+void Analysis_SaveDiagnostics(const SolverDiagnostics *d, int time_step);
+
+// Guarda el estado completo de la grilla en texto CSV (para abrir con Python/Matlab/Paraview).
+// Lento y pesado: para corridas largas usar el formato binario de snapshot.h.
 void Analysis_SaveSnapshot(SimulationState *state, int time_step);
 
+// Vorticidad dUy/dx - dUx/dy de las columnas [x0, x1) de la fila y
+// (diferencias centradas, de un lado en los bordes de la grilla)
+void Analysis_VorticityRow(const float *ux, const float *uy, int width, int height,
+                           int y, int x0, int x1, float *out);
+
+// Campo de vorticidad completo (width*height valores)
+void Analysis_ComputeVorticity(const SimulationState *state, float *out);
+
+// Coeficientes de arrastre y sustentación de una fuerza (Solver_ComputeForces):
+// F / (0.5 rho U^2 D) con rho = 1, U = inlet_velocity y D = alto frontal de
+// las paredes. 0 si no hay paredes o la entrada está quieta.
+void Analysis_ForceCoefficients(const SimulationState *state, double fx, double fy,
+                                double *cd, double *cl);
+
+// Log de fuerzas (forces_log.csv): Fx, Fy, Cd, Cl y el número de Strouhal
+// estimado con los cruces de Cl por su media (vacío hasta juntar 3 ciclos).
+// El archivo queda abierto entre llamadas; append = seguir una corrida retomada.
+void Analysis_InitForcesLog(bool append);
+void Analysis_LogForces(const SimulationState *state, int time_step);
+
+// Ídem con las fuerzas de un bloque 'scale' veces más fino que la grilla base
+// (refinamiento local): Fx, Fy y el Strouhal quedan en unidades de la base y
+// time_step es el paso de la base
+void Analysis_LogForcesScaled(const SimulationState *state, int time_step, int scale);
+void Analysis_CloseForcesLog(void);
+
 // Inicializa el log de performance
 void Analysis_InitPerformanceLog(void);
 
@@ -0,0 +1,24 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Memoria grande del solver (poblaciones y campos). Los bloques vienen
+// alineados a ARENA_ALIGN, en cero y sin tocar: en Linux son mapeos
+// anónimos, así cada página queda en el nodo NUMA del hilo que la escribe
+// primero (el solver las inicializa por bandas, igual que el paso).
+#define ARENA_ALIGN 64
+
+typedef enum {
+    HUGE_PAGES_OFF = 0,  // Páginas normales
+    HUGE_PAGES_THP,      // Transparentes (madvise), bloques alineados a 2 MB
+    HUGE_PAGES_EXPLICIT  // hugetlbfs (MAP_HUGETLB); si no hay reservadas, THP
+} HugePageMode;
+
+// Para los bloques que se pidan desde ahora (vale para todo el proceso)
+void Arena_SetHugePages(HugePageMode mode);
+
+void *Arena_Alloc(size_t bytes);
+void Arena_Free(void *ptr);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "state.h"
+#include <stdint.h>
+
+// Checkpoint: copia exacta del estado (poblaciones f, barrier, omega,
+// velocidad de entrada y paso) para retomar una corrida y que siga bit a bit
+// igual que si no se hubiera cortado. Secciones alineadas a CHECKPOINT_ALIGN
+// para poder mapear f directamente desde el archivo.
+#define CHECKPOINT_MAGIC "HCKP"
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_ALIGN 65536
+
+typedef struct {
+    char magic[4];          // "HCKP"
+    uint32_t version;       // CHECKPOINT_VERSION
+    uint32_t header_size;
+    int32_t width;
+    int32_t height;
+    int32_t layout;         // PopulationLayout de f en el archivo
+    int32_t stride;
+    int32_t time_step;
+    float omega;
+    float inlet_velocity;
+    float sparse_threshold;
+    uint32_t precision;     // PopulationPrecision de f en el archivo
+    uint64_t f_offset;      // Q*stride float32 en el layout indicado (half si es PRECISION_FP16)
+    uint64_t f_bytes;
+    uint64_t fields_offset; // rho, ux, uy (width*height float32 cada uno)
+    uint64_t barrier_offset; // width*height uint8
+} CheckpointHeader;
+
+// Escribe el checkpoint en un temporal y lo renombra sobre 'path', así un
+// corte a mitad de escritura nunca deja un checkpoint roto.
+bool Checkpoint_Save(const SimulationState *state, const char *path);
+
+// Crea el estado (en lugar de Solver_Init) a partir de un checkpoint. En
+// POSIX f queda mapeada desde el archivo: las páginas se leen recién cuando
+// el primer paso las toca.
+bool Checkpoint_Load(SimulationState *state, const char *path);
+
+// Libera unas poblaciones mapeadas por Checkpoint_Load (uso interno del solver)
+void Checkpoint_Unmap(float *ptr, size_t bytes);
+
+#endif
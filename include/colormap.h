@@ -0,0 +1,28 @@
+#ifndef COLORMAP_H
+#define COLORMAP_H
+
+#include "sim_thread.h"
+
+// Paso de campo a color de la versión interactiva (sin raylib, para poder
+// medirlo aparte). Cada campo tiene su tabla de 256 colores y un rango fijo
+// relativo a la velocidad de entrada; las filas se reparten entre hilos
+// (OpenMP) y con AVX2 se colorean de a 8 celdas.
+
+typedef enum {
+    FIELD_SPEED,      // |u|, de 0 a 2 * inlet_velocity
+    FIELD_VORTICITY,  // dUy/dx - dUx/dy (diferencias centradas)
+    FIELD_DENSITY,    // rho alrededor de su media (fluido de toda la grilla)
+    FIELD_PRESSURE,   // p' = cs^2 (rho - media), mapa divergente
+    FIELD_COUNT
+} FieldKind;
+
+const char *Colormap_FieldName(FieldKind field);
+
+// Colorea los texels [tx0, tx1) x [ty0, ty1) de la grilla reducida por
+// 'factor' (cada texel promedia las celdas de fluido de un bloque de
+// factor x factor; es pared si la mayoría del bloque lo es). 'rgba' recibe
+// el rectángulo contiguo, 4 bytes por texel en orden R, G, B, A.
+void Colormap_Render(const FieldFrame *frame, FieldKind field, int factor,
+                     int tx0, int ty0, int tx1, int ty1, unsigned char *rgba);
+
+#endif
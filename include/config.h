@@ -0,0 +1,72 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdbool.h>
+#include "snapshot.h"
+#include "warmstart.h"
+
+// Parámetros de una corrida sin ventana (modo batch)
+typedef struct {
+    int scenario;          // SCENARIO_* de scenario.h
+    float omega;           // Parametro de relajacion
+    float inlet_velocity;  // Velocidad de entrada
+    int width;             // Tamaño de la grilla
+    int height;
+    int steps;             // Pasos totales a simular
+    int log_period;        // Métricas globales cada N pasos (0 = nunca)
+    int snapshot_period;   // Snapshot completo cada N pasos (0 = nunca)
+    bool snapshot_csv;     // Snapshots en texto (formato viejo) en vez de binario
+    SnapshotOptions snapshot; // Región, decimado, cuantización y compresión (binario)
+    int perf_period;       // Tiempo de proceso cada N pasos (0 = nunca)
+    int forces_period;     // Fuerzas sobre los obstáculos cada N pasos (0 = nunca)
+    int threads;           // Hilos del solver (0 = todos los núcleos)
+    int huge_pages;        // HugePageMode de arena.h (off | thp | explicit)
+    int layout;            // PopulationLayout (aos | soa)
+    int isa;               // SolverIsa máximo para LAYOUT_SOA (auto = el mejor)
+    float sparse_threshold; // Fracción de paredes para pasar a almacenamiento compacto
+    bool in_place;         // Propagación en el lugar (un solo arreglo de poblaciones)
+    int precision;         // PopulationPrecision (fp32 | fp16)
+    int block_depth;       // Pasos por barrido (bloqueo temporal, 1 = sin bloqueo)
+    int refine_levels;     // Niveles de refinamiento local alrededor de las paredes (0 = ninguno)
+    float converge_tol;    // Cortar cuando el residual baje de esto (0 = correr todos los pasos)
+    int converge_period;   // Cada cuántos pasos se mira el residual
+    WarmStartOptions warm_start; // Arranque en grillas gruesas (check_period = converge_period)
+    char probes_file[256]; // Configuración de sondas ("" = sin sondas, ver probes.h)
+    char probes_output[256];
+    int probe_period;      // Registro de sondas cada N pasos
+    char live_feed[64];    // Memoria compartida del feed en vivo ("" = sin feed, ver livefeed.h)
+    int live_period;       // Un cuadro cada N pasos
+    int live_frames;       // Cuadros del anillo
+    int profile_period;    // Resumen de tiempos por etapa cada N pasos (0 = nunca, ver profile.h)
+    char profile_trace[256]; // Traza de Chrome de las etapas ("" = sin traza)
+    bool profile_counters; // Contadores de hardware (perf_event_open) en el resumen
+    int checkpoint_period; // Checkpoint cada N pasos (0 = nunca)
+    char checkpoint_file[256];
+    char restart_file[256]; // Checkpoint desde el que retomar ("" = corrida nueva)
+} RunConfig;
+
+// Valores por defecto (los mismos que usa la versión interactiva)
+void Config_SetDefaults(RunConfig *cfg);
+
+// Lee un archivo "clave = valor" (las claves son las opciones largas sin "--").
+// Las líneas que empiezan con '#' son comentarios.
+bool Config_LoadFile(RunConfig *cfg, const char *path);
+
+// Procesa la línea de comandos. "--config archivo" se aplica en el orden
+// en que aparece, así las opciones posteriores pisan al archivo.
+bool Config_ParseArgs(RunConfig *cfg, int argc, char **argv);
+
+// Imprime la ayuda de las opciones
+void Config_PrintUsage(const char *program);
+
+// Entero en base 10 (el texto entero) no menor que 'minimum'
+bool Config_ParseInt(const char *text, int *out, int minimum);
+
+// Tamaño de grilla: "400" (cuadrada) o "800x200", cada lado de al menos 3
+bool Config_ParseSize(const char *text, int *width, int *height);
+
+// Primer múltiplo de 'period' después de 'step' (o 'limit' si es antes);
+// period <= 0 es un evento que no se da nunca
+int Config_NextEvent(int step, int period, int limit);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include "state.h"
+#include <mpi.h>
+
+// Solver distribuido con MPI (solo en HydroSimMPI). La grilla global se
+// parte en franjas de filas contiguas, una por proceso. Cada proceso guarda
+// sus filas más una fila fantasma por cada vecino (copia de la fila de borde
+// del otro proceso), así el kernel normal las lee como a cualquier vecino.
+// Por paso se mandan solo las 3 poblaciones que cruzan cada borde, mientras
+// se calculan las filas que no dependen de las fantasmas.
+// El resultado es idéntico bit a bit al de un solo proceso.
+typedef struct {
+    MPI_Comm comm;
+    int rank;
+    int size;
+    int global_width;
+    int global_height;
+    int y_offset;       // Primera fila global propia
+    int rows;           // Filas propias
+    int ghost_below;    // 1 si hay un proceso abajo (la fila local 0 es fantasma)
+    int ghost_above;    // 1 si hay un proceso arriba (la última fila local es fantasma)
+    SimulationState state; // Filas propias más las fantasmas (grilla densa, dos buffers)
+    float *send_below;  // Bordes empaquetados (3 * width poblaciones cada uno)
+    float *send_above;
+    float *recv_below;
+    float *recv_above;
+} DistributedSolver;
+
+// Reparte width x height entre los procesos de 'comm' (colectiva). Falla si
+// hay más procesos que filas. Después se puede ajustar d->state con
+// Solver_SetThreads / Solver_SetLayout / Solver_SetIsa; el almacenamiento
+// compacto, la propagación en el lugar, fp16 y el bloqueo temporal no se usan.
+bool Distributed_Init(DistributedSolver *d, MPI_Comm comm, int width, int height);
+
+// Escenario de scenario.h sobre la grilla global (cada proceso arma sus filas)
+void Distributed_InitScenario(DistributedSolver *d, int type);
+
+// Un paso en todos los procesos (colectiva)
+void Distributed_Step(DistributedSolver *d);
+
+// Métricas globales del último paso, en todos los procesos (colectiva). Con
+// Solver_RequestDiagnostics(&d->state) antes del paso se suman las que
+// acumuló cada solver; si no, se recorren las filas propias (residual 0).
+void Distributed_ReduceDiagnostics(DistributedSolver *d, SolverDiagnostics *out);
+
+// Snapshot binario de la grilla global (formato de snapshot.h). Cada proceso
+// escribe sus filas directo en su lugar del archivo con MPI-IO, sin juntar
+// la grilla en un solo proceso (colectiva).
+bool Distributed_WriteSnapshot(DistributedSolver *d, const char *filename, int time_step);
+
+void Distributed_Cleanup(DistributedSolver *d);
+
+#endif
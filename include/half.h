@@ -0,0 +1,65 @@
+#ifndef HALF_H
+#define HALF_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Conversión float <-> IEEE half (binario16) en software, con redondeo al par
+// más cercano: da los mismos bits que las instrucciones F16C / AVX-512
+// (_mm*_cvtps_ph con _MM_FROUND_TO_NEAREST_INT), así el kernel escalar y los
+// vectoriales coinciden.
+
+static inline uint16_t Half_FromFloat(float value) {
+    uint32_t x;
+    memcpy(&x, &value, sizeof(x));
+    uint32_t sign = (x >> 16) & 0x8000u;
+    uint32_t abs = x & 0x7fffffffu;
+
+    if (abs >= 0x7f800000u) return (uint16_t)(sign | 0x7c00u | (abs > 0x7f800000u ? 0x200u : 0u)); // inf / NaN
+    if (abs >= 0x477ff000u) return (uint16_t)(sign | 0x7c00u); // >= 65520: desborda a inf
+
+    if (abs < 0x38800000u) {
+        // Subnormal en half (< 2^-14): múltiplo de 2^-24
+        if (abs < 0x33000000u) return (uint16_t)sign; // < 2^-25 (o empate a 0)
+        uint32_t mant = (abs & 0x7fffffu) | 0x800000u;
+        uint32_t shift = 126u - (abs >> 23);
+        uint32_t r = mant >> shift;
+        uint32_t rem = mant & ((1u << shift) - 1u);
+        uint32_t halfway = 1u << (shift - 1u);
+        if (rem > halfway || (rem == halfway && (r & 1u))) r++;
+        return (uint16_t)(sign | r);
+    }
+
+    // Normal: se redondean los 13 bits que sobran (al par, sin ramas: el
+    // acarreo pasa solo al exponente) y se reajusta el exponente
+    uint32_t r = ((abs + 0x0fffu + ((abs >> 13) & 1u)) >> 13) - (112u << 10);
+    return (uint16_t)(sign | r);
+}
+
+static inline float Half_ToFloat(uint16_t h) {
+    uint32_t sign = (uint32_t)(h & 0x8000u) << 16;
+    uint32_t e = (h >> 10) & 0x1fu;
+    uint32_t m = h & 0x3ffu;
+    uint32_t x;
+
+    if (e == 0) {
+        if (m == 0) {
+            x = sign;
+        } else {
+            // Subnormal: se normaliza
+            e = 113;
+            while (!(m & 0x400u)) { m <<= 1; e--; }
+            x = sign | (e << 23) | ((m & 0x3ffu) << 13);
+        }
+    } else if (e == 31) {
+        x = sign | 0x7f800000u | (m << 13);
+    } else {
+        x = sign | ((e + 112u) << 23) | (m << 13);
+    }
+
+    float value;
+    memcpy(&value, &x, sizeof(value));
+    return value;
+}
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef LATTICE_H
+#define LATTICE_H
+
+#include "state.h"
+
+// Constantes LBM D2Q9
+static const float w[9] = {4.0/9, 1.0/9, 1.0/9, 1.0/9, 1.0/9, 1.0/36, 1.0/36, 1.0/36, 1.0/36};
+static const int cx[9] = {0, 1, 0, -1, 0, 1, -1, -1, 1};
+static const int cy[9] = {0, 0, 1, 0, -1, 1, 1, -1, -1};
+static const int opp[9] = {0, 3, 4, 1, 2, 7, 8, 5, 6}; // Dirección opuesta para rebote
+
+// Colisión BGK de una celda. 'fin' trae las poblaciones ya propagadas y sale
+// con las post-colisión; devuelve rho/ux/uy.
+// Las sumas van en un orden fijo (sin los términos cx=0/cy=0) para que los
+// kernels SIMD de solver_simd.c den exactamente los mismos bits.
+static inline void Lattice_Collide(float fin[Q], float omega, bool inlet, float inlet_velocity,
+                                   float *rho_out, float *ux_out, float *uy_out) {
+    // --- MACROSCOPIC (Calcular u y rho) ---
+    float rho = fin[0] + fin[1] + fin[2] + fin[3] + fin[4] + fin[5] + fin[6] + fin[7] + fin[8];
+    float ux = fin[1] - fin[3] + fin[5] - fin[6] - fin[7] + fin[8];
+    float uy = fin[2] - fin[4] + fin[5] + fin[6] - fin[7] - fin[8];
+
+    // Normalizar velocidad
+    if (rho > 0) {
+        ux /= rho;
+        uy /= rho;
+    }
+
+    // --- INLET (Viento desde la izquierda) ---
+    if (inlet) {
+        ux = inlet_velocity; // Velocidad de entrada
+        uy = 0.0f;
+        rho = 1.0f;
+    }
+
+    *rho_out = rho;
+    *ux_out = ux;
+    *uy_out = uy;
+
+    // --- COLLISION (Relajación al equilibrio) ---
+    float usq = 1.5f * (ux*ux + uy*uy);
+    for (int k = 0; k < Q; k++) {
+        float cu = 3.0f * (cx[k]*ux + cy[k]*uy);
+        float f_eq = w[k] * rho * (1.0f + cu + 0.5f*(cu*cu) - usq);
+        fin[k] = (1.0f - omega) * fin[k] + omega * f_eq;
+    }
+}
+
+#endif
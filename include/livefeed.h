@@ -0,0 +1,82 @@
+#ifndef LIVEFEED_H
+#define LIVEFEED_H
+
+#include "state.h"
+#include <stdint.h>
+
+// Transmisión en vivo por memoria compartida (POSIX shm_open): cada tantos
+// pasos el solver copia rho, ux, uy, barrier y las métricas globales a un
+// anillo de cuadros que otro proceso del mismo equipo mapea sin copiar (en
+// Python, python/livefeed.py los ve como arrays de NumPy). El solver nunca
+// espera a los lectores: escribe en el cuadro siguiente del anillo aunque
+// alguien lo esté leyendo, y cada cuadro lleva un contador tipo seqlock para
+// que el lector sepa si lo que leyó quedó entero.
+//
+// Segmento (little-endian, en el orden de la máquina):
+//   LiveFeedHeader (header_size bytes)
+//   num_frames cuadros de frame_bytes bytes, cada uno:
+//     LiveFrameHeader
+//     rho[height][width], ux, uy  float32, a plane_bytes uno de otro
+//     barrier[height][width]       uint8 (0/1), después de uy
+//
+// Protocolo: el cuadro n va en el lugar n % num_frames. Mientras se escribe
+// su 'sequence' vale 2n+1 y al terminar 2n+2; después se pone
+// published = n+1. El lector toma n = published-1, lee sequence (par y igual
+// a 2n+2), usa los datos y vuelve a leer sequence: si cambió, el solver ya
+// pisó ese lugar y hay que descartar lo leído. Con num_frames cuadros un
+// lector tiene num_frames-1 publicaciones de margen.
+#define LIVEFEED_MAGIC "HLIV"
+#define LIVEFEED_VERSION 1
+#define LIVEFEED_MAX_FRAMES 64
+
+typedef struct {
+    char magic[4];          // "HLIV" (se escribe al final, con todo armado)
+    uint32_t version;       // LIVEFEED_VERSION
+    uint32_t header_size;   // Bytes hasta el primer cuadro
+    uint32_t frame_header_size; // Bytes de LiveFrameHeader (los planos van después)
+    int32_t width;
+    int32_t height;
+    int32_t num_frames;
+    int32_t period;         // Pasos entre cuadros
+    uint64_t frame_bytes;   // Separación entre cuadros
+    uint64_t plane_bytes;   // Separación entre planos (múltiplo de 64)
+    int32_t writer_pid;
+    uint32_t closed;        // Atómico: 1 = la corrida terminó
+    uint64_t published;     // Atómico: cuadros publicados (0 = ninguno todavía)
+    uint32_t reserved[16];
+} LiveFeedHeader;
+
+typedef struct {
+    uint64_t sequence;      // Atómico: 2n+1 escribiendo el cuadro n, 2n+2 listo
+    int32_t step;
+    float omega;
+    float inlet_velocity;
+    float max_velocity;     // Métricas de Solver_RequestDiagnostics; NaN si
+    double mass;            // no se pidieron para este paso
+    double kinetic_energy;
+    double residual;
+    double fx, fy;          // Fuerza sobre las paredes y sus coeficientes
+    double cd, cl;
+    uint32_t reserved[12];
+} LiveFrameHeader;
+
+typedef struct LiveFeed LiveFeed;
+
+// Crea (o reemplaza) el segmento 'name' ("hydrosim" -> /hydrosim, en Linux
+// /dev/shm/hydrosim) para una grilla de width x height. NULL si no se pudo
+// o si el sistema no tiene memoria compartida POSIX (el motivo va a stderr).
+LiveFeed *LiveFeed_Create(const char *name, int width, int height, int num_frames, int period);
+
+// Publica el paso si es múltiplo del período (si no, no hace nada). Las
+// métricas salen de state->diagnostics si son de este paso.
+void LiveFeed_Publish(LiveFeed *feed, const SimulationState *state, int time_step);
+
+// Indica si LiveFeed_Publish va a publicar este paso (para pedir antes
+// Solver_RequestDiagnostics)
+bool LiveFeed_Due(const LiveFeed *feed, int time_step);
+
+// Marca el segmento como cerrado, lo desmapea y borra el nombre (los
+// lectores que ya lo tienen mapeado lo siguen viendo)
+void LiveFeed_Destroy(LiveFeed *feed);
+
+#endif
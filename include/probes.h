@@ -0,0 +1,66 @@
+#ifndef PROBES_H
+#define PROBES_H
+
+#include "state.h"
+#include <stdint.h>
+
+// Sondas: series de tiempo de rho/ux/uy en unas pocas celdas en lugar de
+// snapshots completos. Se configuran con un archivo de texto, una sonda por
+// línea ('#' = comentario, coordenadas de celda, extremos incluidos):
+//   point NOMBRE x y
+//   line  NOMBRE x0 y0 x1 y1 [n]   n puntos equiespaciados (por defecto uno por celda)
+//   rect  NOMBRE x0 y0 x1 y1       todas las celdas del rectángulo, fila por fila
+//
+// Formato del archivo de salida (little-endian, python/probes.py):
+//   ProbeFileHeader
+//   ProbeInfo[num_probes]
+//   int32 x[num_cells], int32 y[num_cells]   celdas de todas las sondas seguidas
+//   registros: int32 step, float32 rho[num_cells], ux[num_cells], uy[num_cells]
+#define PROBES_MAGIC "HPRB"
+#define PROBES_VERSION 1
+#define PROBE_NAME_SIZE 32
+
+typedef enum {
+    PROBE_POINT = 0,
+    PROBE_LINE = 1,
+    PROBE_RECT = 2
+} ProbeType;
+
+typedef struct {
+    char magic[4];          // "HPRB"
+    uint32_t version;       // PROBES_VERSION
+    uint32_t header_size;   // Bytes hasta el primer registro (cabecera + tablas)
+    int32_t width;
+    int32_t height;
+    int32_t period;         // Pasos entre registros
+    int32_t num_probes;
+    int32_t num_cells;
+    uint32_t reserved[8];
+} ProbeFileHeader;
+
+typedef struct {
+    char name[PROBE_NAME_SIZE];
+    int32_t type;           // ProbeType
+    int32_t x0, y0, x1, y1;
+    int32_t offset;         // Primera celda de la sonda en la lista de celdas
+    int32_t count;          // Celdas de la sonda
+} ProbeInfo;
+
+// Los registros se juntan en bloques preasignados (~1 MB) que escribe un hilo
+// aparte, igual que los snapshots; el solver solo espera si todos los bloques
+// siguen pendientes. Sin soporte de hilos (web) se escribe en el momento.
+typedef struct ProbeRecorder ProbeRecorder;
+
+// Lee la configuración y abre 'output_file'. Con 'append' (corrida retomada)
+// sigue agregando registros si el archivo existente tiene las mismas sondas.
+// NULL si la configuración no es válida (el error va a stderr).
+ProbeRecorder *Probes_Create(const char *config_file, const char *output_file,
+                             int period, int width, int height, bool append);
+
+// Registra el paso si es múltiplo del período (si no, no hace nada)
+void Probes_Record(ProbeRecorder *probes, const SimulationState *state, int time_step);
+
+// Escribe lo pendiente, cierra el archivo y libera todo
+void Probes_Destroy(ProbeRecorder *probes);
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "timer.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <x86intrin.h>
+#endif
+
+// Instrumentación de las etapas del camino caliente. Cada hilo acumula en su
+// propio registro (se crea la primera vez que mide algo) el tiempo, las
+// llamadas y los elementos procesados de cada etapa; Profile_Summary junta
+// todos los hilos y muestra lo ocurrido desde el resumen anterior. Las
+// etapas largas también se guardan como eventos para la traza de Chrome
+// (chrome://tracing o ui.perfetto.dev). Desactivado, medir cuesta una rama.
+typedef enum {
+    PROF_STEP,           // Parte de cada hilo de un paso (o barrido con bloqueo temporal)
+    PROF_INTERIOR,       // Stream + collide de los tramos interiores (van fusionados)
+    PROF_BOUNDARY,       // Celdas de frontera (rebote, entrada y salida)
+    PROF_GEOMETRY,       // Reconstrucción de enlaces tras editar paredes
+    PROF_REFINE,         // Interfaces entre niveles del refinamiento local
+    PROF_ANALYSIS,       // Reducciones y log de métricas globales
+    PROF_FORCES,         // Intercambio de momento y log de fuerzas
+    PROF_PROBES,
+    PROF_SNAPSHOT_COPY,  // Copia de los campos al buffer del escritor
+    PROF_SNAPSHOT_WRITE, // Codificación y escritura (hilo del escritor)
+    PROF_CHECKPOINT,
+    PROF_LIVE,           // Copia al feed en vivo (memoria compartida)
+    PROF_PUBLISH,        // Copia del cuadro para la interfaz
+    PROF_COLORMAP,
+    PROF_UPLOAD,         // Subida de la textura a la GPU
+    PROF_PHASE_COUNT
+} ProfilePhase;
+
+// Se activa con Profile_Init; antes de eso no se mide nada
+extern bool profile_enabled;
+
+// Reloj de las mediciones: contador de ciclos en x86, nanosegundos si no
+static inline uint64_t Profile_Ticks(void) {
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    return __rdtsc();
+#else
+    return (uint64_t)(Timer_Now() * 1e9);
+#endif
+}
+
+// Intervalo [start, end) de la etapa en el hilo actual, con 'items'
+// elementos procesados (celdas, bytes; 0 si no aplica)
+void Profile_Record(ProfilePhase phase, uint64_t start, uint64_t end, uint64_t items);
+
+// Solo suma al total (para etapas que se miden de a pedacitos, sin evento)
+void Profile_Add(ProfilePhase phase, uint64_t ticks, uint64_t items);
+
+// Uso: uint64_t t = Profile_Begin(); ...; Profile_End(PROF_X, t);
+static inline uint64_t Profile_Begin(void) {
+    return profile_enabled ? Profile_Ticks() : 0;
+}
+
+static inline void Profile_EndItems(ProfilePhase phase, uint64_t start, uint64_t items) {
+    if (start != 0) Profile_Record(phase, start, Profile_Ticks(), items);
+}
+
+static inline void Profile_End(ProfilePhase phase, uint64_t start) {
+    Profile_EndItems(phase, start, 0);
+}
+
+// Activa la medición. 'trace_file' ("" o NULL = sin traza) se escribe en
+// Profile_Shutdown. 'counters' abre contadores de hardware por hilo
+// (perf_event_open: ciclos, instrucciones y fallos del último nivel de
+// caché, de donde sale el ancho de banda estimado); si el sistema no los
+// permite se sigue sin ellos.
+void Profile_Init(const char *trace_file, bool counters);
+
+// Nombre del hilo actual en el resumen y la traza
+void Profile_NameThread(const char *name);
+
+// Tabla por etapa desde el resumen anterior (o desde Profile_Init)
+void Profile_Summary(FILE *out, int time_step);
+
+// Escribe la traza y libera todo (con los hilos medidos ya terminados)
+void Profile_Shutdown(void);
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef REFINE_H
+#define REFINE_H
+
+#include "state.h"
+
+// Refinamiento local por bloques anidados. La grilla base cubre todo el
+// dominio (el campo lejano); cada bloque es una grilla propia con el doble de
+// resolución que su padre, que da dos pasos por cada paso del padre (dx y dt
+// a la mitad, misma velocidad en unidades de la grilla). Omega se ajusta en
+// cada nivel para mantener la viscosidad: tau_hijo = 2 tau_padre - 1/2.
+//
+// Acople entre niveles:
+//  - Padre -> hijo: el anillo exterior de celdas del bloque (fantasmas) se
+//    rearma antes de cada subpaso con rho, u y el tensor de deformación del
+//    padre, interpolados en espacio (bilineal) y en tiempo (lineal entre el
+//    paso anterior y el actual del padre). Las poblaciones salen del
+//    equilibrio más la parte de no equilibrio reescalada al tau del hijo.
+//  - Hijo -> padre: después de los dos subpasos, las celdas del padre
+//    cubiertas por el bloque (menos REFINE_OVERLAP en el borde) toman el
+//    promedio de sus 4 celdas finas con la misma reconstrucción. En cada
+//    paso alcanza con el contorno de esa zona; al final de Refine_Advance se
+//    pisan todas, así los campos de la base muestran lo de los bloques.
+//
+// La grilla base es el SimulationState de siempre (snapshots, sondas y
+// métricas la siguen usando, con los valores del bloque donde lo hay). Tiene
+// que ser densa, en float y con dos buffers; los bloques usan su mismo layout.
+#define REFINE_MAX_LEVELS 4
+#define REFINE_OVERLAP 2 // Celdas del padre en el borde del bloque que no se pisan
+
+typedef struct {
+    SimulationState state; // Grilla del bloque (2 w x 2 h celdas)
+    int parent;            // Bloque padre (-1 = grilla base)
+    int level;             // 1 = hijo de la base
+    int x0, y0, w, h;      // Región que cubre, en celdas del padre
+    // Valores del padre alrededor del borde: rho, ux, uy, sxx, sxy, syy por
+    // celda de [x0-1, x0+w] x [y0-1, y0+h], en el paso anterior y el actual
+    float *previous;
+    float *current;
+} RefineBlock;
+
+typedef struct {
+    SimulationState *base;
+    RefineBlock blocks[REFINE_MAX_LEVELS];
+    int num_blocks;
+} RefinedGrid;
+
+// Arma 'levels' bloques anidados alrededor de las paredes de la base y de su
+// estela (se ubican solos a partir de la caja que contiene las paredes) y los
+// inicializa interpolando el estado actual de la base (p.ej. el que dejó el
+// arranque en grillas gruesas). Las paredes de cada bloque se dibujan con el
+// escenario a su resolución, o con SCENARIO_NONE se copian de las del padre.
+// Los checkpoints guardan solo la base, así que no sirven para retomar una
+// corrida con bloques. Devuelve false (con el motivo por stderr) si la
+// base no tiene paredes, es muy chica o usa un modo no compatible.
+bool Refine_Init(RefinedGrid *grid, SimulationState *base, int levels, int scenario);
+
+// 'steps' pasos de la base, con los subpasos de todos los bloques. Si se
+// pidieron métricas (Solver_RequestDiagnostics) quedan las del último paso.
+void Refine_Advance(RefinedGrid *grid, int steps);
+
+// Bloque más fino (donde están las paredes: de ahí salen las fuerzas) y
+// cuántas celdas suyas hay por celda de la base en cada dirección
+const SimulationState *Refine_Finest(const RefinedGrid *grid, int *scale);
+
+// Celdas actualizadas por cada paso de la base (contando los subpasos)
+double Refine_CellUpdates(const RefinedGrid *grid);
+
+void Refine_Cleanup(RefinedGrid *grid);
+
+// Llena toda la grilla 'fine' (más fina, misma región) interpolando rho, u y
+// la deformación de 'coarse', con la misma reconstrucción que los bordes de
+// los bloques y el omega de 'fine'. Pisa f (grilla densa, float, dos
+// buffers) y los campos; las paredes de 'fine' quedan como estaban.
+void Refine_Prolong(const SimulationState *coarse, SimulationState *fine);
+
+#endif
@@ -2,17 +2,31 @@
 #define RENDERER_H
 
 #include "raylib.h"
-#include "state.h"
+#include "sim_thread.h"
+#include "colormap.h"
 
 typedef struct {
     Texture2D texture;
     Image image;
     Color *pixels;
+    int grid_width;
+    int grid_height;
+    // Cada texel cubre factor x factor celdas: si la grilla tiene más celdas
+    // que píxeles la ventana, se reduce en CPU antes de subirla (0 = sin textura)
+    int factor;
+    FieldKind field;
+    // Zona visible: zoom 1 = grilla entera; (view_x, view_y) es la esquina
+    // superior izquierda en celdas. Solo se colorea y sube esa parte.
+    float zoom;
+    float view_x;
+    float view_y;
 } RenderContext;
 
-void Renderer_Init(RenderContext *ctx);
-void Renderer_HandleInput(SimulationState *state);
-void Renderer_Draw(RenderContext *ctx, SimulationState *state);
+void Renderer_Init(RenderContext *ctx, int width, int height);
+// Los clics se mandan al hilo del solver como comandos SIM_CMD_PAINT.
+// [F] cambia el campo, rueda = zoom, clic derecho = mover, [Z] = vista entera.
+void Renderer_HandleInput(RenderContext *ctx, SimThread *sim);
+void Renderer_Draw(RenderContext *ctx, const FieldFrame *frame);
 void Renderer_Cleanup(RenderContext *ctx);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,35 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "state.h"
+
+// Escenarios predefinidos (teclas 1/2/3 en la ventana, --scenario en modo batch)
+#define SCENARIO_NONE   0
+#define SCENARIO_CIRCLE 1
+#define SCENARIO_SQUARE 2
+#define SCENARIO_WALL   3
+
+// Nombre de un escenario ("none", "circle", "square", "wall")
+const char *ScenarioName(int type);
+
+// Escenario a partir de su nombre; false si no es ninguno de los de arriba
+bool ParseScenarioName(const char *text, int *type);
+
+// Borra todas las barreras
+void ResetBarriers(SimulationState *state);
+
+// Dibuja uno de los obstáculos predefinidos (borra los anteriores)
+void InitScenario(SimulationState *state, int type);
+
+// Ídem para un tramo de filas de una grilla más alta (modo distribuido): la
+// fila local 0 es la fila y_offset de una grilla de global_height filas
+void InitScenarioRows(SimulationState *state, int type, int global_height, int y_offset);
+
+// Ídem a otra resolución (refinamiento local): el obstáculo es el de una
+// grilla base de base_width x base_height dibujado con 'scale' celdas por
+// celda base, y la celda (0, 0) del estado es la (x_offset, y_offset) de esa
+// grilla más fina. Con scale = 1 da lo mismo que InitScenarioRows.
+void InitScenarioRegion(SimulationState *state, int type, int base_width, int base_height,
+                        int scale, int x_offset, int y_offset);
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef SIM_THREAD_H
+#define SIM_THREAD_H
+
+#include "state.h"
+#include "snapshot.h"
+#include "probes.h"
+#include "livefeed.h"
+
+// Solver en un hilo propio para la versión interactiva. El hilo da todos los
+// pasos que puede (métricas, snapshots y checkpoints incluidos) y publica los
+// campos macroscópicos en un triple buffer sin locks: la interfaz siempre
+// lee el último cuadro completo y ninguno de los dos espera al otro. Los
+// cambios de la interfaz (paredes, escenarios, omega, pausa) llegan por una
+// cola de comandos y se aplican entre pasos. Sin pthreads (web, Windows) los
+// pasos se dan dentro de SimThread_AcquireFrame, como antes.
+
+// Copia de los campos para dibujar
+typedef struct {
+    int width;
+    int height;
+    int time_step;
+    bool running;
+    float omega;
+    float inlet_velocity;
+    double mlups;    // Ritmo del solver desde el cuadro anterior (0 en pausa)
+    float drag;      // Cd y Cl sobre las paredes (ver Analysis_ForceCoefficients)
+    float lift;
+    float *rho;
+    float *ux;
+    float *uy;
+    bool *barrier;
+} FieldFrame;
+
+typedef enum {
+    SIM_CMD_RUN,             // value: 1 = correr, 0 = pausa
+    SIM_CMD_PAINT,           // Pincel de pared de 3x3 centrado en (x, y)
+    SIM_CMD_SCENARIO,        // value: SCENARIO_*
+    SIM_CMD_CLEAR,           // Borra todas las paredes
+    SIM_CMD_OMEGA,           // number
+    SIM_CMD_VELOCITY,        // number
+    SIM_CMD_SNAPSHOT_PERIOD  // value
+} SimCommandType;
+
+typedef struct {
+    int type;       // SimCommandType
+    int x, y;
+    int value;
+    float number;
+} SimCommand;
+
+// Cola de un solo productor (interfaz) y un solo consumidor (solver)
+#define SIM_QUEUE_SIZE 1024
+
+typedef struct SimThread SimThread;
+
+// Toma el estado (ya armado) y arranca el hilo. Desde acá la interfaz no
+// toca 'state' hasta SimThread_Stop. 'snapshots' NULL = snapshots en CSV.
+// Con forces_period > 0 se agrega a forces_log.csv (ya abierto con
+// Analysis_InitForcesLog) cada tantos pasos. 'probes' y 'live' (feed en
+// memoria compartida) pueden ser NULL. Con profile_period > 0 se muestra
+// el resumen de Profile_Summary cada tantos pasos.
+SimThread *SimThread_Start(SimulationState *state, SnapshotWriter *snapshots, int snapshot_period,
+                           int forces_period, ProbeRecorder *probes, LiveFeed *live,
+                           int profile_period, int checkpoint_period, const char *checkpoint_file);
+
+// Encola un comando; false si la cola está llena (se descarta)
+bool SimThread_Send(SimThread *sim, SimCommand command);
+
+// Último cuadro publicado (válido hasta la próxima llamada)
+const FieldFrame *SimThread_AcquireFrame(SimThread *sim);
+
+// Termina el hilo (aplica los comandos pendientes) y libera los cuadros
+void SimThread_Stop(SimThread *sim);
+
+#endif
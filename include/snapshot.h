@@ -0,0 +1,89 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "state.h"
+#include <stdint.h>
+
+// Formato binario de snapshot (little-endian). Cabecera de tamaño fijo
+// seguida de los planos, fila por fila (y, después x):
+//   rho[height][width]  float32 (o entero cuantizado, ver quant_bits)
+//   ux [height][width]
+//   uy [height][width]
+//   barrier[height][width] uint8 (0/1)
+// width x height es lo guardado: la región (roi_x0, roi_y0) de la grilla
+// completa tomando una celda de cada 'stride'. Con compresión cada plano
+// ocupa planes[p].bytes. Con todo por defecto (ceros) los planos van
+// completos en float32, como en la versión 1.
+// python/snapshot.py lo lee directamente a arrays de NumPy.
+#define SNAPSHOT_MAGIC "HSNP"
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_PLANES 4
+
+typedef enum {
+    SNAPSHOT_RAW = 0,
+    SNAPSHOT_ZLIB = 1   // zlib (nivel rápido), si se compiló con zlib
+} SnapshotCompression;
+
+typedef struct {
+    uint64_t bytes;         // Bytes del plano en el archivo (0 = sin comprimir)
+    float offset;           // Cuantizado: valor = offset + q * scale
+    float scale;
+} SnapshotPlane;
+
+typedef struct {
+    char magic[4];          // "HSNP"
+    uint32_t version;       // SNAPSHOT_VERSION
+    uint32_t header_size;   // Bytes hasta el primer plano (para poder extender la cabecera)
+    int32_t width;          // Celdas guardadas por fila
+    int32_t height;         // Filas guardadas
+    int32_t step;           // Paso de tiempo
+    float omega;
+    float inlet_velocity;
+    int32_t grid_width;     // Grilla completa (0 = la misma que width x height)
+    int32_t grid_height;
+    int32_t roi_x0;         // Celda de la grilla completa de la primera guardada
+    int32_t roi_y0;
+    int32_t stride;         // Una celda de cada 'stride' en cada eje (0 = 1)
+    int32_t quant_bits;     // 0 = float32; 16 u 8 = enteros sin signo
+    int32_t compression;    // SnapshotCompression
+    int32_t shuffle;        // 1: bytes de los valores agrupados antes de comprimir
+    SnapshotPlane planes[SNAPSHOT_PLANES]; // rho, ux, uy, barrier
+    uint32_t reserved[4];
+} SnapshotHeader;
+
+// Qué y cómo guardar de cada snapshot
+typedef struct {
+    int stride;             // Decimado (1 = todas las celdas)
+    int roi_x0, roi_y0;     // Región [x0, x1) x [y0, y1); x1 o y1 <= 0 = hasta el borde
+    int roi_x1, roi_y1;
+    int quant_bits;         // 32 (float), 16 u 8
+    int compression;        // SnapshotCompression
+} SnapshotOptions;
+
+// Grilla completa, float32, sin comprimir
+void Snapshot_DefaultOptions(SnapshotOptions *options);
+
+// Escritor con un hilo de fondo: Snapshot_Submit copia los campos a uno de
+// dos buffers y vuelve enseguida; el hilo escribe el archivo. Solo espera si
+// los dos buffers siguen pendientes (disco más lento que los snapshots).
+// Sin soporte de hilos (p.ej. web) escribe en el momento.
+typedef struct SnapshotWriter SnapshotWriter;
+
+// 'prefix' se antepone al nombre (p.ej. "salida/" -> salida/snapshot_00100.bin).
+// 'options' NULL = Snapshot_DefaultOptions. La región se recorta a la grilla
+// de cada snapshot; la cuantización y la compresión se hacen en el hilo de
+// escritura, un plano por hilo de OpenMP.
+SnapshotWriter *Snapshot_CreateWriter(const char *prefix, const SnapshotOptions *options);
+
+// Entrega el estado actual para escribirlo como snapshot_<step>.bin
+void Snapshot_Submit(SnapshotWriter *writer, const SimulationState *state, int time_step);
+
+// Espera a que se escriban los pendientes, termina el hilo y libera todo
+void Snapshot_DestroyWriter(SnapshotWriter *writer);
+
+// Escritura directa (sin hilo) de planos completos en float32, sin comprimir
+bool Snapshot_WriteFile(const char *filename, const SnapshotHeader *header,
+                        const float *rho, const float *ux, const float *uy,
+                        const unsigned char *barrier);
+
+#endif
@@ -3,10 +3,75 @@
 
 #include "state.h"
 
-void Solver_Init(SimulationState *state);
+// Reserva una grilla de width x height celdas con fluido en reposo
+void Solver_Init(SimulationState *state, int width, int height);
 void Solver_Step(SimulationState *state);
 void Solver_Cleanup(SimulationState *state);
 
+// Hilos de trabajo para Solver_Step (bandas de filas). 0 = todos los núcleos.
+// Sin OpenMP el solver es siempre serial.
+void Solver_SetThreads(SimulationState *state, int num_threads);
 
+// Cambia el orden de las poblaciones en memoria (reordena f y new_f).
+// LAYOUT_SOA elige el mejor kernel SIMD que soporte la CPU.
+void Solver_SetLayout(SimulationState *state, PopulationLayout layout);
+
+// Fuerza un kernel (p.ej. ISA_SCALAR para comparar). Se limita a lo que
+// soporte la CPU; devuelve el que quedó activo.
+SolverIsa Solver_SetIsa(SimulationState *state, SolverIsa isa);
+
+// Mejor set de instrucciones disponible en esta CPU
+SolverIsa Solver_DetectIsa(void);
+
+// Con una fracción de paredes >= solid_fraction el solver guarda solo las
+// celdas de fluido (almacenamiento compacto con tabla de vecinos); por debajo
+// usa la grilla densa. Se reevalúa cada vez que cambia barrier. > 1 = nunca.
+#define SOLVER_DEFAULT_SPARSE_THRESHOLD 0.4f
+void Solver_SetSparseThreshold(SimulationState *state, float solid_fraction);
+
+// Usa una geometría ajena (de solo lectura, width*height celdas) en lugar
+// de la propia, p.ej. la misma para todas las corridas de un barrido. No se
+// libera en Solver_Cleanup: tiene que vivir más que el estado.
+void Solver_ShareBarrier(SimulationState *state, bool *barrier);
+
+// Propagación en el lugar (patrón AA): un solo arreglo de poblaciones en vez
+// de f/new_f, la mitad de memoria. Mismos resultados que el modo normal.
+// Usa siempre la grilla densa (ignora sparse_threshold) y no se combina con
+// el bloqueo temporal.
+void Solver_SetInPlace(SimulationState *state, bool in_place);
+
+// Poblaciones en 16 bits (PRECISION_FP16): la mitad de memoria y de tráfico,
+// con ~3-4 cifras significativas. Pasa a LAYOUT_SOA y grilla densa; no se
+// combina con la propagación en el lugar (cada modo apaga al otro).
+void Solver_SetPrecision(SimulationState *state, PopulationPrecision precision);
+
+// Avanza 'steps' pasos. Con bloqueo temporal (depth > 1) cada barrido sobre
+// la grilla hace 'depth' pasos seguidos fila por fila, mientras las filas
+// siguen en caché. El resultado es idéntico a llamar Solver_Step 'steps' veces.
+void Solver_Advance(SimulationState *state, int steps);
+void Solver_SetTemporalBlocking(SimulationState *state, int depth);
+
+// Pide que el próximo Solver_Step acumule masa, energía, velocidad máxima y
+// residual en state->diagnostics mientras recorre la grilla (sumas parciales
+// por hilo, sin una segunda pasada sobre rho/ux/uy).
+void Solver_RequestDiagnostics(SimulationState *state);
+
+// Fuerza total del fluido sobre las paredes (en unidades de la grilla) por
+// intercambio de momento en los enlaces de rebote, con las poblaciones del
+// último paso. Recorre solo state->wall_links, así que se puede pedir en
+// cada paso sin costo apreciable.
+void Solver_ComputeForces(const SimulationState *state, double *fx, double *fy);
+
+// Solver_Step por partes, para quien necesita intercalar trabajo entre las
+// filas (p.ej. el intercambio de bordes del modo distribuido): BeginStep,
+// StepRange sobre cada grupo de filas (cada fila una sola vez por paso,
+// repartida en bandas entre los hilos) y EndStep. Solo para el modo normal
+// de dos buffers, sin bloqueo temporal.
+void Solver_BeginStep(SimulationState *state);
+void Solver_StepRange(SimulationState *state, int y0, int y1);
+void Solver_EndStep(SimulationState *state);
+
+// Nombre legible ("scalar", "avx2", "avx512")
+const char *Solver_IsaName(SolverIsa isa);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,93 @@
+#ifndef SOLVER_INTERNAL_H
+#define SOLVER_INTERNAL_H
+
+// Piezas compartidas entre los archivos del solver (solver*.c). No es API pública.
+
+#include "state.h"
+#include <stddef.h>
+
+// Para las versiones especializadas de los kernels (ver StepRows en solver.c)
+#if defined(__GNUC__)
+#define SOLVER_INLINE static inline __attribute__((always_inline))
+#else
+#define SOLVER_INLINE static inline
+#endif
+
+// Arrays de poblaciones alineados a 64 bytes (liberar con Solver_FreePopulations)
+float *Solver_AllocPopulations(size_t count);
+void Solver_FreePopulations(float *ptr);
+
+// Libera f o new_f del estado, sea memoria propia o mapeada desde un checkpoint
+void Solver_ReleasePopulations(SimulationState *state, float *ptr);
+
+// Todo lo de Solver_Init salvo f/new_f (quedan en NULL para que los ponga quien llama)
+void Solver_InitFields(SimulationState *state, int width, int height);
+
+// Separación entre planos para una grilla densa de N celdas
+static inline int Solver_DenseStride(int layout, int N) {
+    // Planos rellenados a múltiplo de 16 floats: cada uno empieza alineado a 64 bytes
+    return layout == LAYOUT_SOA ? (N + 15) & ~15 : N;
+}
+
+// Posición de la población k de la celda i en la grilla densa según el layout
+static inline size_t PopIndex(const SimulationState *state, int i, int k) {
+    return state->layout == LAYOUT_SOA ? (size_t)k * state->stride + i
+                                       : (size_t)i * Q + k;
+}
+
+// --- solver_sparse.c: almacenamiento compacto de solo las celdas de fluido ---
+
+// Pasa a (o rearma) el almacenamiento compacto según el barrier actual
+void SolverSparse_Build(SimulationState *state);
+
+// Vuelve a la grilla densa en el layout de state->layout
+void SolverSparse_ToDense(SimulationState *state);
+
+// Stream + collide de las celdas de fluido de las filas [y0, y1)
+void SolverSparse_StepRows(SimulationState *state, int y0, int y1);
+
+// Libera las tablas (no las poblaciones, que son state->f/new_f)
+void SolverSparse_Free(SparseLattice *sparse);
+
+// --- solver_half.c: poblaciones en half (PRECISION_FP16) ---
+
+// En half se guarda (f - w[k]) * HALF_SCALE. Al ser potencia de 2 la escala
+// no redondea, y corre los desvíos chicos fuera del rango subnormal del half
+// (que además es lento de convertir en hardware).
+#define HALF_SCALE 1024.0f
+#define HALF_INV_SCALE (1.0f / 1024.0f)
+
+// Convierte f/new_f a half (pasa a SoA y grilla densa) y los libera
+void SolverHalf_Enter(SimulationState *state);
+
+// Vuelve a float
+void SolverHalf_Leave(SimulationState *state);
+
+// Reserva / libera f_half y new_f_half (Q*stride cada uno)
+void SolverHalf_Alloc(SimulationState *state);
+void SolverHalf_Free(SimulationState *state);
+
+// f en float (mismo orden que f_half) sin tocar el estado
+void SolverHalf_Export(const SimulationState *state, float *out);
+
+// Stream + collide de las filas [y0, y1)
+void SolverHalf_StepRows(SimulationState *state, int y0, int y1);
+
+// --- solver_inplace.c: propagación en el lugar (patrón AA) ---
+
+// Pasa f al formato del patrón AA y libera new_f (vuelve a la grilla densa)
+void SolverInPlace_Enter(SimulationState *state);
+
+// Vuelve a f/new_f con el formato normal
+void SolverInPlace_Leave(SimulationState *state);
+
+// Deja f en la fase 1 (antes de cambiar la geometría)
+void SolverInPlace_Normalize(SimulationState *state);
+
+// Poblaciones en el formato normal (post-colisión, f[x][k]) sin tocar el estado
+void SolverInPlace_Canonical(const SimulationState *state, float *out);
+
+// Un paso de las filas [y0, y1) en la fase state->aa_phase
+void SolverInPlace_StepRows(SimulationState *state, int y0, int y1);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef SOLVER_SIMD_H
+#define SOLVER_SIMD_H
+
+#include "state.h"
+
+// Kernels vectoriales de stream-collide para LAYOUT_SOA (uso interno de solver.c).
+// Procesan un tramo [i0, i1) de celdas interiores (fluido rodeado de fluido,
+// ver BoundaryLinks) en bloques completos de 8/16 celdas, sin máscaras ni
+// chequeos, y devuelven la primera celda que quedó sin procesar (el resto lo
+// hace el kernel escalar).
+int SolverSimd_InteriorAVX2(SimulationState *state, int i0, int i1);
+int SolverSimd_InteriorAVX512(SimulationState *state, int i0, int i1);
+
+// Ídem con propagación en el lugar (patrón AA, un solo arreglo f): 'odd'
+// indica la fase que propaga (ver solver_inplace.c)
+int SolverSimd_InPlaceAVX2(SimulationState *state, int i0, int i1, bool odd);
+int SolverSimd_InPlaceAVX512(SimulationState *state, int i0, int i1, bool odd);
+
+// Ídem con las poblaciones en half (f_half/new_f_half, ver solver_half.c).
+// La versión AVX2 necesita además F16C.
+int SolverSimd_HalfAVX2(SimulationState *state, int i0, int i1);
+int SolverSimd_HalfAVX512(SimulationState *state, int i0, int i1);
+
+// Ídem para el almacenamiento compacto: celdas de fluido [j0, j1) de la misma
+// fila sin inlet, con las poblaciones leídas por gather según sparse_lattice.src.
+int SolverSimd_SparseAVX2(SimulationState *state, int j0, int j1);
+int SolverSimd_SparseAVX512(SimulationState *state, int j0, int j1);
+
+// Soporte de la CPU (y del compilador) para cada kernel
+bool SolverSimd_HasAVX2(void);
+bool SolverSimd_HasAVX512(void);
+bool SolverSimd_HasF16C(void);
+
+#endif
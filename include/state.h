@@ -2,34 +2,148 @@
 #define STATE_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
-// Resolución de la simulación (bajamos un poco para que vaya rápido en CPU)
-#define GRID_W 400
-#define GRID_H 400
+// Resolución por defecto de la simulación (bajamos un poco para que vaya rápido en CPU).
+// El tamaño real se elige al llamar a Solver_Init y queda en width/height.
+#define DEFAULT_GRID_W 400
+#define DEFAULT_GRID_H 400
 
 // Modelo D2Q9 (9 velocidades)
 #define Q 9
 
+// Orden de las poblaciones en memoria (ver Solver_SetLayout)
+typedef enum {
+    LAYOUT_AOS = 0, // f[i*Q + k]: las 9 poblaciones de cada celda juntas
+    LAYOUT_SOA = 1  // f[k*stride + i]: un plano alineado por dirección (SIMD)
+} PopulationLayout;
+
+// Precisión con la que se guardan las poblaciones (ver Solver_SetPrecision)
+typedef enum {
+    PRECISION_FP32 = 0, // float
+    PRECISION_FP16 = 1  // half, como desvío de w[k] (la colisión sigue en float)
+} PopulationPrecision;
+
+// Set de instrucciones del kernel de stream-collide (solo aplica a LAYOUT_SOA)
+typedef enum {
+    ISA_SCALAR = 0,
+    ISA_AVX2 = 1,    // 8 celdas por instrucción
+    ISA_AVX512 = 2   // 16 celdas por instrucción
+} SolverIsa;
+
+// Origen especial de una población en BoundaryLinks.src
+#define LINK_BOUNCE (-1) // El vecino es pared: rebota la población opuesta de la propia celda
+#define LINK_OPEN   (-2) // El vecino está fuera de la grilla: frontera abierta (w[k])
+
+// Clasificación de las celdas según 'barrier' (la arma el solver cuando cambia).
+// Interiores: fluido con sus 8 vecinos fluido y dentro de la grilla (sin inlet),
+// agrupadas en tramos contiguos de cada fila. De frontera: el resto del fluido,
+// con el origen de cada una de sus Q poblaciones ya resuelto.
+typedef struct {
+    int *run_offset;   // [height+1] tramos de la fila y: run_offset[y] .. run_offset[y+1]-1
+    int *run_begin;    // Tramo de celdas interiores [run_begin, run_end)
+    int *run_end;
+    int *cell_offset;  // [height+1] celdas de frontera de la fila y
+    int *cell;         // Índice de cada celda de frontera
+    int *src;          // [Q por celda] celda de donde viene la población k, o LINK_*
+    int num_runs;
+    int num_cells;
+    int num_interior;  // Celdas cubiertas por los tramos
+} BoundaryLinks;
+
+// Enlaces fluido -> pared (los rebotes) para calcular la fuerza sobre los
+// obstáculos por intercambio de momento (ver Solver_ComputeForces). Se arma
+// junto con la geometría, en cualquier modo de almacenamiento.
+typedef struct {
+    int *cell;            // Celda de fluido
+    unsigned char *dir;   // Dirección k de la población que va hacia la pared
+    int count;
+    int frontal_height;   // Filas con alguna pared (largo de referencia de Cd/Cl)
+} WallLinks;
+
+// Almacenamiento compacto (indirecto) de solo las celdas de fluido. Con
+// state->sparse activo, f/new_f guardan la población k de la celda de fluido j
+// en f[k*stride + j], y al final Q valores fijos w[k] para las fronteras abiertas.
+typedef struct {
+    int count;        // Celdas de fluido
+    int stride;       // Separación entre planos (count redondeado a múltiplo de 16)
+    int *cell;        // [count] índice en la grilla de cada celda de fluido
+    int *slot;        // [width*height] j de cada celda de la grilla, -1 si es pared
+    int *row_offset;  // [height+1] celdas de fluido de la fila y: row_offset[y] .. row_offset[y+1]-1
+    int *src;         // [(Q-1)*stride] posición en f de donde viene la población k >= 1
+                      // (vecino, rebote en la propia celda o valor fijo de frontera)
+} SparseLattice;
+
+// Métricas globales de un paso, calculadas durante el barrido del solver
+// (ver Solver_RequestDiagnostics). Masa y energía suman todas las celdas
+// (como el log original); velocidad máxima y residual, solo las de fluido.
 typedef struct {
+    int step;              // Paso al que corresponden (-1 = todavía ninguno)
+    double mass;           // Suma de rho
+    double kinetic_energy; // Suma de 0.5 * rho * |u|^2
+    float max_velocity;    // Máximo de |u|
+    double residual;       // ||u(n) - u(n-1)|| / ||u(n)|| (norma L2)
+    double velocity_change2; // Suma de |u(n) - u(n-1)|^2 y de |u(n)|^2: lo que
+    double velocity_norm2;   // hace falta para sumar el residual entre procesos
+} SolverDiagnostics;
+
+typedef struct {
+    int width;      // Tamaño de la grilla
+    int height;
+
     // Arrays planos para performance
     float *f;       // Distribución actual
     float *new_f;   // Distribución siguiente
+    int layout;     // PopulationLayout de f/new_f
+    int stride;     // Separación entre planos en LAYOUT_SOA (múltiplo de 16)
+    int isa;        // SolverIsa usado en LAYOUT_SOA
     
     float *rho;     // Densidad
     float *ux;      // Velocidad X
     float *uy;      // Velocidad Y
     
     bool *barrier;  // Obstáculos (paredes)
+    void *field_arena; // Bloque de rho, ux, uy y barrier (ver Solver_InitFields)
+    bool barrier_dirty; // Poner en true al editar barrier (el solver rearma 'links')
+    bool barrier_shared; // barrier es de otro (Solver_ShareBarrier): no se libera
+    BoundaryLinks links;
+    WallLinks wall_links;
+
+    int precision;  // PopulationPrecision. En PRECISION_FP16 f/new_f quedan en NULL
+    uint16_t *f_half;     // y las poblaciones están en f_half/new_f_half (por planos)
+    uint16_t *new_f_half;
+
+    bool in_place;  // Propagación en el lugar (patrón AA): solo f, new_f = NULL
+    int aa_phase;   // Fase del próximo paso en ese modo (ver solver_inplace.c)
+
+    bool sparse;            // f/new_f en almacenamiento compacto (SparseLattice)
+    float sparse_threshold; // Fracción de paredes desde la que se usa 'sparse'
+    SparseLattice sparse_lattice;
     
     float omega;    // Parametro de relajacion
     float inlet_velocity; // Velocidad de entrada
+
+    int num_threads; // Hilos para Solver_Step (ver Solver_SetThreads)
+    int block_depth; // Pasos por barrido en Solver_Advance (ver Solver_SetTemporalBlocking)
+
+    int time_step;   // Pasos dados desde Solver_Init (lo avanza Solver_Step)
+
+    bool diagnostics_requested; // El próximo Solver_Step llena 'diagnostics'
+    SolverDiagnostics diagnostics;
+    void *diagnostics_scratch;  // Sumas por banda y velocidad anterior de una fila
+    size_t diagnostics_scratch_bytes; // (se reusa entre pasos, ver solver.c)
+
+    // f puede venir mapeada directo desde un checkpoint (ver Checkpoint_Load)
+    float *mapped_f;
+    size_t mapped_bytes;
 } SimulationState;
 
 // Helper para obtener índice 1D
-static inline int idx(int x, int y) {
-    if (x < 0) x = 0; if (x >= GRID_W) x = GRID_W - 1;
-    if (y < 0) y = 0; if (y >= GRID_H) y = GRID_H - 1;
-    return y * GRID_W + x;
+static inline int idx(const SimulationState *state, int x, int y) {
+    if (x < 0) x = 0; if (x >= state->width) x = state->width - 1;
+    if (y < 0) y = 0; if (y >= state->height) y = state->height - 1;
+    return y * state->width + x;
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,20 @@
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+// Pool de hilos con robo de trabajo para muchas tareas independientes de
+// duración desigual (p.ej. simulaciones chicas de un barrido de parámetros).
+// Cada hilo arranca con un tramo contiguo de tareas y las toma de a una
+// desde el principio; cuando se queda sin tareas le roba la mitad final del
+// tramo a otro hilo. Sin soporte de hilos (p.ej. web) corre todo en serie.
+
+// Tarea número 'index' (0..count-1) ejecutada por el hilo 'worker'
+typedef void (*TaskFn)(void *arg, int index, int worker);
+
+// Ejecuta fn para las 'count' tareas con 'workers' hilos (0 = uno por
+// núcleo) y vuelve cuando terminaron todas
+void TaskPool_Run(int count, int workers, TaskFn fn, void *arg);
+
+// Núcleos disponibles (al menos 1)
+int TaskPool_DefaultWorkers(void);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+// Reloj monotónico en segundos (para medir sin depender de raylib/GetTime)
+#if defined(_WIN32)
+#include <windows.h>
+static inline double Timer_Now(void) {
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart / (double)freq.QuadPart;
+}
+#else
+#include <time.h>
+static inline double Timer_Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+#endif
+
+#endif
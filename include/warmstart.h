@@ -0,0 +1,32 @@
+#ifndef WARMSTART_H
+#define WARMSTART_H
+
+#include <stdio.h>
+#include "state.h"
+
+// Arranque en grillas gruesas: en vez de partir del reposo, el mismo problema
+// se resuelve primero en grillas de la mitad, la cuarta parte, ... de la
+// resolución (con las paredes reducidas y el mismo número de Reynolds), cada
+// una hasta que su residual baja de la tolerancia o se acaban los pasos, y
+// se pasa a la siguiente interpolando rho, u y la parte de no equilibrio.
+// En la grilla gruesa la estela se arma con muchos menos pasos y mucho más
+// barata, así la grilla final empieza cerca del estado estacionario.
+typedef struct {
+    int levels;      // Grillas gruesas (0 = ninguna)
+    float tolerance; // Residual con el que se pasa al nivel siguiente
+    int check_period; // Cada cuántos pasos se mira el residual
+    int max_steps;   // Tope de pasos por nivel (flujos que no se estacionan)
+} WarmStartOptions;
+
+// Omega más alto que se usa en las grillas gruesas. Con la misma viscosidad
+// tau se acerca a 1/2 al engrosar; desde acá se deja de bajar (Reynolds algo
+// menor en esos niveles, que igual son solo un punto de partida).
+#define WARMSTART_MAX_OMEGA 1.9f
+
+// Deja en 'state' (recién creado con sus paredes, grilla densa en float con
+// dos buffers: antes de Solver_SetInPlace / Solver_SetPrecision) el estado
+// interpolado desde la grilla gruesa. No cambia state->time_step. Escribe el
+// avance de cada nivel en 'log' (NULL = nada).
+void WarmStart_Run(SimulationState *state, const WarmStartOptions *options, FILE *log);
+
+#endif
@@ -0,0 +1,48 @@
+"""Compara dos simulation_log.csv (por ejemplo una corrida en fp32 y la misma en fp16).
+
+Uso: python compare_logs.py referencia.csv otra.csv
+
+Para cada métrica global imprime el error relativo máximo y el del último
+paso en común, tomando la primera corrida como referencia.
+"""
+import csv
+import sys
+
+COLUMNS = ["TotalMass", "KineticEnergy", "MaxVelocity"]
+
+
+def read_log(filename):
+    """Devuelve {paso: fila} con los valores como float."""
+    with open(filename, newline="") as f:
+        return {int(row["Step"]): {k: float(v) for k, v in row.items() if k != "Step"}
+                for row in csv.DictReader(f)}
+
+
+def relative_error(ref, value):
+    return abs(value - ref) / abs(ref) if ref != 0 else abs(value)
+
+
+def compare(ref, other):
+    steps = sorted(set(ref) & set(other))
+    if not steps:
+        raise ValueError("los logs no tienen pasos en común")
+    result = {}
+    for column in COLUMNS:
+        errors = [relative_error(ref[s][column], other[s][column]) for s in steps]
+        result[column] = (max(errors), errors[-1])
+    return steps, result
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(__doc__)
+        sys.exit(1)
+    steps, result = compare(read_log(sys.argv[1]), read_log(sys.argv[2]))
+    print(f"{len(steps)} pasos en común (hasta el {steps[-1]})")
+    print(f"{'metrica':<14} {'error max':>12} {'error final':>12}")
+    for column, (worst, last) in result.items():
+        print(f"{column:<14} {worst:12.3e} {last:12.3e}")
+
+
+if __name__ == "__main__":
+    main()
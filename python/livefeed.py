@@ -0,0 +1,197 @@
+"""Lectura en vivo de los campos que publica el simulador con --live NOMBRE.
+
+El simulador deja en la memoria compartida /dev/shm/NOMBRE un anillo de
+cuadros (ver include/livefeed.h): rho, ux, uy, barrier y las métricas
+globales cada --live-every pasos. Acá el segmento se mapea una sola vez y
+los planos de cada cuadro se ven como arrays de NumPy sin copiar ni parsear.
+El solver no espera a nadie: si un cuadro se pisa mientras se lo lee, el
+contador del cuadro cambia y la lectura se descarta.
+
+Uso:
+    feed = LiveFeed("hydrosim")
+    for frame in feed.frames():
+        print(frame["step"], frame["residual"], frame["rho"].mean())
+
+o desde la consola: python python/livefeed.py hydrosim
+"""
+import mmap
+import os
+import sys
+import time
+
+import numpy as np
+
+HEADER = np.dtype([
+    ("magic", "S4"),
+    ("version", "<u4"),
+    ("header_size", "<u4"),
+    ("frame_header_size", "<u4"),
+    ("width", "<i4"),
+    ("height", "<i4"),
+    ("num_frames", "<i4"),
+    ("period", "<i4"),
+    ("frame_bytes", "<u8"),
+    ("plane_bytes", "<u8"),
+    ("writer_pid", "<i4"),
+    ("closed", "<u4"),
+    ("published", "<u8"),
+    ("reserved", "<u4", (16,)),
+])
+
+FRAME = np.dtype([
+    ("sequence", "<u8"),
+    ("step", "<i4"),
+    ("omega", "<f4"),
+    ("inlet_velocity", "<f4"),
+    ("max_velocity", "<f4"),
+    ("mass", "<f8"),
+    ("kinetic_energy", "<f8"),
+    ("residual", "<f8"),
+    ("fx", "<f8"),
+    ("fy", "<f8"),
+    ("cd", "<f8"),
+    ("cl", "<f8"),
+    ("reserved", "<u4", (12,)),
+])
+
+METRICS = [name for name in FRAME.names if name not in ("sequence", "reserved")]
+
+
+class LiveFeed:
+    """Segmento de memoria compartida de una corrida en curso."""
+
+    def __init__(self, name="hydrosim"):
+        path = os.path.join("/dev/shm", name.lstrip("/"))
+        fd = os.open(path, os.O_RDONLY)
+        try:
+            self._map = mmap.mmap(fd, 0, access=mmap.ACCESS_READ)
+        finally:
+            os.close(fd)
+        self._header = np.frombuffer(self._map, dtype=HEADER, count=1)
+        h = self._header[0]
+        if h["magic"] != b"HLIV" or h["version"] != 1:
+            raise ValueError(f"{path} no es un feed en vivo del simulador (o todavía se está creando)")
+        self.width = int(h["width"])
+        self.height = int(h["height"])
+        self.num_frames = int(h["num_frames"])
+        self.period = int(h["period"])
+        self.writer_pid = int(h["writer_pid"])
+
+        # Vistas fijas de cada lugar del anillo (solo lectura, sin copias)
+        N = self.width * self.height
+        shape = (self.height, self.width)
+        plane = int(h["plane_bytes"])
+        self._slots = []
+        for s in range(self.num_frames):
+            base = int(h["header_size"]) + s * int(h["frame_bytes"])
+            planes = base + int(h["frame_header_size"])
+            self._slots.append({
+                "meta": np.frombuffer(self._map, dtype=FRAME, count=1, offset=base),
+                "rho": np.frombuffer(self._map, "<f4", N, planes).reshape(shape),
+                "ux": np.frombuffer(self._map, "<f4", N, planes + plane).reshape(shape),
+                "uy": np.frombuffer(self._map, "<f4", N, planes + 2 * plane).reshape(shape),
+                "barrier": np.frombuffer(self._map, "u1", N, planes + 3 * plane).reshape(shape),
+            })
+
+    def published(self):
+        """Cuadros publicados hasta ahora (el último es published() - 1)."""
+        return int(self._header["published"][0])
+
+    def closed(self):
+        """True si la corrida terminó (o el proceso que escribía ya no existe)."""
+        if self._header["closed"][0]:
+            return True
+        try:
+            os.kill(self.writer_pid, 0)
+        except ProcessLookupError:
+            return True
+        except PermissionError:
+            pass
+        return False
+
+    def _sequence(self, n):
+        return int(self._slots[n % self.num_frames]["meta"]["sequence"][0])
+
+    def view(self, n=None):
+        """Vistas sin copia del cuadro n (por defecto el último).
+
+        Los arrays apuntan a la memoria compartida: el solver los pisa
+        cuando vuelve a ese lugar del anillo (num_frames - 1 cuadros
+        después). Usar valid(n) después de procesarlos para saber si lo
+        leído sigue siendo del cuadro n. None si todavía no hay cuadros.
+        """
+        if n is None:
+            n = self.published() - 1
+        if n < 0:
+            return None
+        slot = self._slots[n % self.num_frames]
+        meta = slot["meta"][0]
+        frame = {"frame": n}
+        frame.update({name: meta[name].item() for name in METRICS})
+        frame.update({k: slot[k] for k in ("rho", "ux", "uy", "barrier")})
+        return frame
+
+    def valid(self, n):
+        """True si el lugar del cuadro n todavía tiene ese cuadro completo."""
+        return self._sequence(n) == 2 * n + 2
+
+    def read(self, n=None):
+        """Copia consistente del cuadro n (por defecto el último).
+
+        Devuelve un diccionario con las métricas ('step', 'residual', 'cd',
+        ...; NaN si no se calcularon en ese paso) y los planos 'rho', 'ux',
+        'uy' y 'barrier' como matrices [y, x]. None si el cuadro n ya se
+        pisó o todavía no hay cuadros.
+        """
+        latest = n is None
+        while True:
+            if latest:
+                n = self.published() - 1
+                if n < 0:
+                    return None
+            if not self.valid(n):
+                if latest and not self.closed():
+                    continue  # Se está escribiendo uno nuevo en ese lugar
+                return None
+            frame = self.view(n)
+            for k in ("rho", "ux", "uy", "barrier"):
+                frame[k] = frame[k].copy()
+            frame["barrier"] = frame["barrier"].astype(bool)
+            if self.valid(n):
+                return frame
+            if not latest:
+                return None
+
+    def frames(self, poll=0.01, skip=True):
+        """Itera sobre los cuadros a medida que se publican, hasta que la corrida termina.
+
+        Con skip=True, si el lector se atrasa salta al último cuadro (para
+        gráficos en vivo); con skip=False devuelve todos los que sigan en el
+        anillo. El campo 'frame' permite ver cuántos se perdieron.
+        """
+        n = self.published()
+        while True:
+            published = self.published()
+            if published > n:
+                n = published - 1 if skip else max(n, published - self.num_frames + 1)
+                frame = self.read(n)
+                n += 1
+                if frame is not None:
+                    yield frame
+            elif self.closed():
+                return
+            else:
+                time.sleep(poll)
+
+    def close(self):
+        self._header = None
+        self._slots = []
+        self._map.close()
+
+
+if __name__ == "__main__":
+    feed = LiveFeed(sys.argv[1] if len(sys.argv) > 1 else "hydrosim")
+    print(f"Grilla {feed.width}x{feed.height}, un cuadro cada {feed.period} pasos")
+    for frame in feed.frames():
+        print(f"paso {frame['step']:8d}  residual {frame['residual']:.3e}  "
+              f"Cd {frame['cd']:.4f}  Cl {frame['cl']:+.4f}  |u| max {frame['max_velocity']:.4f}")
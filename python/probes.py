@@ -0,0 +1,79 @@
+"""Lectura de las series de las sondas (probes.bin) del simulador.
+
+Formato (ver include/probes.h): cabecera little-endian, la tabla de sondas,
+las coordenadas x, y de todas las celdas y luego un registro por muestra con
+step (int32) y rho, ux, uy (float32) de todas las celdas.
+"""
+import numpy as np
+
+HEADER = np.dtype([
+    ("magic", "S4"),
+    ("version", "<u4"),
+    ("header_size", "<u4"),
+    ("width", "<i4"),
+    ("height", "<i4"),
+    ("period", "<i4"),
+    ("num_probes", "<i4"),
+    ("num_cells", "<i4"),
+    ("reserved", "<u4", (8,)),
+])
+
+PROBE = np.dtype([
+    ("name", "S32"),
+    ("type", "<i4"),
+    ("x0", "<i4"),
+    ("y0", "<i4"),
+    ("x1", "<i4"),
+    ("y1", "<i4"),
+    ("offset", "<i4"),
+    ("count", "<i4"),
+])
+
+TYPES = {0: "point", 1: "line", 2: "rect"}
+
+
+def read_probes(filename):
+    """Lee todas las sondas.
+
+    Devuelve (steps, probes): 'steps' es el arreglo de pasos registrados y
+    'probes' un diccionario nombre -> {'type', 'x', 'y', 'rho', 'ux', 'uy'},
+    con los campos como matrices [muestra, celda]. Un registro final
+    incompleto (corrida cortada) se descarta, y si la corrida se retomó desde
+    un checkpoint quedan las muestras de la corrida retomada.
+    """
+    header = np.fromfile(filename, dtype=HEADER, count=1)[0]
+    if header["magic"] != b"HPRB":
+        raise ValueError(f"{filename} no es un archivo de sondas")
+    P = int(header["num_probes"])
+    C = int(header["num_cells"])
+
+    record = np.dtype([("step", "<i4"), ("rho", "<f4", (C,)),
+                       ("ux", "<f4", (C,)), ("uy", "<f4", (C,))])
+    with open(filename, "rb") as f:
+        f.seek(HEADER.itemsize)
+        info = np.fromfile(f, dtype=PROBE, count=P)
+        x = np.fromfile(f, dtype="<i4", count=C)
+        y = np.fromfile(f, dtype="<i4", count=C)
+        f.seek(int(header["header_size"]))
+        data = f.read()
+    records = np.frombuffer(data, dtype=record, count=len(data) // record.itemsize)
+
+    # Al retomar se repiten los pasos posteriores al checkpoint: vale el último
+    steps = records["step"]
+    keep = np.ones(len(records), dtype=bool)
+    for i in np.nonzero(steps[:-1] >= steps[1:])[0]:
+        keep[:i + 1] &= steps[:i + 1] < steps[i + 1]
+    records = records[keep]
+
+    probes = {}
+    for p in info:
+        s = slice(int(p["offset"]), int(p["offset"]) + int(p["count"]))
+        probes[p["name"].decode()] = {
+            "type": TYPES.get(int(p["type"]), "?"),
+            "x": x[s],
+            "y": y[s],
+            "rho": records["rho"][:, s],
+            "ux": records["ux"][:, s],
+            "uy": records["uy"][:, s],
+        }
+    return records["step"], probes
@@ -0,0 +1,128 @@
+"""Lectura de los snapshots binarios (snapshot_XXXXX.bin) del simulador.
+
+Formato (ver include/snapshot.h): cabecera little-endian seguida de los
+planos rho, ux, uy y barrier (uint8), cada uno de height x width. Desde la
+versión 2 la cabecera dice además qué región de la grilla se guardó, cada
+cuántas celdas (stride), si los planos van cuantizados a 16 u 8 bits y si
+van comprimidos con zlib.
+"""
+import zlib
+
+import numpy as np
+
+HEADER_V1 = np.dtype([
+    ("magic", "S4"),
+    ("version", "<u4"),
+    ("header_size", "<u4"),
+    ("width", "<i4"),
+    ("height", "<i4"),
+    ("step", "<i4"),
+    ("omega", "<f4"),
+    ("inlet_velocity", "<f4"),
+    ("reserved", "<u4", (8,)),
+])
+
+PLANE = np.dtype([("bytes", "<u8"), ("offset", "<f4"), ("scale", "<f4")])
+
+HEADER = np.dtype([
+    ("magic", "S4"),
+    ("version", "<u4"),
+    ("header_size", "<u4"),
+    ("width", "<i4"),
+    ("height", "<i4"),
+    ("step", "<i4"),
+    ("omega", "<f4"),
+    ("inlet_velocity", "<f4"),
+    ("grid_width", "<i4"),
+    ("grid_height", "<i4"),
+    ("roi_x0", "<i4"),
+    ("roi_y0", "<i4"),
+    ("stride", "<i4"),
+    ("quant_bits", "<i4"),
+    ("compression", "<i4"),
+    ("shuffle", "<i4"),
+    ("planes", PLANE, (4,)),
+    ("reserved", "<u4", (4,)),
+])
+
+PLANE_NAMES = ("rho", "ux", "uy", "barrier")
+
+
+def read_header(filename):
+    """Devuelve la cabecera como diccionario (con los valores por defecto
+    de la versión 2 completados si el archivo es de la versión 1)."""
+    first = np.fromfile(filename, dtype=HEADER_V1, count=1)[0]
+    if first["magic"] != b"HSNP":
+        raise ValueError(f"{filename} no es un snapshot binario")
+    dtype = HEADER_V1 if first["version"] < 2 else HEADER
+    header = np.fromfile(filename, dtype=dtype, count=1)[0]
+    info = {name: header[name].item() if header[name].ndim == 0 else header[name]
+            for name in dtype.names if name not in ("planes", "reserved")}
+    planes = header["planes"] if "planes" in dtype.names else np.zeros(4, dtype=PLANE)
+    info["planes"] = [{name: planes[p][name].item() for name in PLANE.names} for p in range(4)]
+    # Ceros = valores por defecto (grilla completa, float32, sin comprimir)
+    info.setdefault("grid_width", 0)
+    info.setdefault("grid_height", 0)
+    info["grid_width"] = info["grid_width"] or info["width"]
+    info["grid_height"] = info["grid_height"] or info["height"]
+    info["roi_x0"] = info.get("roi_x0", 0)
+    info["roi_y0"] = info.get("roi_y0", 0)
+    info["stride"] = info.get("stride", 0) or 1
+    info["quant_bits"] = info.get("quant_bits", 0) or 32
+    info["compression"] = info.get("compression", 0)
+    info["shuffle"] = info.get("shuffle", 0)
+    return info
+
+
+def _read_plane(f, header, p, N):
+    """Lee y decodifica el plano p (descomprime, desagrupa y descuantiza)."""
+    plane = header["planes"][p]
+    if p == 3:
+        dtype = np.dtype(np.uint8)
+    elif header["quant_bits"] == 16:
+        dtype = np.dtype("<u2")
+    elif header["quant_bits"] == 8:
+        dtype = np.dtype(np.uint8)
+    else:
+        dtype = np.dtype("<f4")
+
+    if plane["bytes"] > 0:
+        raw = zlib.decompress(f.read(plane["bytes"]))
+        data = np.frombuffer(raw, dtype=np.uint8)
+        if header["shuffle"] and dtype.itemsize > 1:
+            data = np.ascontiguousarray(data.reshape(dtype.itemsize, N).T)
+        values = data.view(dtype).reshape(-1)
+    else:
+        values = np.fromfile(f, dtype=dtype, count=N)
+    if values.size != N:
+        raise ValueError(f"el plano {PLANE_NAMES[p]} está incompleto")
+
+    if p < 3 and header["quant_bits"] != 32:
+        values = (plane["offset"] + values.astype(np.float32) * np.float32(plane["scale"])).astype(np.float32)
+    return values
+
+
+def read_snapshot(filename):
+    """Lee un snapshot completo.
+
+    Devuelve un diccionario con la cabecera (step, omega, ...) y los campos
+    'rho', 'ux', 'uy' (float32) y 'barrier' (bool) como matrices [y, x],
+    con el mismo orden que usaba df.pivot(index='y', columns='x'). Si se
+    guardó una región o con decimado, 'x' e 'y' son las coordenadas de la
+    grilla completa de las columnas y filas guardadas.
+    """
+    header = read_header(filename)
+    W, H = header["width"], header["height"]
+    N = W * H
+
+    with open(filename, "rb") as f:
+        f.seek(header["header_size"])
+        planes = [_read_plane(f, header, p, N) for p in range(4)]
+
+    snapshot = dict(header)
+    for name, values in zip(PLANE_NAMES, planes):
+        snapshot[name] = values.reshape(H, W)
+    snapshot["barrier"] = snapshot["barrier"].astype(bool)
+    snapshot["x"] = header["roi_x0"] + header["stride"] * np.arange(W)
+    snapshot["y"] = header["roi_y0"] + header["stride"] * np.arange(H)
+    return snapshot
@@ -1,51 +1,78 @@
 #include "analysis.h"
+#include "solver.h"
+#include "profile.h"
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 
 // Nombre del archivo de log
 static const char* LOG_FILE = "simulation_log.csv";
 static const char* PERF_FILE = "tiempos.csv";
+static const char* FORCES_FILE = "forces_log.csv";
+
+// Cruces de Cl que se usan para estimar la frecuencia
+#define STROUHAL_CROSSINGS 5
+// Pasos sin cruces (mientras no se conoce el período) tras los que se vuelve
+// a centrar la referencia: Cl puede asentarse lejos de la media del arranque
+#define STROUHAL_MAX_WAIT 20000
+
+// Serie de Cl para el Strouhal: se cuentan los cruces hacia arriba de la
+// media del ciclo anterior, con histéresis para no contar el ruido
+static struct {
+    FILE *file;
+    double reference;  // Media de Cl del último ciclo completo
+    double hysteresis; // Margen alrededor de la referencia
+    int side;          // -1 debajo, +1 arriba, 0 todavía no se sabe
+    double cycle_sum, cycle_min, cycle_max;
+    int cycle_samples;
+    int cycle_start;   // Paso en que empezó el ciclo actual
+    int period;        // Último período medido (0 = ninguno)
+    int crossing[STROUHAL_CROSSINGS]; // Pasos de los últimos cruces (circular)
+    int num_crossings;
+} forces;
 
 void Analysis_Init(void) {
     FILE *f = fopen(LOG_FILE, "w");
     if (f == NULL) return;
-    // Encabezados: Paso de tiempo, Energía Cinética Total, Masa Total, Convergencia (Residual)
-    fprintf(f, "Step,KineticEnergy,TotalMass,Residual\n");
+    // Encabezados: Paso de tiempo, Energía Cinética Total, Masa Total, Convergencia (Residual), |u| máximo
+    fprintf(f, "Step,KineticEnergy,TotalMass,Residual,MaxVelocity\n");
     fclose(f);
 }
 
 float Analysis_ComputeAndSave(SimulationState *state, int time_step) {
-    int N = GRID_W * GRID_H;
-    double total_energy = 0.0;
-    double total_mass = 0.0;
-    double total_residual = 0.0;
-
-    for (int i = 0; i < N; i++) {
-        float rho = state->rho[i];
-        float ux = state->ux[i];
-        float uy = state->uy[i];
-
-        // 1. Conservación de Masa: Sumatoria de rho
-        total_mass += rho;
-
-        // 2. Conservación de Energía Cinética: 0.5 * rho * v^2
-        total_energy += 0.5 * rho * (ux*ux + uy*uy);
-
-        // 3. Convergencia (Residual): Diferencia entre velocidad actual y anterior
-        // Nota: Necesitas guardar el ux/uy del paso anterior para calcular esto con precisión.
-        // Como aproximación simple, usamos la magnitud de la velocidad en zonas estacionarias,
-        // pero para hacerlo bien, compararemos la variación de rho como proxy.
-        // (En LBM estricto se compara f_new vs f_old, aquí usaremos una métrica simple).
+    uint64_t t = Profile_Begin();
+    SolverDiagnostics d = state->diagnostics;
+
+    // Sin Solver_RequestDiagnostics para este paso: pasada aparte sobre los
+    // campos (sin residual, que necesita la velocidad del paso anterior)
+    if (d.step != time_step) {
+        int N = state->width * state->height;
+        float max_usq = 0.0f;
+        d.mass = 0.0;
+        d.kinetic_energy = 0.0;
+        d.residual = 0.0;
+        for (int i = 0; i < N; i++) {
+            float rho = state->rho[i];
+            float usq = state->ux[i]*state->ux[i] + state->uy[i]*state->uy[i];
+            d.mass += rho;
+            d.kinetic_energy += 0.5 * rho * usq;
+            if (!state->barrier[i] && usq > max_usq) max_usq = usq;
+        }
+        d.max_velocity = sqrtf(max_usq);
     }
 
+    Analysis_SaveDiagnostics(&d, time_step);
+    Profile_End(PROF_ANALYSIS, t);
+    return (float)d.residual;
+}
+
+void Analysis_SaveDiagnostics(const SolverDiagnostics *d, int time_step) {
     // Guardar en archivo (append mode)
     FILE *f = fopen(LOG_FILE, "a");
-    if (f != NULL) {
-        fprintf(f, "%d,%.6f,%.6f\n", time_step, total_energy, total_mass);
-        fclose(f);
-    }
-
-    return (float)total_energy; // Retornamos energía como referencia
+    if (f == NULL) return;
+    fprintf(f, "%d,%.6f,%.6f,%.6e,%.6f\n", time_step, d->kinetic_energy, d->mass,
+            d->residual, d->max_velocity);
+    fclose(f);
 }
 
 void Analysis_SaveSnapshot(SimulationState *state, int time_step) {
@@ -59,9 +86,9 @@ void Analysis_SaveSnapshot(SimulationState *state, int time_step) {
     // Formato: X, Y, Rho, Ux, Uy, IsBarrier
     fprintf(f, "x,y,rho,ux,uy,barrier\n");
 
-    for (int y = 0; y < GRID_H; y++) {
-        for (int x = 0; x < GRID_W; x++) {
-            int i = idx(x, y);
+    for (int y = 0; y < state->height; y++) {
+        for (int x = 0; x < state->width; x++) {
+            int i = idx(state, x, y);
             fprintf(f, "%d,%d,%.4f,%.4f,%.4f,%d\n", 
                     x, y, 
                     state->rho[i], 
@@ -74,6 +101,122 @@ void Analysis_SaveSnapshot(SimulationState *state, int time_step) {
     printf("Snapshot guardado: %s\n", filename);
 }
 
+void Analysis_VorticityRow(const float *ux, const float *uy, int width, int height,
+                           int y, int x0, int x1, float *out) {
+    const float *uy_row = uy + (size_t)y * width;
+    const float *ux_up = ux + (size_t)(y > 0 ? y - 1 : y) * width;
+    const float *ux_dn = ux + (size_t)(y < height - 1 ? y + 1 : y) * width;
+    for (int x = x0; x < x1; x++) {
+        int xl = x > 0 ? x - 1 : x;
+        int xr = x < width - 1 ? x + 1 : x;
+        out[x - x0] = 0.5f * ((uy_row[xr] - uy_row[xl]) - (ux_dn[x] - ux_up[x]));
+    }
+}
+
+void Analysis_ComputeVorticity(const SimulationState *state, float *out) {
+    int W = state->width;
+    for (int y = 0; y < state->height; y++) {
+        Analysis_VorticityRow(state->ux, state->uy, W, state->height, y, 0, W, out + (size_t)y * W);
+    }
+}
+
+void Analysis_ForceCoefficients(const SimulationState *state, double fx, double fy,
+                                double *cd, double *cl) {
+    double U = state->inlet_velocity;
+    double q = 0.5 * U * U * state->wall_links.frontal_height;
+    *cd = q > 0.0 ? fx / q : 0.0;
+    *cl = q > 0.0 ? fy / q : 0.0;
+}
+
+void Analysis_InitForcesLog(bool append) {
+    Analysis_CloseForcesLog();
+    memset(&forces, 0, sizeof(forces));
+    forces.file = fopen(FORCES_FILE, append ? "a" : "w");
+    if (forces.file == NULL) return;
+    if (!append) fprintf(forces.file, "Step,Fx,Fy,Cd,Cl,Strouhal\n");
+}
+
+// Agrega una muestra de Cl; devuelve el Strouhal estimado (0 = todavía no)
+static double TrackStrouhal(double frontal_height, double velocity, double cl, int time_step) {
+    if (forces.cycle_samples == 0) {
+        forces.cycle_min = cl;
+        forces.cycle_max = cl;
+        forces.cycle_start = time_step;
+    }
+    forces.cycle_sum += cl;
+    forces.cycle_samples++;
+    if (cl < forces.cycle_min) forces.cycle_min = cl;
+    if (cl > forces.cycle_max) forces.cycle_max = cl;
+
+    double d = cl - forces.reference;
+    if (d < -forces.hysteresis) {
+        forces.side = -1;
+    } else if (d > forces.hysteresis && forces.side <= 0) {
+        // Cruce hacia arriba: cierra un ciclo
+        if (forces.side < 0) {
+            if (forces.num_crossings > 0) {
+                forces.period = time_step - forces.crossing[(forces.num_crossings - 1) % STROUHAL_CROSSINGS];
+            }
+            forces.crossing[forces.num_crossings % STROUHAL_CROSSINGS] = time_step;
+            forces.num_crossings++;
+        }
+        forces.side = 1;
+        forces.reference = forces.cycle_sum / forces.cycle_samples;
+        forces.hysteresis = 0.1 * (forces.cycle_max - forces.cycle_min);
+        forces.cycle_sum = 0.0;
+        forces.cycle_samples = 0;
+    } else {
+        // Demasiado tiempo sin cruzar: la serie se corrió, empezar de nuevo
+        int limit = forces.period > 0 ? 2 * forces.period : STROUHAL_MAX_WAIT;
+        if (time_step - forces.cycle_start > limit) {
+            forces.reference = forces.cycle_sum / forces.cycle_samples;
+            forces.hysteresis = 0.1 * (forces.cycle_max - forces.cycle_min);
+            forces.cycle_sum = 0.0;
+            forces.cycle_samples = 0;
+            forces.side = 0;
+            forces.num_crossings = 0;
+            forces.period = 0;
+        }
+    }
+
+    if (forces.num_crossings < 3) return 0.0;
+    int n = forces.num_crossings < STROUHAL_CROSSINGS ? forces.num_crossings : STROUHAL_CROSSINGS;
+    int last = forces.crossing[(forces.num_crossings - 1) % STROUHAL_CROSSINGS];
+    int first = forces.crossing[(forces.num_crossings - n) % STROUHAL_CROSSINGS];
+    if (last <= first || velocity <= 0.0) return 0.0;
+    double frequency = (double)(n - 1) / (last - first);
+    return frequency * frontal_height / velocity;
+}
+
+void Analysis_LogForces(const SimulationState *state, int time_step) {
+    Analysis_LogForcesScaled(state, time_step, 1);
+}
+
+void Analysis_LogForcesScaled(const SimulationState *state, int time_step, int scale) {
+    if (forces.file == NULL) return;
+    uint64_t t = Profile_Begin();
+    double fx, fy, cd, cl;
+    Solver_ComputeForces(state, &fx, &fy);
+    Analysis_ForceCoefficients(state, fx, fy, &cd, &cl);
+    // Con dx y dt 'scale' veces más chicos la fuerza en unidades de la grilla
+    // (2D) escala como dx: se pasa a unidades de la base, igual que el largo
+    fx /= scale;
+    fy /= scale;
+    double strouhal = TrackStrouhal((double)state->wall_links.frontal_height / scale,
+                                    state->inlet_velocity, cl, time_step);
+    if (strouhal > 0.0) {
+        fprintf(forces.file, "%d,%.6e,%.6e,%.6f,%.6f,%.5f\n", time_step, fx, fy, cd, cl, strouhal);
+    } else {
+        fprintf(forces.file, "%d,%.6e,%.6e,%.6f,%.6f,\n", time_step, fx, fy, cd, cl);
+    }
+    Profile_End(PROF_FORCES, t);
+}
+
+void Analysis_CloseForcesLog(void) {
+    if (forces.file != NULL) fclose(forces.file);
+    forces.file = NULL;
+}
+
 void Analysis_InitPerformanceLog(void) {
     FILE *f = fopen(PERF_FILE, "w");
     if (f == NULL) return;
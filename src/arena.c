@@ -0,0 +1,103 @@
+#include "arena.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#define ARENA_MMAP 1
+#include <sys/mman.h>
+#endif
+
+#define PAGE_SIZE_SMALL ((size_t)4096)
+#define HUGE_PAGE_SIZE ((size_t)2 << 20)
+#define ARENA_MMAP_MIN ((size_t)256 << 10) // Bloques más chicos van con malloc
+
+// Justo antes de cada bloque: de dónde salió, para poder liberarlo
+typedef struct {
+    void *base;
+    size_t length;  // Bytes mapeados (0 = vino de malloc)
+    char pad[ARENA_ALIGN - sizeof(void*) - sizeof(size_t)];
+} ArenaHeader;
+
+static HugePageMode huge_pages = HUGE_PAGES_OFF;
+static bool hugetlb_warned = false;
+
+void Arena_SetHugePages(HugePageMode mode) {
+    huge_pages = mode;
+}
+
+#ifdef ARENA_MMAP
+// Mapeo anónimo. El bloque empieza en un borde de página (de 2 MB con THP)
+// y la cabecera va en la página anterior: el hilo que pide el bloque no toca
+// ninguna página de datos y el primer toque decide el nodo de cada una.
+static void *MapBlock(size_t bytes) {
+    if (huge_pages == HUGE_PAGES_EXPLICIT) {
+        size_t length = (bytes + ARENA_ALIGN + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        void *p = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            ArenaHeader *h = (ArenaHeader*)p;
+            h->base = p;
+            h->length = length;
+            return h + 1;
+        }
+        if (!hugetlb_warned) {
+            fprintf(stderr, "No hay paginas grandes reservadas (vm.nr_hugepages): se usan las transparentes\n");
+            hugetlb_warned = true;
+        }
+    }
+
+    size_t align = huge_pages != HUGE_PAGES_OFF ? HUGE_PAGE_SIZE : PAGE_SIZE_SMALL;
+    size_t length = bytes + align;
+    void *p = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+
+    uintptr_t data = ((uintptr_t)p + sizeof(ArenaHeader) + align - 1) & ~(uintptr_t)(align - 1);
+#ifdef MADV_HUGEPAGE
+    if (huge_pages != HUGE_PAGES_OFF) madvise((void*)data, bytes, MADV_HUGEPAGE);
+#endif
+    ArenaHeader *h = (ArenaHeader*)data - 1;
+    h->base = p;
+    h->length = length;
+    return (void*)data;
+}
+#endif
+
+void *Arena_Alloc(size_t bytes) {
+    if (bytes == 0) bytes = 1;
+#ifdef ARENA_MMAP
+    if (bytes >= ARENA_MMAP_MIN) return MapBlock(bytes);
+#endif
+
+    void *base = NULL;
+    size_t total = bytes + sizeof(ArenaHeader);
+#if defined(_WIN32)
+    base = _aligned_malloc(total, ARENA_ALIGN);
+#else
+    if (posix_memalign(&base, ARENA_ALIGN, total) != 0) base = NULL;
+#endif
+    if (base == NULL) return NULL;
+    memset(base, 0, total);
+    ArenaHeader *h = (ArenaHeader*)base;
+    h->base = base;
+    h->length = 0;
+    return h + 1;
+}
+
+void Arena_Free(void *ptr) {
+    if (ptr == NULL) return;
+    ArenaHeader *h = (ArenaHeader*)ptr - 1;
+#ifdef ARENA_MMAP
+    if (h->length > 0) {
+        munmap(h->base, h->length);
+        return;
+    }
+#endif
+#if defined(_WIN32)
+    _aligned_free(h->base);
+#else
+    free(h->base);
+#endif
+}
@@ -0,0 +1,322 @@
+// Benchmark del solver: Solver_Step sobre una matriz de tamaños, escenarios,
+// hilos y variantes de almacenamiento. Sin raylib ni I/O dentro de la medición.
+// Salida en CSV (o JSON) para comparar corridas y detectar regresiones.
+#include "state.h"
+#include "solver.h"
+#include "scenario.h"
+#include "config.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define MAX_ITEMS 16
+
+// Variantes de almacenamiento / kernel
+typedef enum {
+    VARIANT_AOS = 0,   // Grilla densa, poblaciones por celda (kernel escalar)
+    VARIANT_SOA,       // Grilla densa por planos, kernel escalar
+    VARIANT_AVX2,      // SoA con kernel AVX2
+    VARIANT_AVX512,    // SoA con kernel AVX-512
+    VARIANT_SPARSE,    // Solo celdas de fluido (mejor kernel disponible)
+    VARIANT_INPLACE,   // SoA con propagación en el lugar (un solo arreglo)
+    VARIANT_FP16,      // SoA con poblaciones en half
+    VARIANT_COUNT
+} BenchVariant;
+
+static const char *VARIANT_NAMES[VARIANT_COUNT] = { "aos", "soa", "avx2", "avx512", "sparse", "inplace", "fp16" };
+
+typedef struct {
+    int widths[MAX_ITEMS], heights[MAX_ITEMS], num_sizes;
+    int scenarios[MAX_ITEMS], num_scenarios;
+    int threads[MAX_ITEMS], num_threads;
+    int variants[MAX_ITEMS], num_variants;
+    int depths[MAX_ITEMS], num_depths; // Pasos por barrido (Solver_SetTemporalBlocking)
+    int warmup;        // Pasos sin medir antes de cada caso
+    int steps;         // Pasos por repetición
+    int reps;          // Repeticiones medidas
+    bool json;
+    const char *output; // NULL = stdout
+} BenchConfig;
+
+// Tráfico de memoria por actualización de una celda de fluido (bytes):
+// leer y escribir Q poblaciones + escribir rho, ux, uy. El almacenamiento
+// compacto además lee la tabla de vecinos (Q índices); en half cada
+// población ocupa 2 bytes.
+static double BytesPerFluidUpdate(int variant) {
+    double pop = variant == VARIANT_FP16 ? sizeof(uint16_t) : sizeof(float);
+    double bytes = 2.0 * Q * pop + 3.0 * sizeof(float);
+    if (variant == VARIANT_SPARSE) bytes += Q * sizeof(int);
+    return bytes;
+}
+
+// Separa "a,b,c" y aplica parse a cada elemento
+static bool ParseList(const char *text, int *out, int *count,
+                      bool (*parse)(const char *item, int *value)) {
+    char buffer[256];
+    if (strlen(text) >= sizeof(buffer)) return false;
+    strcpy(buffer, text);
+
+    *count = 0;
+    for (char *item = strtok(buffer, ","); item != NULL; item = strtok(NULL, ",")) {
+        if (*count >= MAX_ITEMS) return false;
+        if (!parse(item, &out[*count])) return false;
+        (*count)++;
+    }
+    return *count > 0;
+}
+
+static bool ParseThreadCount(const char *text, int *out) {
+    return Config_ParseInt(text, out, 0);
+}
+
+static bool ParseDepth(const char *text, int *out) {
+    return Config_ParseInt(text, out, 1);
+}
+
+static bool ParseVariant(const char *text, int *out) {
+    for (int v = 0; v < VARIANT_COUNT; v++) {
+        if (strcmp(text, VARIANT_NAMES[v]) == 0) { *out = v; return true; }
+    }
+    return false;
+}
+
+static void SetDefaults(BenchConfig *cfg) {
+    const int sizes[] = { 256, 512, 1024 };
+    memset(cfg, 0, sizeof(*cfg));
+    for (int i = 0; i < 3; i++) {
+        cfg->widths[i] = cfg->heights[i] = sizes[i];
+    }
+    cfg->num_sizes = 3;
+    for (int s = SCENARIO_CIRCLE; s <= SCENARIO_WALL; s++) cfg->scenarios[cfg->num_scenarios++] = s;
+    cfg->threads[0] = 1;
+    cfg->threads[1] = 0; // Todos los núcleos
+    cfg->num_threads = 2;
+    for (int v = 0; v < VARIANT_COUNT; v++) cfg->variants[cfg->num_variants++] = v;
+    cfg->depths[0] = 1;
+    cfg->num_depths = 1;
+    cfg->warmup = 50;
+    cfg->steps = 200;
+    cfg->reps = 5;
+    cfg->json = false;
+    cfg->output = NULL;
+}
+
+static bool ParseArgs(BenchConfig *cfg, int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Falta el valor de %s\n", arg);
+            return false;
+        }
+        const char *value = argv[++i];
+        bool ok;
+        if (strcmp(arg, "--sizes") == 0) {
+            char buffer[256];
+            ok = strlen(value) < sizeof(buffer);
+            cfg->num_sizes = 0;
+            if (ok) {
+                strcpy(buffer, value);
+                for (char *item = strtok(buffer, ","); ok && item != NULL; item = strtok(NULL, ",")) {
+                    ok = cfg->num_sizes < MAX_ITEMS &&
+                         Config_ParseSize(item, &cfg->widths[cfg->num_sizes], &cfg->heights[cfg->num_sizes]);
+                    cfg->num_sizes++;
+                }
+            }
+            ok = ok && cfg->num_sizes > 0;
+        }
+        else if (strcmp(arg, "--scenarios") == 0) ok = ParseList(value, cfg->scenarios, &cfg->num_scenarios, ParseScenarioName);
+        else if (strcmp(arg, "--threads") == 0)   ok = ParseList(value, cfg->threads, &cfg->num_threads, ParseThreadCount);
+        else if (strcmp(arg, "--variants") == 0)  ok = ParseList(value, cfg->variants, &cfg->num_variants, ParseVariant);
+        else if (strcmp(arg, "--depths") == 0)    ok = ParseList(value, cfg->depths, &cfg->num_depths, ParseDepth);
+        else if (strcmp(arg, "--warmup") == 0)    ok = Config_ParseInt(value, &cfg->warmup, 0);
+        else if (strcmp(arg, "--steps") == 0)     ok = Config_ParseInt(value, &cfg->steps, 1);
+        else if (strcmp(arg, "--reps") == 0)      ok = Config_ParseInt(value, &cfg->reps, 1);
+        else if (strcmp(arg, "--format") == 0) {
+            ok = strcmp(value, "csv") == 0 || strcmp(value, "json") == 0;
+            cfg->json = strcmp(value, "json") == 0;
+        }
+        else if (strcmp(arg, "--output") == 0) { cfg->output = value; ok = true; }
+        else {
+            fprintf(stderr, "Opcion desconocida: %s\n", arg);
+            return false;
+        }
+        if (!ok) {
+            fprintf(stderr, "Valor invalido para %s: %s\n", arg, value);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void PrintUsage(const char *program) {
+    printf("Uso: %s [opciones]\n", program);
+    printf("  --sizes LISTA           tamaños de grilla, p.ej. 256,512,800x200 (256,512,1024)\n");
+    printf("  --scenarios LISTA       none,circle,square,wall (circle,square,wall)\n");
+    printf("  --threads LISTA         hilos, 0 = todos los nucleos (1,0)\n");
+    printf("  --variants LISTA        aos,soa,avx2,avx512,sparse,inplace,fp16 (todas)\n");
+    printf("  --depths LISTA          pasos por barrido con bloqueo temporal (1)\n");
+    printf("  --warmup N              pasos sin medir antes de cada caso (50)\n");
+    printf("  --steps N               pasos por repeticion (200)\n");
+    printf("  --reps N                repeticiones medidas (5)\n");
+    printf("  --format csv|json       formato de salida (csv)\n");
+    printf("  --output ARCHIVO        escribe el resultado en un archivo en vez de stdout\n");
+}
+
+typedef struct {
+    int width, height, scenario, threads, variant, depth;
+    int isa;                // Kernel que quedó activo
+    int fluid_cells;
+    double bytes_per_update; // Promedio por celda de la grilla
+    double mlups_median, mlups_min, mlups_max, mlups_stddev;
+    double bandwidth_gbs;   // Con la mediana
+} BenchResult;
+
+static int CompareDouble(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Prepara un caso. Devuelve false si la CPU no tiene el kernel pedido.
+static bool SetupCase(SimulationState *state, int width, int height, int scenario, int threads, int variant) {
+    Solver_Init(state, width, height);
+    Solver_SetThreads(state, threads);
+    // Denso salvo en la variante compacta, sin importar la fracción de paredes
+    Solver_SetSparseThreshold(state, variant == VARIANT_SPARSE ? 0.0f : 2.0f);
+
+    if (variant != VARIANT_AOS) {
+        Solver_SetLayout(state, LAYOUT_SOA);
+        SolverIsa wanted = variant == VARIANT_SOA  ? ISA_SCALAR
+                         : variant == VARIANT_AVX2 ? ISA_AVX2 : ISA_AVX512;
+        if (Solver_SetIsa(state, wanted) != wanted && variant < VARIANT_SPARSE) {
+            Solver_Cleanup(state);
+            return false;
+        }
+    }
+    if (variant == VARIANT_INPLACE) Solver_SetInPlace(state, true);
+    if (variant == VARIANT_FP16) Solver_SetPrecision(state, PRECISION_FP16);
+    InitScenario(state, scenario);
+    return true;
+}
+
+static bool RunCase(const BenchConfig *cfg, int width, int height, int scenario, int threads,
+                    int variant, int depth, BenchResult *result) {
+    SimulationState state;
+    if (!SetupCase(&state, width, height, scenario, threads, variant)) return false;
+    Solver_SetTemporalBlocking(&state, depth);
+
+    // Calentamiento: caches, páginas y la geometría (links / tabla compacta)
+    Solver_Advance(&state, cfg->warmup > 0 ? cfg->warmup : 1);
+
+    double *mlups = (double*)malloc(cfg->reps * sizeof(double));
+    double cells = (double)width * height;
+    for (int r = 0; r < cfg->reps; r++) {
+        double t0 = Timer_Now();
+        Solver_Advance(&state, cfg->steps);
+        double dt = Timer_Now() - t0;
+        mlups[r] = dt > 0.0 ? cells * cfg->steps / dt * 1e-6 : 0.0;
+    }
+
+    double mean = 0.0, var = 0.0;
+    for (int r = 0; r < cfg->reps; r++) mean += mlups[r];
+    mean /= cfg->reps;
+    for (int r = 0; r < cfg->reps; r++) var += (mlups[r] - mean) * (mlups[r] - mean);
+    qsort(mlups, cfg->reps, sizeof(double), CompareDouble);
+
+    int fluid = 0;
+    for (int i = 0; i < width * height; i++) fluid += !state.barrier[i];
+
+    result->width = width;
+    result->height = height;
+    result->scenario = scenario;
+    result->threads = state.num_threads;
+    result->variant = variant;
+    result->depth = depth;
+    result->isa = variant == VARIANT_AOS ? ISA_SCALAR : state.isa;
+    result->fluid_cells = fluid;
+    result->bytes_per_update = BytesPerFluidUpdate(variant) * fluid / cells;
+    result->mlups_min = mlups[0];
+    result->mlups_max = mlups[cfg->reps - 1];
+    result->mlups_median = (cfg->reps % 2) ? mlups[cfg->reps / 2]
+                         : 0.5 * (mlups[cfg->reps / 2 - 1] + mlups[cfg->reps / 2]);
+    result->mlups_stddev = cfg->reps > 1 ? sqrt(var / (cfg->reps - 1)) : 0.0;
+    result->bandwidth_gbs = result->mlups_median * 1e6 * result->bytes_per_update * 1e-9;
+
+    free(mlups);
+    Solver_Cleanup(&state);
+    return true;
+}
+
+static void WriteResult(FILE *out, const BenchResult *r, bool json, bool first) {
+    if (json) {
+        fprintf(out, "%s  {\"width\": %d, \"height\": %d, \"scenario\": \"%s\", \"threads\": %d, "
+                     "\"variant\": \"%s\", \"block_depth\": %d, \"isa\": \"%s\", \"fluid_cells\": %d, "
+                     "\"mlups_median\": %.3f, \"mlups_min\": %.3f, \"mlups_max\": %.3f, "
+                     "\"mlups_stddev\": %.3f, \"bytes_per_update\": %.2f, \"bandwidth_gbs\": %.3f}",
+                first ? "" : ",\n", r->width, r->height, ScenarioName(r->scenario), r->threads,
+                VARIANT_NAMES[r->variant], r->depth, Solver_IsaName((SolverIsa)r->isa), r->fluid_cells,
+                r->mlups_median, r->mlups_min, r->mlups_max, r->mlups_stddev,
+                r->bytes_per_update, r->bandwidth_gbs);
+    } else {
+        fprintf(out, "%d,%d,%s,%d,%s,%d,%s,%d,%.3f,%.3f,%.3f,%.3f,%.2f,%.3f\n",
+                r->width, r->height, ScenarioName(r->scenario), r->threads,
+                VARIANT_NAMES[r->variant], r->depth, Solver_IsaName((SolverIsa)r->isa), r->fluid_cells,
+                r->mlups_median, r->mlups_min, r->mlups_max, r->mlups_stddev,
+                r->bytes_per_update, r->bandwidth_gbs);
+    }
+    fflush(out);
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            PrintUsage(argv[0]);
+            return 0;
+        }
+    }
+
+    BenchConfig cfg;
+    SetDefaults(&cfg);
+    if (!ParseArgs(&cfg, argc, argv)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    FILE *out = stdout;
+    if (cfg.output != NULL) {
+        out = fopen(cfg.output, "w");
+        if (out == NULL) {
+            fprintf(stderr, "No se pudo abrir %s\n", cfg.output);
+            return 1;
+        }
+    }
+
+    if (cfg.json) fprintf(out, "[\n");
+    else fprintf(out, "width,height,scenario,threads,variant,block_depth,isa,fluid_cells,mlups_median,"
+                      "mlups_min,mlups_max,mlups_stddev,bytes_per_update,bandwidth_gbs\n");
+
+    bool first = true;
+    for (int s = 0; s < cfg.num_sizes; s++)
+    for (int c = 0; c < cfg.num_scenarios; c++)
+    for (int t = 0; t < cfg.num_threads; t++)
+    for (int v = 0; v < cfg.num_variants; v++)
+    for (int d = 0; d < cfg.num_depths; d++) {
+        BenchResult result;
+        if (!RunCase(&cfg, cfg.widths[s], cfg.heights[s], cfg.scenarios[c], cfg.threads[t],
+                     cfg.variants[v], cfg.depths[d], &result)) {
+            fprintf(stderr, "Salteado: %s no está disponible en esta CPU\n", VARIANT_NAMES[cfg.variants[v]]);
+            continue;
+        }
+        WriteResult(out, &result, cfg.json, first);
+        first = false;
+        // Progreso por stderr para no mezclarlo con el resultado
+        fprintf(stderr, "%dx%d %s %d hilos %s x%d: %.1f MLUPS\n", result.width, result.height,
+                ScenarioName(result.scenario), result.threads, VARIANT_NAMES[result.variant],
+                result.depth, result.mlups_median);
+    }
+
+    if (cfg.json) fprintf(out, "\n]\n");
+    if (out != stdout) fclose(out);
+    return 0;
+}
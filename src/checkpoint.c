@@ -0,0 +1,266 @@
+// off_t de 64 bits también en sistemas de 32 bits (checkpoints de más de 2 GiB)
+#define _FILE_OFFSET_BITS 64
+
+#include "checkpoint.h"
+#include "solver_internal.h"
+#include "lattice.h"
+#include "solver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#if !defined(_WIN32) && !defined(PLATFORM_WEB)
+#define CHECKPOINT_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static uint64_t AlignUp(uint64_t value) {
+    return (value + CHECKPOINT_ALIGN - 1) / CHECKPOINT_ALIGN * CHECKPOINT_ALIGN;
+}
+
+// Cabecera y posición de cada sección. f se guarda siempre como grilla densa
+// en el layout del estado (el almacenamiento compacto se expande). En
+// PRECISION_FP16 se guardan los half tal cual, sin redondear de nuevo.
+static void BuildHeader(const SimulationState *state, CheckpointHeader *h, uint64_t *total) {
+    int N = state->width * state->height;
+    int stride = state->sparse ? Solver_DenseStride(state->layout, N) : state->stride;
+
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, CHECKPOINT_MAGIC, 4);
+    h->version = CHECKPOINT_VERSION;
+    h->header_size = sizeof(CheckpointHeader);
+    h->width = state->width;
+    h->height = state->height;
+    h->layout = state->layout;
+    h->stride = stride;
+    h->time_step = state->time_step;
+    h->omega = state->omega;
+    h->inlet_velocity = state->inlet_velocity;
+    h->sparse_threshold = state->sparse_threshold;
+    h->precision = state->precision;
+    h->f_offset = AlignUp(sizeof(CheckpointHeader));
+    h->f_bytes = (uint64_t)Q * stride * (state->precision == PRECISION_FP16 ? sizeof(uint16_t) : sizeof(float));
+    h->fields_offset = AlignUp(h->f_offset + h->f_bytes);
+    h->barrier_offset = h->fields_offset + (uint64_t)3 * N * sizeof(float);
+    *total = h->barrier_offset + N;
+}
+
+// Copia las poblaciones al formato del archivo
+static void ExportPopulations(const SimulationState *state, const CheckpointHeader *h, float *out) {
+    if (state->precision == PRECISION_FP16) {
+        memcpy(out, state->f_half, h->f_bytes);
+        return;
+    }
+    if (state->in_place) {
+        SolverInPlace_Canonical(state, out);
+        return;
+    }
+    if (!state->sparse) {
+        memcpy(out, state->f, h->f_bytes);
+        return;
+    }
+    const SparseLattice *sp = &state->sparse_lattice;
+    SimulationState dense = *state;
+    dense.stride = h->stride;
+    int N = state->width * state->height;
+    for (int i = 0; i < N; i++) {
+        int j = sp->slot[i];
+        for (int k = 0; k < Q; k++) {
+            // Las paredes no se guardan en el almacenamiento compacto: equilibrio en reposo
+            out[PopIndex(&dense, i, k)] = j >= 0 ? state->f[(size_t)k * sp->stride + j] : w[k];
+        }
+    }
+}
+
+static void ExportFields(const SimulationState *state, float *fields, unsigned char *barrier) {
+    size_t N = (size_t)state->width * state->height;
+    memcpy(fields, state->rho, N * sizeof(float));
+    memcpy(fields + N, state->ux, N * sizeof(float));
+    memcpy(fields + 2 * N, state->uy, N * sizeof(float));
+    for (size_t i = 0; i < N; i++) barrier[i] = state->barrier[i] ? 1 : 0;
+}
+
+bool Checkpoint_Save(const SimulationState *state, const char *path) {
+    CheckpointHeader h;
+    uint64_t total;
+    BuildHeader(state, &h, &total);
+
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+#ifdef CHECKPOINT_MMAP
+    // El archivo se arma en memoria mapeada: una sola copia, sin buffers de stdio
+    int fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    if (ftruncate(fd, (off_t)total) != 0) {
+        close(fd);
+        unlink(tmp);
+        return false;
+    }
+    unsigned char *map = (unsigned char*)mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        unlink(tmp);
+        return false;
+    }
+
+    memcpy(map, &h, sizeof(h));
+    ExportPopulations(state, &h, (float*)(map + h.f_offset));
+    ExportFields(state, (float*)(map + h.fields_offset), map + h.barrier_offset);
+
+    bool ok = munmap(map, total) == 0;
+    ok = ok && fsync(fd) == 0;
+    ok = (close(fd) == 0) && ok;
+#else
+    size_t N = (size_t)state->width * state->height;
+    unsigned char *data = (unsigned char*)calloc(1, total);
+    if (data == NULL) return false;
+    memcpy(data, &h, sizeof(h));
+    ExportPopulations(state, &h, (float*)(data + h.f_offset));
+    ExportFields(state, (float*)(data + h.fields_offset), data + h.barrier_offset);
+
+    FILE *f = fopen(tmp, "wb");
+    bool ok = f != NULL && fwrite(data, 1, total, f) == total;
+    if (f != NULL && fclose(f) != 0) ok = false;
+    free(data);
+    (void)N;
+#if defined(_WIN32)
+    if (ok) remove(path); // rename no pisa archivos en Windows
+#endif
+#endif
+
+    if (!ok || rename(tmp, path) != 0) {
+        remove(tmp);
+        return false;
+    }
+    return true;
+}
+
+// Lee 'bytes' desde 'offset' del archivo (posiciones de 64 bits: con
+// fseek y long no se llega más allá de 2 GiB en Windows)
+static bool ReadAt(FILE *f, uint64_t offset, void *dst, size_t bytes) {
+#if defined(_WIN32)
+    if (_fseeki64(f, (__int64)offset, SEEK_SET) != 0) return false;
+#else
+    if (fseeko(f, (off_t)offset, SEEK_SET) != 0) return false;
+#endif
+    return fread(dst, 1, bytes, f) == bytes;
+}
+
+static uint64_t FileSize(FILE *f) {
+#if defined(_WIN32)
+    struct _stat64 st;
+    return _fstat64(_fileno(f), &st) == 0 ? (uint64_t)st.st_size : 0;
+#else
+    struct stat st;
+    return fstat(fileno(f), &st) == 0 ? (uint64_t)st.st_size : 0;
+#endif
+}
+
+// Tamaños y posiciones coherentes con la grilla y contenidos en el archivo:
+// de la cabecera salen los tamaños de las reservas y de los mapeos
+static bool ValidSections(const CheckpointHeader *h, uint64_t file_size) {
+    uint64_t N = (uint64_t)h->width * (uint64_t)h->height;
+    uint64_t elem = h->precision == PRECISION_FP16 ? sizeof(uint16_t) : sizeof(float);
+    if (h->stride < 1 || (uint64_t)h->stride < N) return false;
+    if (h->f_bytes != (uint64_t)Q * (uint64_t)h->stride * elem) return false;
+    return h->f_offset >= sizeof(CheckpointHeader) && h->f_offset <= file_size
+        && h->f_bytes <= file_size - h->f_offset
+        && h->fields_offset <= file_size && 3 * N * sizeof(float) <= file_size - h->fields_offset
+        && h->barrier_offset <= file_size && N <= file_size - h->barrier_offset;
+}
+
+bool Checkpoint_Load(SimulationState *state, const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return false;
+
+    CheckpointHeader h;
+    if (fread(&h, sizeof(h), 1, file) != 1 || memcmp(h.magic, CHECKPOINT_MAGIC, 4) != 0 ||
+        h.version != CHECKPOINT_VERSION || h.width < 1 || h.height < 1 ||
+        (h.layout != LAYOUT_AOS && h.layout != LAYOUT_SOA) ||
+        h.precision > PRECISION_FP16 || (h.precision == PRECISION_FP16 && h.layout != LAYOUT_SOA) ||
+        !ValidSections(&h, FileSize(file))) {
+        fclose(file);
+        return false;
+    }
+
+    Solver_InitFields(state, h.width, h.height);
+    state->layout = h.layout;
+    state->stride = h.stride;
+    state->time_step = h.time_step;
+    state->omega = h.omega;
+    state->inlet_velocity = h.inlet_velocity;
+    state->sparse_threshold = h.sparse_threshold;
+    if (h.layout == LAYOUT_SOA) Solver_SetIsa(state, ISA_AVX512);
+
+    size_t N = (size_t)h.width * h.height;
+    bool ok = true;
+
+    if (h.precision == PRECISION_FP16) {
+        // Half: se lee entero (son la mitad de bytes) y new_f_half arranca igual
+        SolverHalf_Alloc(state);
+        state->precision = PRECISION_FP16;
+        ok = ReadAt(file, h.f_offset, state->f_half, h.f_bytes);
+        if (ok) memcpy(state->new_f_half, state->f_half, h.f_bytes);
+    }
+
+#ifdef CHECKPOINT_MMAP
+    // f directo desde el archivo (copy-on-write): el primer paso solo la lee
+    long page = sysconf(_SC_PAGESIZE);
+    if (state->precision == PRECISION_FP32 && page > 0 && CHECKPOINT_ALIGN % page == 0 &&
+        h.f_offset % CHECKPOINT_ALIGN == 0) {
+        void *map = mmap(NULL, h.f_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                         fileno(file), (off_t)h.f_offset);
+        if (map != MAP_FAILED) {
+            state->f = (float*)map;
+            state->mapped_f = state->f;
+            state->mapped_bytes = h.f_bytes;
+        }
+    }
+#endif
+    if (state->precision == PRECISION_FP32) {
+        if (state->f == NULL) {
+            state->f = Solver_AllocPopulations(h.f_bytes / sizeof(float));
+            ok = ReadAt(file, h.f_offset, state->f, h.f_bytes);
+        }
+        state->new_f = Solver_AllocPopulations(h.f_bytes / sizeof(float));
+    }
+
+    ok = ok && ReadAt(file, h.fields_offset, state->rho, N * sizeof(float))
+            && ReadAt(file, h.fields_offset + N * sizeof(float), state->ux, N * sizeof(float))
+            && ReadAt(file, h.fields_offset + 2 * N * sizeof(float), state->uy, N * sizeof(float));
+
+    unsigned char *barrier = (unsigned char*)malloc(N);
+    ok = ok && barrier != NULL && ReadAt(file, h.barrier_offset, barrier, N);
+    for (size_t i = 0; ok && i < N; i++) state->barrier[i] = barrier[i] != 0;
+    free(barrier);
+    fclose(file);
+
+    if (!ok) {
+        Solver_Cleanup(state);
+        return false;
+    }
+
+    // new_f se llena en el primer paso salvo en las paredes, que no se
+    // recalculan: ahí se copia f para no dejar memoria sin inicializar
+    for (size_t i = 0; state->precision == PRECISION_FP32 && i < N; i++) {
+        if (!state->barrier[i]) continue;
+        for (int k = 0; k < Q; k++) {
+            size_t p = PopIndex(state, (int)i, k);
+            state->new_f[p] = state->f[p];
+        }
+    }
+    state->barrier_dirty = true;
+    return true;
+}
+
+void Checkpoint_Unmap(float *ptr, size_t bytes) {
+#ifdef CHECKPOINT_MMAP
+    munmap(ptr, bytes);
+#else
+    (void)ptr; (void)bytes;
+#endif
+}
@@ -0,0 +1,250 @@
+#include "colormap.h"
+#include "analysis.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define COLORMAP_X86 1
+#include <immintrin.h>
+#define AVX2_FN __attribute__((target("avx2")))
+#endif
+
+#define LUT_SIZE 256
+#define ANCHORS 5
+
+// Puntos de control de cada tabla (se interpolan linealmente a 256 colores)
+static const unsigned char anchors[FIELD_COUNT][ANCHORS][3] = {
+    {{68, 1, 84}, {59, 82, 139}, {33, 145, 140}, {94, 201, 98}, {253, 231, 37}},   // viridis
+    {{59, 76, 192}, {141, 176, 254}, {221, 221, 221}, {244, 154, 123}, {180, 4, 38}}, // coolwarm
+    {{0, 0, 4}, {87, 16, 110}, {188, 55, 84}, {249, 142, 9}, {252, 255, 164}},     // inferno
+    {{59, 76, 192}, {141, 176, 254}, {221, 221, 221}, {244, 154, 123}, {180, 4, 38}}, // coolwarm
+};
+
+static const char *field_names[FIELD_COUNT] = {"velocidad", "vorticidad", "densidad", "presion"};
+
+// Tablas como uint32 con los bytes en orden R, G, B, A (se copian tal cual)
+static uint32_t lut[FIELD_COUNT][LUT_SIZE];
+static uint32_t wall_color;
+static bool lut_ready = false;
+
+static uint32_t PackColor(unsigned char r, unsigned char g, unsigned char b) {
+    unsigned char bytes[4] = {r, g, b, 255};
+    uint32_t c;
+    memcpy(&c, bytes, 4);
+    return c;
+}
+
+static void BuildTables(void) {
+    for (int f = 0; f < FIELD_COUNT; f++) {
+        for (int i = 0; i < LUT_SIZE; i++) {
+            float t = (float)i / (LUT_SIZE - 1) * (ANCHORS - 1);
+            int a = (int)t;
+            if (a > ANCHORS - 2) a = ANCHORS - 2;
+            float s = t - a;
+            unsigned char c[3];
+            for (int k = 0; k < 3; k++) {
+                float v = anchors[f][a][k] + s * (anchors[f][a + 1][k] - anchors[f][a][k]);
+                c[k] = (unsigned char)(v + 0.5f);
+            }
+            lut[f][i] = PackColor(c[0], c[1], c[2]);
+        }
+    }
+    wall_color = PackColor(255, 100, 100); // Obstáculo Rojo
+    lut_ready = true;
+}
+
+const char *Colormap_FieldName(FieldKind field) {
+    return (field >= 0 && field < FIELD_COUNT) ? field_names[field] : "?";
+}
+
+// Rango [lo, lo + 255 / scale] de cada campo según la velocidad de entrada.
+// La densidad se centra en su media ('rho_mean'): la entrada y la salida
+// corren la masa total y un rango fijo alrededor de 1 queda saturado.
+static void FieldRange(const FieldFrame *frame, FieldKind field, float rho_mean, float *lo, float *scale) {
+    float U = frame->inlet_velocity > 0.0f ? frame->inlet_velocity : 0.05f;
+    float half;
+    switch (field) {
+        case FIELD_VORTICITY: half = 0.1f * U; *lo = -half; break;
+        case FIELD_DENSITY:   half = 3.0f * U * U; *lo = rho_mean - half; break;
+        case FIELD_PRESSURE:  half = U * U; *lo = -half; break;
+        default:              half = U; *lo = 0.0f; break;
+    }
+    *scale = (LUT_SIZE - 1) / (2.0f * half);
+}
+
+#ifdef COLORMAP_X86
+
+// Rapidez |u| de a 8 celdas; devuelve la primera que quedó sin hacer
+static AVX2_FN int SpeedAVX2(const float *ux, const float *uy, int n, float *out) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 vx = _mm256_loadu_ps(ux + i);
+        __m256 vy = _mm256_loadu_ps(uy + i);
+        __m256 s = _mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy));
+        _mm256_storeu_ps(out + i, _mm256_sqrt_ps(s));
+    }
+    return i;
+}
+
+// Índice en la tabla con saturación (NaN va al 0), gather de la tabla y
+// color de pared donde walls != 0
+static AVX2_FN int MapAVX2(const float *values, const unsigned char *walls, int n,
+                            float lo, float scale, const uint32_t *table, uint32_t wall, uint32_t *out) {
+    const __m256 vlo = _mm256_set1_ps(lo);
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 top = _mm256_set1_ps((float)(LUT_SIZE - 1));
+    const __m256i vwall = _mm256_set1_epi32((int)wall);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 t = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(values + i), vlo), vscale);
+        t = _mm256_min_ps(_mm256_max_ps(t, zero), top);
+        __m256i index = _mm256_cvttps_epi32(t);
+        __m256i color = _mm256_i32gather_epi32((const int*)table, index, 4);
+        __m256i w = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(walls + i)));
+        __m256i mask = _mm256_cmpgt_epi32(w, _mm256_setzero_si256());
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_blendv_epi8(color, vwall, mask));
+    }
+    return i;
+}
+
+#endif
+
+// Valores del campo en la fila y, columnas [x0, x1) de la grilla completa
+static void FieldRow(const FieldFrame *frame, FieldKind field, float rho_mean,
+                     int y, int x0, int x1, float *out) {
+    int W = frame->width;
+    int H = frame->height;
+    const float *ux = frame->ux + (size_t)y * W;
+    const float *uy = frame->uy + (size_t)y * W;
+    const float *rho = frame->rho + (size_t)y * W;
+    int n = x1 - x0;
+
+    switch (field) {
+        case FIELD_SPEED: {
+            int i = 0;
+#ifdef COLORMAP_X86
+            if (__builtin_cpu_supports("avx2")) {
+                i = SpeedAVX2(ux + x0, uy + x0, n, out);
+            }
+#endif
+            for (; i < n; i++) {
+                float vx = ux[x0 + i];
+                float vy = uy[x0 + i];
+                out[i] = sqrtf(vx * vx + vy * vy);
+            }
+            break;
+        }
+        case FIELD_VORTICITY:
+            Analysis_VorticityRow(frame->ux, frame->uy, W, H, y, x0, x1, out);
+            break;
+        case FIELD_DENSITY:
+            for (int i = 0; i < n; i++) out[i] = rho[x0 + i];
+            break;
+        default:
+            for (int i = 0; i < n; i++) out[i] = (rho[x0 + i] - rho_mean) * (1.0f / 3.0f);
+            break;
+    }
+}
+
+static void MapRow(const float *values, const unsigned char *walls, int n,
+                   float lo, float scale, const uint32_t *table, uint32_t *out) {
+    int i = 0;
+#ifdef COLORMAP_X86
+    if (__builtin_cpu_supports("avx2")) {
+        i = MapAVX2(values, walls, n, lo, scale, table, wall_color, out);
+    }
+#endif
+    for (; i < n; i++) {
+        float t = fminf(fmaxf((values[i] - lo) * scale, 0.0f), (float)(LUT_SIZE - 1));
+        out[i] = walls[i] ? wall_color : table[(int)t];
+    }
+}
+
+void Colormap_Render(const FieldFrame *frame, FieldKind field, int factor,
+                     int tx0, int ty0, int tx1, int ty1, unsigned char *rgba) {
+    if (!lut_ready) BuildTables();
+    if (factor < 1) factor = 1;
+    if (field < 0 || field >= FIELD_COUNT) field = FIELD_SPEED;
+
+    int W = frame->width;
+    int H = frame->height;
+    int tw = tx1 - tx0;
+    int th = ty1 - ty0;
+    if (tw <= 0 || th <= 0) return;
+
+    // Columnas de la grilla que cubren los texels
+    int cx0 = tx0 * factor;
+    int cx1 = tx1 * factor < W ? tx1 * factor : W;
+
+    // Densidad media del fluido en toda la grilla (referencia de densidad y
+    // presión; no cambia al hacer zoom)
+    float rho_mean = 1.0f;
+    if (field == FIELD_DENSITY || field == FIELD_PRESSURE) {
+        double sum = 0.0;
+        long count = 0;
+        #pragma omp parallel for reduction(+:sum, count) schedule(static)
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                size_t i = (size_t)y * W + x;
+                if (!frame->barrier[i]) {
+                    sum += frame->rho[i];
+                    count++;
+                }
+            }
+        }
+        if (count > 0) rho_mean = (float)(sum / count);
+    }
+
+    float lo, scale;
+    FieldRange(frame, field, rho_mean, &lo, &scale);
+    const uint32_t *table = lut[field];
+
+    #pragma omp parallel
+    {
+        float *values = (float*)malloc(tw * sizeof(float));
+        unsigned char *walls = (unsigned char*)malloc(tw);
+        float *cells = (float*)malloc((cx1 - cx0) * sizeof(float));
+        int *fluid = (int*)malloc(tw * sizeof(int));
+
+        #pragma omp for schedule(static)
+        for (int ty = ty0; ty < ty1; ty++) {
+            uint32_t *out = (uint32_t*)rgba + (size_t)(ty - ty0) * tw;
+            if (factor == 1) {
+                FieldRow(frame, field, rho_mean, ty, tx0, tx1, values);
+                for (int i = 0; i < tw; i++) walls[i] = frame->barrier[(size_t)ty * W + tx0 + i];
+            } else {
+                // Promedio del bloque sobre las celdas de fluido
+                for (int i = 0; i < tw; i++) { values[i] = 0.0f; fluid[i] = 0; }
+                int by0 = ty * factor;
+                int by1 = by0 + factor < H ? by0 + factor : H;
+                for (int y = by0; y < by1; y++) {
+                    FieldRow(frame, field, rho_mean, y, cx0, cx1, cells);
+                    const bool *barrier = frame->barrier + (size_t)y * W;
+                    for (int x = cx0; x < cx1; x++) {
+                        int i = (x - cx0) / factor;
+                        if (!barrier[x]) {
+                            values[i] += cells[x - cx0];
+                            fluid[i]++;
+                        }
+                    }
+                }
+                for (int i = 0; i < tw; i++) {
+                    int bx0 = cx0 + i * factor;
+                    int bx1 = bx0 + factor < cx1 ? bx0 + factor : cx1;
+                    int count = (bx1 - bx0) * (by1 - by0);
+                    walls[i] = fluid[i] * 2 < count;
+                    values[i] = fluid[i] > 0 ? values[i] / fluid[i] : lo;
+                }
+            }
+            MapRow(values, walls, tw, lo, scale, table, out);
+        }
+
+        free(fluid);
+        free(cells);
+        free(walls);
+        free(values);
+    }
+}
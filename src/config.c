@@ -0,0 +1,322 @@
+#include "config.h"
+#include "scenario.h"
+#include "solver.h"
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+
+void Config_SetDefaults(RunConfig *cfg) {
+    cfg->scenario = SCENARIO_CIRCLE;
+    cfg->omega = 1.8f;
+    cfg->inlet_velocity = 0.06f;
+    cfg->width = DEFAULT_GRID_W;
+    cfg->height = DEFAULT_GRID_H;
+    cfg->steps = 10000;
+    cfg->log_period = 100;
+    cfg->snapshot_period = 0;
+    cfg->snapshot_csv = false;
+    Snapshot_DefaultOptions(&cfg->snapshot);
+    cfg->perf_period = 1000;
+    cfg->forces_period = 0;
+    cfg->threads = 0;
+    cfg->huge_pages = HUGE_PAGES_OFF;
+    cfg->layout = LAYOUT_SOA;
+    cfg->isa = ISA_AVX512;
+    cfg->sparse_threshold = SOLVER_DEFAULT_SPARSE_THRESHOLD;
+    cfg->in_place = false;
+    cfg->precision = PRECISION_FP32;
+    cfg->block_depth = 1;
+    cfg->refine_levels = 0;
+    cfg->converge_tol = 0.0f;
+    cfg->converge_period = 100;
+    cfg->warm_start.levels = 0;
+    cfg->warm_start.tolerance = 1e-4f;
+    cfg->warm_start.check_period = 100;
+    cfg->warm_start.max_steps = 20000;
+    cfg->probes_file[0] = '\0';
+    snprintf(cfg->probes_output, sizeof(cfg->probes_output), "probes.bin");
+    cfg->probe_period = 1;
+    cfg->live_feed[0] = '\0';
+    cfg->live_period = 10;
+    cfg->live_frames = 4;
+    cfg->profile_period = 0;
+    cfg->profile_trace[0] = '\0';
+    cfg->profile_counters = false;
+    cfg->checkpoint_period = 0;
+    snprintf(cfg->checkpoint_file, sizeof(cfg->checkpoint_file), "checkpoint.hckp");
+    cfg->restart_file[0] = '\0';
+}
+
+bool Config_ParseInt(const char *text, int *out, int minimum) {
+    char *end;
+    long val = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || val < minimum || val > INT_MAX) return false;
+    *out = (int)val;
+    return true;
+}
+
+bool Config_ParseSize(const char *text, int *width, int *height) {
+    char *end;
+    long w = strtol(text, &end, 10);
+    long h = w;
+    if (end == text) return false;
+    if (*end == 'x') {
+        const char *rest = end + 1;
+        h = strtol(rest, &end, 10);
+        if (end == rest) return false;
+    }
+    if (*end != '\0' || w < 3 || h < 3 || w > INT_MAX || h > INT_MAX) return false;
+    *width = (int)w;
+    *height = (int)h;
+    return true;
+}
+
+int Config_NextEvent(int step, int period, int limit) {
+    if (period <= 0) return limit;
+    int next = (step / period + 1) * period;
+    return next < limit ? next : limit;
+}
+
+static bool ParseInt(const char *text, int *out) {
+    return Config_ParseInt(text, out, INT_MIN);
+}
+
+static bool ParseFloat(const char *text, float *out) {
+    char *end;
+    float val = strtof(text, &end);
+    if (end == text || *end != '\0') return false;
+    *out = val;
+    return true;
+}
+
+static bool ParsePath(const char *text, char *out, size_t size) {
+    if (text[0] == '\0' || strlen(text) >= size) return false;
+    memcpy(out, text, strlen(text) + 1);
+    return true;
+}
+
+static bool ParseScenario(const char *text, int *out) {
+    if (ParseScenarioName(text, out)) return true;
+    return ParseInt(text, out) && *out >= SCENARIO_NONE && *out <= SCENARIO_WALL;
+}
+
+static bool ParseSnapshotFormat(const char *text, bool *csv) {
+    if (strcmp(text, "bin") == 0) { *csv = false; return true; }
+    if (strcmp(text, "csv") == 0) { *csv = true;  return true; }
+    return false;
+}
+
+// "x0,y0,x1,y1" (celdas, x1 e y1 excluidos)
+static bool ParseRegion(const char *text, SnapshotOptions *o) {
+    int x0, y0, x1, y1;
+    char extra;
+    if (sscanf(text, "%d,%d,%d,%d%c", &x0, &y0, &x1, &y1, &extra) != 4) return false;
+    if (x0 < 0 || y0 < 0 || x1 <= x0 || y1 <= y0) return false;
+    o->roi_x0 = x0; o->roi_y0 = y0; o->roi_x1 = x1; o->roi_y1 = y1;
+    return true;
+}
+
+static bool ParseQuantBits(const char *text, int *bits) {
+    if (!ParseInt(text, bits)) return false;
+    return *bits == 32 || *bits == 16 || *bits == 8;
+}
+
+static bool ParseCompression(const char *text, int *compression) {
+    if (strcmp(text, "none") == 0) { *compression = SNAPSHOT_RAW;  return true; }
+    if (strcmp(text, "zlib") == 0) { *compression = SNAPSHOT_ZLIB; return true; }
+    return false;
+}
+
+static bool ParseHugePages(const char *text, int *mode) {
+    if (strcmp(text, "off") == 0)      { *mode = HUGE_PAGES_OFF;      return true; }
+    if (strcmp(text, "thp") == 0)      { *mode = HUGE_PAGES_THP;      return true; }
+    if (strcmp(text, "explicit") == 0) { *mode = HUGE_PAGES_EXPLICIT; return true; }
+    return false;
+}
+
+static bool ParseSwitch(const char *text, bool *on) {
+    if (strcmp(text, "on") == 0)  { *on = true;  return true; }
+    if (strcmp(text, "off") == 0) { *on = false; return true; }
+    return false;
+}
+
+static bool ParseStreaming(const char *text, bool *in_place) {
+    if (strcmp(text, "two-buffer") == 0) { *in_place = false; return true; }
+    if (strcmp(text, "in-place") == 0)   { *in_place = true;  return true; }
+    return false;
+}
+
+static bool ParsePrecision(const char *text, int *out) {
+    if (strcmp(text, "fp32") == 0) { *out = PRECISION_FP32; return true; }
+    if (strcmp(text, "fp16") == 0) { *out = PRECISION_FP16; return true; }
+    return false;
+}
+
+static bool ParseLayout(const char *text, int *out) {
+    if (strcmp(text, "aos") == 0) { *out = LAYOUT_AOS; return true; }
+    if (strcmp(text, "soa") == 0) { *out = LAYOUT_SOA; return true; }
+    return false;
+}
+
+static bool ParseIsa(const char *text, int *out) {
+    if (strcmp(text, "scalar") == 0) { *out = ISA_SCALAR; return true; }
+    if (strcmp(text, "avx2") == 0)   { *out = ISA_AVX2;   return true; }
+    if (strcmp(text, "avx512") == 0 || strcmp(text, "auto") == 0) { *out = ISA_AVX512; return true; }
+    return false;
+}
+
+// Aplica una opción (sin el prefijo "--")
+static bool SetOption(RunConfig *cfg, const char *key, const char *value) {
+    bool ok;
+    if (strcmp(key, "scenario") == 0)             ok = ParseScenario(value, &cfg->scenario);
+    else if (strcmp(key, "omega") == 0)           ok = ParseFloat(value, &cfg->omega);
+    else if (strcmp(key, "velocity") == 0)        ok = ParseFloat(value, &cfg->inlet_velocity);
+    else if (strcmp(key, "width") == 0)           ok = ParseInt(value, &cfg->width);
+    else if (strcmp(key, "height") == 0)          ok = ParseInt(value, &cfg->height);
+    else if (strcmp(key, "steps") == 0)           ok = ParseInt(value, &cfg->steps);
+    else if (strcmp(key, "log-every") == 0)       ok = ParseInt(value, &cfg->log_period);
+    else if (strcmp(key, "snapshot-every") == 0)  ok = ParseInt(value, &cfg->snapshot_period);
+    else if (strcmp(key, "snapshot-format") == 0) ok = ParseSnapshotFormat(value, &cfg->snapshot_csv);
+    else if (strcmp(key, "snapshot-stride") == 0) ok = ParseInt(value, &cfg->snapshot.stride) && cfg->snapshot.stride >= 1;
+    else if (strcmp(key, "snapshot-roi") == 0)    ok = ParseRegion(value, &cfg->snapshot);
+    else if (strcmp(key, "snapshot-bits") == 0)   ok = ParseQuantBits(value, &cfg->snapshot.quant_bits);
+    else if (strcmp(key, "snapshot-compression") == 0) ok = ParseCompression(value, &cfg->snapshot.compression);
+    else if (strcmp(key, "perf-every") == 0)      ok = ParseInt(value, &cfg->perf_period);
+    else if (strcmp(key, "forces-every") == 0)    ok = ParseInt(value, &cfg->forces_period);
+    else if (strcmp(key, "threads") == 0)         ok = ParseInt(value, &cfg->threads);
+    else if (strcmp(key, "huge-pages") == 0)      ok = ParseHugePages(value, &cfg->huge_pages);
+    else if (strcmp(key, "layout") == 0)          ok = ParseLayout(value, &cfg->layout);
+    else if (strcmp(key, "isa") == 0)             ok = ParseIsa(value, &cfg->isa);
+    else if (strcmp(key, "sparse-threshold") == 0) ok = ParseFloat(value, &cfg->sparse_threshold);
+    else if (strcmp(key, "streaming") == 0)       ok = ParseStreaming(value, &cfg->in_place);
+    else if (strcmp(key, "precision") == 0)       ok = ParsePrecision(value, &cfg->precision);
+    else if (strcmp(key, "temporal-block") == 0)  ok = ParseInt(value, &cfg->block_depth);
+    else if (strcmp(key, "refine") == 0)          ok = ParseInt(value, &cfg->refine_levels) && cfg->refine_levels >= 0;
+    else if (strcmp(key, "converge-tol") == 0)    ok = ParseFloat(value, &cfg->converge_tol);
+    else if (strcmp(key, "converge-every") == 0)  ok = ParseInt(value, &cfg->converge_period);
+    else if (strcmp(key, "warm-start") == 0)      ok = ParseInt(value, &cfg->warm_start.levels) && cfg->warm_start.levels >= 0;
+    else if (strcmp(key, "warm-start-tol") == 0)  ok = ParseFloat(value, &cfg->warm_start.tolerance);
+    else if (strcmp(key, "warm-start-steps") == 0) ok = ParseInt(value, &cfg->warm_start.max_steps);
+    else if (strcmp(key, "probes") == 0)          ok = ParsePath(value, cfg->probes_file, sizeof(cfg->probes_file));
+    else if (strcmp(key, "probe-output") == 0)    ok = ParsePath(value, cfg->probes_output, sizeof(cfg->probes_output));
+    else if (strcmp(key, "probe-every") == 0)     ok = ParseInt(value, &cfg->probe_period);
+    else if (strcmp(key, "live") == 0)            ok = ParsePath(value, cfg->live_feed, sizeof(cfg->live_feed));
+    else if (strcmp(key, "live-every") == 0)      ok = ParseInt(value, &cfg->live_period) && cfg->live_period >= 1;
+    else if (strcmp(key, "live-frames") == 0)     ok = ParseInt(value, &cfg->live_frames);
+    else if (strcmp(key, "profile-every") == 0)   ok = ParseInt(value, &cfg->profile_period);
+    else if (strcmp(key, "profile-trace") == 0)   ok = ParsePath(value, cfg->profile_trace, sizeof(cfg->profile_trace));
+    else if (strcmp(key, "profile-counters") == 0) ok = ParseSwitch(value, &cfg->profile_counters);
+    else if (strcmp(key, "checkpoint-every") == 0) ok = ParseInt(value, &cfg->checkpoint_period);
+    else if (strcmp(key, "checkpoint-file") == 0) ok = ParsePath(value, cfg->checkpoint_file, sizeof(cfg->checkpoint_file));
+    else if (strcmp(key, "restart") == 0)         ok = ParsePath(value, cfg->restart_file, sizeof(cfg->restart_file));
+    else {
+        fprintf(stderr, "Opcion desconocida: %s\n", key);
+        return false;
+    }
+    if (!ok) fprintf(stderr, "Valor invalido para %s: %s\n", key, value);
+    return ok;
+}
+
+// Recorta espacios al inicio y al final (modifica el buffer)
+static char *Trim(char *s) {
+    while (isspace((unsigned char)*s)) s++;
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    return s;
+}
+
+bool Config_LoadFile(RunConfig *cfg, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "No se pudo abrir %s\n", path);
+        return false;
+    }
+
+    char line[256];
+    int line_number = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), f) != NULL) {
+        line_number++;
+        char *text = Trim(line);
+        if (text[0] == '\0' || text[0] == '#') continue;
+
+        char *eq = strchr(text, '=');
+        if (eq == NULL) {
+            fprintf(stderr, "%s:%d: se esperaba 'clave = valor'\n", path, line_number);
+            ok = false;
+            break;
+        }
+        *eq = '\0';
+        ok = SetOption(cfg, Trim(text), Trim(eq + 1));
+    }
+    fclose(f);
+    return ok;
+}
+
+bool Config_ParseArgs(RunConfig *cfg, int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--", 2) != 0) {
+            fprintf(stderr, "Argumento inesperado: %s\n", arg);
+            return false;
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Falta el valor de %s\n", arg);
+            return false;
+        }
+        const char *value = argv[++i];
+        bool ok = (strcmp(arg, "--config") == 0) ? Config_LoadFile(cfg, value)
+                                                 : SetOption(cfg, arg + 2, value);
+        if (!ok) return false;
+    }
+    return true;
+}
+
+void Config_PrintUsage(const char *program) {
+    printf("Uso: %s [opciones]\n", program);
+    printf("  --config ARCHIVO        lee opciones 'clave = valor' desde un archivo\n");
+    printf("  --scenario NOMBRE       none | circle | square | wall (o 0..3)\n");
+    printf("  --omega VALOR           parametro de relajacion (0.1 - 1.99)\n");
+    printf("  --velocity VALOR        velocidad de entrada (0 - 0.5)\n");
+    printf("  --width N --height N    tamaño de la grilla\n");
+    printf("  --steps N               pasos a simular\n");
+    printf("  --log-every N           metricas globales cada N pasos (0 = nunca)\n");
+    printf("  --snapshot-every N      snapshot completo cada N pasos (0 = nunca)\n");
+    printf("  --snapshot-format bin|csv  binario (python/snapshot.py) o texto\n");
+    printf("  --snapshot-stride N     binario: una celda de cada N en cada eje\n");
+    printf("  --snapshot-roi x0,y0,x1,y1  binario: solo esa region (x1, y1 excluidos)\n");
+    printf("  --snapshot-bits 32|16|8 binario: float32 o enteros cuantizados por plano\n");
+    printf("  --snapshot-compression none|zlib  binario: compresion de cada plano\n");
+    printf("  --perf-every N          tiempo de proceso cada N pasos (0 = nunca)\n");
+    printf("  --forces-every N        arrastre, sustentacion y Strouhal cada N pasos (0 = nunca)\n");
+    printf("  --threads N             hilos del solver (0 = todos los nucleos)\n");
+    printf("  --huge-pages off|thp|explicit  paginas grandes para poblaciones y campos (menos fallos de TLB)\n");
+    printf("  --layout aos|soa        orden de las poblaciones en memoria (soa = SIMD)\n");
+    printf("  --isa auto|avx512|avx2|scalar  kernel maximo para soa\n");
+    printf("  --sparse-threshold F    fraccion de paredes para guardar solo el fluido (>1 = nunca)\n");
+    printf("  --streaming two-buffer|in-place  in-place = un solo arreglo de poblaciones (mitad de memoria)\n");
+    printf("  --precision fp32|fp16   fp16 = poblaciones en half (mitad de memoria, siempre soa)\n");
+    printf("  --temporal-block N      N pasos por barrido de la grilla (mismos resultados, 1 = sin bloqueo)\n");
+    printf("  --refine N              N niveles de bloques 2x mas finos alrededor de las paredes y la estela\n");
+    printf("  --converge-tol F        corta al bajar el residual de F (0 = nunca)\n");
+    printf("  --converge-every N      cada cuantos pasos se mira el residual\n");
+    printf("  --warm-start N          arranca resolviendo en N grillas mas gruesas (mitad, cuarto, ...)\n");
+    printf("  --warm-start-tol F      residual con el que se pasa a la grilla siguiente (por defecto 1e-4)\n");
+    printf("  --warm-start-steps N    tope de pasos en cada grilla gruesa (por defecto 20000)\n");
+    printf("  --probes ARCHIVO        sondas (puntos, lineas, rectangulos) a registrar, ver probes.h\n");
+    printf("  --probe-every N         registro de las sondas cada N pasos (por defecto 1)\n");
+    printf("  --probe-output RUTA     archivo de las sondas (por defecto probes.bin)\n");
+    printf("  --live NOMBRE           publica los campos en memoria compartida (python/livefeed.py)\n");
+    printf("  --live-every N          un cuadro cada N pasos (por defecto 10)\n");
+    printf("  --live-frames N         cuadros del anillo (por defecto 4)\n");
+    printf("  --profile-every N       tiempos por etapa (paso, frontera, snapshots, ...) cada N pasos\n");
+    printf("  --profile-trace RUTA    traza de las etapas para chrome://tracing o Perfetto\n");
+    printf("  --profile-counters on|off  ciclos, IPC y fallos de cache en el resumen (perf_event_open)\n");
+    printf("  --checkpoint-every N    guarda el estado completo cada N pasos (0 = nunca)\n");
+    printf("  --checkpoint-file RUTA  archivo del checkpoint (por defecto checkpoint.hckp)\n");
+    printf("  --restart RUTA          retoma desde un checkpoint hasta llegar a --steps\n");
+}
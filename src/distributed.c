@@ -0,0 +1,209 @@
+#include "distributed.h"
+#include "solver.h"
+#include "solver_internal.h"
+#include "lattice.h"
+#include "scenario.h"
+#include "snapshot.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Poblaciones que cruzan un borde horizontal: las que suben (cy = +1) y las
+// que bajan (cy = -1)
+#define HALO_POPS 3
+static const int UP[HALO_POPS] = {2, 5, 6};
+static const int DOWN[HALO_POPS] = {4, 7, 8};
+
+// Etiquetas según el sentido en que viaja el mensaje
+#define TAG_UP 1
+#define TAG_DOWN 2
+
+// Partes en que se corta el cálculo de las filas internas para llamar a
+// MPI_Testall en el medio: sin eso los mensajes grandes (protocolo
+// rendezvous) no avanzan hasta el MPI_Waitall
+#define PROGRESS_CHUNKS 8
+
+bool Distributed_Init(DistributedSolver *d, MPI_Comm comm, int width, int height) {
+    memset(d, 0, sizeof(*d));
+    d->comm = comm;
+    MPI_Comm_rank(comm, &d->rank);
+    MPI_Comm_size(comm, &d->size);
+    if (height < d->size) return false;
+
+    // Franjas contiguas, mismo reparto que las bandas de hilos del solver
+    d->global_width = width;
+    d->global_height = height;
+    d->y_offset = (int)((long)height * d->rank / d->size);
+    d->rows = (int)((long)height * (d->rank + 1) / d->size) - d->y_offset;
+    d->ghost_below = d->rank > 0;
+    d->ghost_above = d->rank < d->size - 1;
+
+    Solver_Init(&d->state, width, d->rows + d->ghost_below + d->ghost_above);
+    // Los bordes se empaquetan desde la grilla densa
+    Solver_SetSparseThreshold(&d->state, 2.0f);
+
+    size_t halo = (size_t)HALO_POPS * width;
+    d->send_below = (float*)malloc(halo * sizeof(float));
+    d->send_above = (float*)malloc(halo * sizeof(float));
+    d->recv_below = (float*)malloc(halo * sizeof(float));
+    d->recv_above = (float*)malloc(halo * sizeof(float));
+    return true;
+}
+
+void Distributed_InitScenario(DistributedSolver *d, int type) {
+    // Las filas fantasmas también llevan sus paredes (rebote en el borde)
+    InitScenarioRows(&d->state, type, d->global_height, d->y_offset - d->ghost_below);
+}
+
+// Copia las poblaciones 'dirs' de la fila local y de f a/desde un buffer
+static void PackRow(const SimulationState *state, int y, const int dirs[HALO_POPS], float *out) {
+    int W = state->width;
+    for (int j = 0; j < HALO_POPS; j++) {
+        for (int x = 0; x < W; x++) out[j * W + x] = state->f[PopIndex(state, y * W + x, dirs[j])];
+    }
+}
+
+static void UnpackRow(SimulationState *state, int y, const int dirs[HALO_POPS], const float *in) {
+    int W = state->width;
+    for (int j = 0; j < HALO_POPS; j++) {
+        for (int x = 0; x < W; x++) state->f[PopIndex(state, y * W + x, dirs[j])] = in[j * W + x];
+    }
+}
+
+void Distributed_Step(DistributedSolver *d) {
+    SimulationState *s = &d->state;
+    int count = HALO_POPS * s->width;
+    int first = d->ghost_below;          // Filas locales propias: [first, last]
+    int last = first + d->rows - 1;
+    MPI_Request requests[4];
+    int n = 0;
+
+    Solver_BeginStep(s);
+
+    // f tiene las post-colisión del paso anterior: las filas de borde propias
+    // van a las fantasmas de los vecinos
+    if (d->ghost_below) {
+        MPI_Irecv(d->recv_below, count, MPI_FLOAT, d->rank - 1, TAG_UP, d->comm, &requests[n++]);
+        PackRow(s, first, DOWN, d->send_below);
+        MPI_Isend(d->send_below, count, MPI_FLOAT, d->rank - 1, TAG_DOWN, d->comm, &requests[n++]);
+    }
+    if (d->ghost_above) {
+        MPI_Irecv(d->recv_above, count, MPI_FLOAT, d->rank + 1, TAG_DOWN, d->comm, &requests[n++]);
+        PackRow(s, last, UP, d->send_above);
+        MPI_Isend(d->send_above, count, MPI_FLOAT, d->rank + 1, TAG_UP, d->comm, &requests[n++]);
+    }
+
+    // Filas que no leen las fantasmas, mientras viajan los bordes
+    int inner = last - first - 1;
+    int done = 0;
+    for (int c = 0; c < PROGRESS_CHUNKS; c++) {
+        int y0 = first + 1 + (int)((long)inner * c / PROGRESS_CHUNKS);
+        int y1 = first + 1 + (int)((long)inner * (c + 1) / PROGRESS_CHUNKS);
+        Solver_StepRange(s, y0, y1);
+        if (!done && n > 0) MPI_Testall(n, requests, &done, MPI_STATUSES_IGNORE);
+    }
+    MPI_Waitall(n, requests, MPI_STATUSES_IGNORE);
+
+    if (d->ghost_below) UnpackRow(s, first - 1, UP, d->recv_below);
+    if (d->ghost_above) UnpackRow(s, last + 1, DOWN, d->recv_above);
+    Solver_StepRange(s, first, first + 1);
+    if (last > first) Solver_StepRange(s, last, last + 1);
+
+    Solver_EndStep(s);
+}
+
+void Distributed_ReduceDiagnostics(DistributedSolver *d, SolverDiagnostics *out) {
+    SimulationState *s = &d->state;
+    SolverDiagnostics local = s->diagnostics;
+
+    if (local.step != s->time_step) {
+        // Sin métricas del solver: pasada sobre las filas propias
+        int W = s->width;
+        int i0 = d->ghost_below * W;
+        int i1 = i0 + d->rows * W;
+        local.mass = 0.0;
+        local.kinetic_energy = 0.0;
+        local.max_velocity = 0.0f;
+        local.velocity_change2 = 0.0;
+        local.velocity_norm2 = 0.0;
+        float max_usq = 0.0f;
+        for (int i = i0; i < i1; i++) {
+            float usq = s->ux[i]*s->ux[i] + s->uy[i]*s->uy[i];
+            local.mass += s->rho[i];
+            local.kinetic_energy += 0.5 * s->rho[i] * usq;
+            if (!s->barrier[i] && usq > max_usq) max_usq = usq;
+        }
+        local.max_velocity = sqrtf(max_usq);
+    }
+
+    double sums[4] = { local.mass, local.kinetic_energy, local.velocity_change2, local.velocity_norm2 };
+    double total[4];
+    MPI_Allreduce(sums, total, 4, MPI_DOUBLE, MPI_SUM, d->comm);
+    MPI_Allreduce(&local.max_velocity, &out->max_velocity, 1, MPI_FLOAT, MPI_MAX, d->comm);
+
+    out->step = s->time_step;
+    out->mass = total[0];
+    out->kinetic_energy = total[1];
+    out->velocity_change2 = total[2];
+    out->velocity_norm2 = total[3];
+    out->residual = total[3] > 0.0 ? sqrt(total[2] / total[3]) : 0.0;
+}
+
+bool Distributed_WriteSnapshot(DistributedSolver *d, const char *filename, int time_step) {
+    SimulationState *s = &d->state;
+    MPI_File file;
+    if (MPI_File_open(d->comm, filename, MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                      MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+        return false;
+    }
+
+    // Planos de la grilla global; cada proceso escribe su tramo de filas
+    MPI_Offset N = (MPI_Offset)d->global_width * d->global_height;
+    MPI_Offset total = (MPI_Offset)sizeof(SnapshotHeader) + N * (3 * (MPI_Offset)sizeof(float) + 1);
+    bool ok = MPI_File_set_size(file, total) == MPI_SUCCESS;
+
+    if (d->rank == 0) {
+        SnapshotHeader h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, SNAPSHOT_MAGIC, 4);
+        h.version = SNAPSHOT_VERSION;
+        h.header_size = sizeof(SnapshotHeader);
+        h.width = d->global_width;
+        h.height = d->global_height;
+        h.step = time_step;
+        h.omega = s->omega;
+        h.inlet_velocity = s->inlet_velocity;
+        ok = ok && MPI_File_write_at(file, 0, &h, sizeof(h), MPI_BYTE, MPI_STATUS_IGNORE) == MPI_SUCCESS;
+    }
+
+    int W = s->width;
+    int count = d->rows * W;
+    size_t local = (size_t)d->ghost_below * W; // Primera celda propia
+    MPI_Offset row = (MPI_Offset)d->y_offset * W;
+    const float *planes[3] = { s->rho + local, s->ux + local, s->uy + local };
+    for (int p = 0; p < 3; p++) {
+        MPI_Offset offset = (MPI_Offset)sizeof(SnapshotHeader) + (p * N + row) * (MPI_Offset)sizeof(float);
+        ok = MPI_File_write_at_all(file, offset, planes[p], count, MPI_FLOAT, MPI_STATUS_IGNORE) == MPI_SUCCESS && ok;
+    }
+
+    unsigned char *barrier = (unsigned char*)malloc((size_t)count);
+    for (int i = 0; i < count; i++) barrier[i] = s->barrier[local + i] ? 1 : 0;
+    MPI_Offset offset = (MPI_Offset)sizeof(SnapshotHeader) + 3 * N * (MPI_Offset)sizeof(float) + row;
+    ok = MPI_File_write_at_all(file, offset, barrier, count, MPI_BYTE, MPI_STATUS_IGNORE) == MPI_SUCCESS && ok;
+    free(barrier);
+
+    ok = MPI_File_close(&file) == MPI_SUCCESS && ok;
+
+    // Todos devuelven lo mismo
+    int local_ok = ok, all_ok = 0;
+    MPI_Allreduce(&local_ok, &all_ok, 1, MPI_INT, MPI_LAND, d->comm);
+    return all_ok != 0;
+}
+
+void Distributed_Cleanup(DistributedSolver *d) {
+    Solver_Cleanup(&d->state);
+    free(d->send_below);
+    free(d->send_above);
+    free(d->recv_below);
+    free(d->recv_above);
+}
@@ -0,0 +1,259 @@
+// Corrida batch sin ventana ni raylib: Solver_Step en un loop cerrado,
+// sin el límite de 60 FPS x 4 pasos del modo interactivo.
+#include "state.h"
+#include "solver.h"
+#include "analysis.h"
+#include "scenario.h"
+#include "snapshot.h"
+#include "config.h"
+#include "checkpoint.h"
+#include "probes.h"
+#include "livefeed.h"
+#include "profile.h"
+#include "arena.h"
+#include "refine.h"
+#include "warmstart.h"
+#include "timer.h"
+#include <stdio.h>
+#include <string.h>
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            Config_PrintUsage(argv[0]);
+            return 0;
+        }
+    }
+
+    RunConfig cfg;
+    Config_SetDefaults(&cfg);
+    if (!Config_ParseArgs(&cfg, argc, argv)) {
+        Config_PrintUsage(argv[0]);
+        return 1;
+    }
+
+    if (cfg.width < 3 || cfg.height < 3) {
+        fprintf(stderr, "La grilla debe ser de al menos 3x3 (pedida %dx%d)\n",
+                cfg.width, cfg.height);
+        return 1;
+    }
+    if (cfg.steps < 0 || cfg.log_period < 0 || cfg.snapshot_period < 0 || cfg.perf_period < 0 ||
+        cfg.forces_period < 0 || cfg.checkpoint_period < 0 || cfg.profile_period < 0) {
+        fprintf(stderr, "Los pasos y periodos no pueden ser negativos\n");
+        return 1;
+    }
+    if (cfg.probe_period < 1) {
+        fprintf(stderr, "--probe-every debe ser al menos 1\n");
+        return 1;
+    }
+    if (cfg.converge_period < 1) {
+        fprintf(stderr, "--converge-every debe ser al menos 1\n");
+        return 1;
+    }
+    if (cfg.refine_levels > 0 && (cfg.in_place || cfg.precision != PRECISION_FP32 || cfg.block_depth > 1)) {
+        fprintf(stderr, "--refine no se combina con --streaming in-place, --precision fp16 ni --temporal-block\n");
+        return 1;
+    }
+    // El checkpoint guarda solo la grilla base: al retomar, los bloques no
+    // volverían a quedar como estaban
+    if (cfg.refine_levels > 0 && (cfg.checkpoint_period > 0 || cfg.restart_file[0] != '\0')) {
+        fprintf(stderr, "--refine no se combina con --checkpoint-every ni --restart\n");
+        return 1;
+    }
+
+    // Mismos límites que la edición interactiva de main.c
+    if (cfg.omega < 0.1f) cfg.omega = 0.1f;
+    if (cfg.omega > 1.99f) cfg.omega = 1.99f;
+    if (cfg.inlet_velocity < 0.0f) cfg.inlet_velocity = 0.0f;
+    if (cfg.inlet_velocity > 0.5f) cfg.inlet_velocity = 0.5f;
+
+    // Al retomar, grilla, barrier, omega, velocidad y paso salen del checkpoint
+    bool restart = cfg.restart_file[0] != '\0';
+    Arena_SetHugePages((HugePageMode)cfg.huge_pages);
+    SimulationState state;
+    if (restart) {
+        if (!Checkpoint_Load(&state, cfg.restart_file)) {
+            fprintf(stderr, "No se pudo leer el checkpoint %s\n", cfg.restart_file);
+            return 1;
+        }
+        printf("Retomando %s desde el paso %d\n", cfg.restart_file, state.time_step);
+    } else {
+        Solver_Init(&state, cfg.width, cfg.height);
+        state.omega = cfg.omega;
+        state.inlet_velocity = cfg.inlet_velocity;
+    }
+    Solver_SetThreads(&state, cfg.threads);
+    Solver_SetLayout(&state, (PopulationLayout)cfg.layout);
+    if (cfg.layout == LAYOUT_SOA) Solver_SetIsa(&state, (SolverIsa)cfg.isa);
+    Solver_SetSparseThreshold(&state, cfg.sparse_threshold);
+    Solver_SetTemporalBlocking(&state, cfg.block_depth);
+    if (!restart) {
+        InitScenario(&state, cfg.scenario);
+        // Antes de pasar a half o al patrón AA: el arranque escribe f en float
+        if (cfg.warm_start.levels > 0) {
+            double t0 = Timer_Now();
+            cfg.warm_start.check_period = cfg.converge_period;
+            WarmStart_Run(&state, &cfg.warm_start, stdout);
+            printf("Arranque en grillas gruesas: %.3f s\n", Timer_Now() - t0);
+        }
+    }
+    Solver_SetInPlace(&state, cfg.in_place);
+    Solver_SetPrecision(&state, (PopulationPrecision)cfg.precision);
+
+    RefinedGrid grid;
+    bool refined = cfg.refine_levels > 0;
+    if (refined) {
+        if (!Refine_Init(&grid, &state, cfg.refine_levels, cfg.scenario)) return 1;
+        for (int b = 0; b < grid.num_blocks; b++) {
+            const RefineBlock *block = &grid.blocks[b];
+            printf("Nivel %d: [%d, %d) x [%d, %d) del nivel anterior, %dx%d celdas, omega %.3f\n",
+                   block->level, block->x0, block->x0 + block->w, block->y0, block->y0 + block->h,
+                   block->state.width, block->state.height, block->state.omega);
+        }
+        int scale;
+        Refine_Finest(&grid, &scale);
+        double uniform = (double)state.width * state.height * scale * scale * scale;
+        printf("Celdas actualizadas por paso: %.0f (uniforme a la resolucion mas fina: %.0f, %.1f veces mas)\n",
+               Refine_CellUpdates(&grid), uniform, uniform / Refine_CellUpdates(&grid));
+    }
+
+    // Antes de crear hilos, así cada uno se registra con su nombre
+    if (cfg.profile_period > 0 || cfg.profile_trace[0] != '\0') {
+        Profile_Init(cfg.profile_trace, cfg.profile_counters);
+        Profile_NameThread("main");
+    }
+
+    // Los snapshots binarios se escriben en un hilo aparte
+    SnapshotWriter *snapshots = NULL;
+    if (cfg.snapshot_period > 0 && !cfg.snapshot_csv) snapshots = Snapshot_CreateWriter("", &cfg.snapshot);
+
+    // Cada bloque en sus propios archivos (refine1_snapshot_*.bin, ...), enteros
+    SnapshotWriter *block_snapshots[REFINE_MAX_LEVELS] = {NULL};
+    if (snapshots != NULL && refined) {
+        SnapshotOptions options = cfg.snapshot;
+        options.roi_x0 = options.roi_y0 = options.roi_x1 = options.roi_y1 = 0;
+        for (int b = 0; b < grid.num_blocks; b++) {
+            char prefix[32];
+            snprintf(prefix, sizeof(prefix), "refine%d_", grid.blocks[b].level);
+            block_snapshots[b] = Snapshot_CreateWriter(prefix, &options);
+        }
+    }
+
+    // Al retomar se sigue agregando a los logs de la corrida original
+    if (cfg.log_period > 0 && !restart) Analysis_Init();
+    if (cfg.perf_period > 0 && !restart) Analysis_InitPerformanceLog();
+    if (cfg.forces_period > 0) Analysis_InitForcesLog(restart);
+
+    ProbeRecorder *probes = NULL;
+    if (cfg.probes_file[0] != '\0') {
+        probes = Probes_Create(cfg.probes_file, cfg.probes_output, cfg.probe_period,
+                               state.width, state.height, restart);
+        if (probes == NULL) return 1;
+    }
+
+    LiveFeed *live = NULL;
+    if (cfg.live_feed[0] != '\0') {
+        live = LiveFeed_Create(cfg.live_feed, state.width, state.height, cfg.live_frames, cfg.live_period);
+        if (live == NULL) return 1;
+    }
+
+    printf("Grilla %dx%d, escenario %d, omega %.3f, velocidad %.3f, %d pasos, %d hilos, %s/%s%s%s\n",
+           state.width, state.height, cfg.scenario, state.omega, state.inlet_velocity, cfg.steps,
+           state.num_threads, state.layout == LAYOUT_SOA ? "soa" : "aos",
+           Solver_IsaName((SolverIsa)state.isa), state.in_place ? " en el lugar" : "",
+           state.precision == PRECISION_FP16 ? " fp16" : "");
+
+    // Solo se mide el solver; el I/O de análisis queda fuera del MLUPS
+    double solver_time = 0.0;
+    double perf_accumulated = 0.0;
+
+    int first_step = state.time_step;
+    bool converged = false;
+    while (state.time_step < cfg.steps && !converged) {
+        // Se avanza de una hasta el próximo paso con algo que registrar, así
+        // el bloqueo temporal puede juntar varios pasos por barrido
+        int next = cfg.steps;
+        next = Config_NextEvent(state.time_step, cfg.log_period, next);
+        next = Config_NextEvent(state.time_step, cfg.perf_period, next);
+        next = Config_NextEvent(state.time_step, cfg.forces_period, next);
+        if (probes != NULL) next = Config_NextEvent(state.time_step, cfg.probe_period, next);
+        if (live != NULL) next = Config_NextEvent(state.time_step, cfg.live_period, next);
+        next = Config_NextEvent(state.time_step, cfg.snapshot_period, next);
+        next = Config_NextEvent(state.time_step, cfg.checkpoint_period, next);
+        next = Config_NextEvent(state.time_step, cfg.profile_period, next);
+        if (cfg.converge_tol > 0.0f) next = Config_NextEvent(state.time_step, cfg.converge_period, next);
+
+        // Métricas dentro del barrido del solver en los pasos que se usan
+        bool check = cfg.converge_tol > 0.0f && next % cfg.converge_period == 0;
+        if (check || (cfg.log_period > 0 && next % cfg.log_period == 0) || LiveFeed_Due(live, next)) {
+            Solver_RequestDiagnostics(&state);
+        }
+
+        double t0 = Timer_Now();
+        if (refined) Refine_Advance(&grid, next - state.time_step);
+        else Solver_Advance(&state, next - state.time_step);
+        int step = state.time_step;
+        double dt = Timer_Now() - t0;
+        solver_time += dt;
+        perf_accumulated += dt;
+
+        if (cfg.perf_period > 0 && step % cfg.perf_period == 0) {
+            Analysis_LogPerformance(step, perf_accumulated);
+            perf_accumulated = 0.0;
+        }
+        if (cfg.log_period > 0 && step % cfg.log_period == 0) {
+            Analysis_ComputeAndSave(&state, step);
+        }
+        if (cfg.forces_period > 0 && step % cfg.forces_period == 0) {
+            if (refined) {
+                // Las paredes mejor resueltas están en el bloque más fino
+                int scale;
+                const SimulationState *finest = Refine_Finest(&grid, &scale);
+                Analysis_LogForcesScaled(finest, step, scale);
+            } else {
+                Analysis_LogForces(&state, step);
+            }
+        }
+        Probes_Record(probes, &state, step);
+        LiveFeed_Publish(live, &state, step);
+        if (cfg.snapshot_period > 0 && step % cfg.snapshot_period == 0) {
+            if (snapshots != NULL) Snapshot_Submit(snapshots, &state, step);
+            else Analysis_SaveSnapshot(&state, step);
+            for (int b = 0; refined && b < grid.num_blocks; b++) {
+                if (block_snapshots[b] != NULL) Snapshot_Submit(block_snapshots[b], &grid.blocks[b].state, step);
+            }
+        }
+        if (check && state.diagnostics.residual < cfg.converge_tol) {
+            printf("Convergió en el paso %d (residual %.3e)\n", step, state.diagnostics.residual);
+            converged = true;
+        }
+        if (cfg.checkpoint_period > 0 && (step % cfg.checkpoint_period == 0 || converged)) {
+            uint64_t t = Profile_Begin();
+            if (!Checkpoint_Save(&state, cfg.checkpoint_file)) {
+                fprintf(stderr, "No se pudo escribir el checkpoint %s\n", cfg.checkpoint_file);
+            }
+            Profile_End(PROF_CHECKPOINT, t);
+        }
+        if (cfg.profile_period > 0 && step % cfg.profile_period == 0) Profile_Summary(stdout, step);
+    }
+
+    double updates = (refined ? Refine_CellUpdates(&grid) : (double)state.width * state.height)
+                   * (state.time_step - first_step);
+    double mlups = solver_time > 0.0 ? updates / solver_time * 1e-6 : 0.0;
+    printf("Tiempo del solver: %.3f s\n", solver_time);
+    printf("MLUPS: %.2f\n", mlups);
+    if (state.sparse) {
+        printf("Almacenamiento compacto: %d celdas de fluido de %d\n",
+               state.sparse_lattice.count, state.width * state.height);
+    }
+
+    Snapshot_DestroyWriter(snapshots);
+    for (int b = 0; b < REFINE_MAX_LEVELS; b++) Snapshot_DestroyWriter(block_snapshots[b]);
+    Analysis_CloseForcesLog();
+    Probes_Destroy(probes);
+    LiveFeed_Destroy(live);
+    Profile_Shutdown(); // Con los escritores ya terminados
+    if (refined) Refine_Cleanup(&grid);
+    Solver_Cleanup(&state);
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include "livefeed.h"
+#include "solver.h"
+#include "analysis.h"
+#include "profile.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(PLATFORM_WEB) && !defined(_WIN32)
+#define LIVEFEED_SHM 1
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define LIVEFEED_ALIGN 64
+
+struct LiveFeed {
+    char name[256];         // Con la '/' inicial
+    LiveFeedHeader *header; // Comienzo del segmento mapeado
+    size_t bytes;
+    int width;
+    int height;
+    int num_frames;
+    int period;
+    uint64_t next;          // Próximo cuadro a publicar
+};
+
+static uint64_t AlignUp(uint64_t bytes) {
+    return (bytes + LIVEFEED_ALIGN - 1) / LIVEFEED_ALIGN * LIVEFEED_ALIGN;
+}
+
+static LiveFrameHeader *Frame(const LiveFeed *feed, uint64_t n) {
+    const LiveFeedHeader *h = feed->header;
+    return (LiveFrameHeader*)((unsigned char*)feed->header + h->header_size
+                              + (n % (uint64_t)feed->num_frames) * h->frame_bytes);
+}
+
+#ifdef LIVEFEED_SHM
+LiveFeed *LiveFeed_Create(const char *name, int width, int height, int num_frames, int period) {
+    if (num_frames < 2 || num_frames > LIVEFEED_MAX_FRAMES) {
+        fprintf(stderr, "El anillo del feed en vivo necesita entre 2 y %d cuadros\n", LIVEFEED_MAX_FRAMES);
+        return NULL;
+    }
+    LiveFeed *feed = (LiveFeed*)calloc(1, sizeof(LiveFeed));
+    snprintf(feed->name, sizeof(feed->name), "%s%s", name[0] == '/' ? "" : "/", name);
+    feed->width = width;
+    feed->height = height;
+    feed->num_frames = num_frames;
+    feed->period = period > 0 ? period : 1;
+
+    size_t N = (size_t)width * height;
+    uint64_t header_size = AlignUp(sizeof(LiveFeedHeader));
+    uint64_t frame_header_size = AlignUp(sizeof(LiveFrameHeader));
+    uint64_t plane_bytes = AlignUp(N * sizeof(float));
+    uint64_t frame_bytes = frame_header_size + 3 * plane_bytes + AlignUp(N);
+    feed->bytes = (size_t)(header_size + frame_bytes * num_frames);
+
+    // Un segmento viejo con el mismo nombre se reemplaza: quien lo tenga
+    // mapeado sigue viendo el viejo (marcado como cerrado o de otro pid)
+    shm_unlink(feed->name);
+    int fd = shm_open(feed->name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0 || ftruncate(fd, (off_t)feed->bytes) != 0) {
+        fprintf(stderr, "No se pudo crear la memoria compartida %s: %s\n", feed->name, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+            shm_unlink(feed->name);
+        }
+        free(feed);
+        return NULL;
+    }
+    void *p = mmap(NULL, feed->bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        fprintf(stderr, "No se pudo mapear la memoria compartida %s: %s\n", feed->name, strerror(errno));
+        shm_unlink(feed->name);
+        free(feed);
+        return NULL;
+    }
+
+    // ftruncate deja todo en cero: ningún cuadro publicado
+    LiveFeedHeader *h = (LiveFeedHeader*)p;
+    h->version = LIVEFEED_VERSION;
+    h->header_size = (uint32_t)header_size;
+    h->frame_header_size = (uint32_t)frame_header_size;
+    h->width = width;
+    h->height = height;
+    h->num_frames = num_frames;
+    h->period = feed->period;
+    h->frame_bytes = frame_bytes;
+    h->plane_bytes = plane_bytes;
+    h->writer_pid = (int32_t)getpid();
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(h->magic, LIVEFEED_MAGIC, 4);
+    feed->header = h;
+    return feed;
+}
+
+void LiveFeed_Destroy(LiveFeed *feed) {
+    if (feed == NULL) return;
+    __atomic_store_n(&feed->header->closed, 1, __ATOMIC_RELEASE);
+    munmap(feed->header, feed->bytes);
+    shm_unlink(feed->name);
+    free(feed);
+}
+#else
+LiveFeed *LiveFeed_Create(const char *name, int width, int height, int num_frames, int period) {
+    (void)width; (void)height; (void)num_frames; (void)period;
+    fprintf(stderr, "Sin memoria compartida POSIX en esta plataforma: no hay feed en vivo (%s)\n", name);
+    return NULL;
+}
+
+void LiveFeed_Destroy(LiveFeed *feed) {
+    (void)feed;
+}
+#endif
+
+bool LiveFeed_Due(const LiveFeed *feed, int time_step) {
+    return feed != NULL && time_step % feed->period == 0;
+}
+
+void LiveFeed_Publish(LiveFeed *feed, const SimulationState *state, int time_step) {
+    if (!LiveFeed_Due(feed, time_step)) return;
+    uint64_t t = Profile_Begin();
+    const LiveFeedHeader *h = feed->header;
+    uint64_t n = feed->next++;
+    LiveFrameHeader *frame = Frame(feed, n);
+
+    // Seqlock: impar mientras se escribe. La barrera ordena ese valor antes
+    // que los datos; el lector que lo vea par dos veces leyó un cuadro entero.
+    __atomic_store_n(&frame->sequence, 2 * n + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    frame->step = time_step;
+    frame->omega = state->omega;
+    frame->inlet_velocity = state->inlet_velocity;
+    const SolverDiagnostics *d = &state->diagnostics;
+    if (d->step == time_step) {
+        frame->max_velocity = d->max_velocity;
+        frame->mass = d->mass;
+        frame->kinetic_energy = d->kinetic_energy;
+        frame->residual = d->residual;
+    } else {
+        frame->max_velocity = NAN;
+        frame->mass = NAN;
+        frame->kinetic_energy = NAN;
+        frame->residual = NAN;
+    }
+    Solver_ComputeForces(state, &frame->fx, &frame->fy);
+    Analysis_ForceCoefficients(state, frame->fx, frame->fy, &frame->cd, &frame->cl);
+
+    size_t N = (size_t)feed->width * feed->height;
+    unsigned char *planes = (unsigned char*)frame + h->frame_header_size;
+    memcpy(planes, state->rho, N * sizeof(float));
+    memcpy(planes + h->plane_bytes, state->ux, N * sizeof(float));
+    memcpy(planes + 2 * h->plane_bytes, state->uy, N * sizeof(float));
+    memcpy(planes + 3 * h->plane_bytes, state->barrier, N * sizeof(bool));
+
+    __atomic_store_n(&frame->sequence, 2 * n + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&feed->header->published, n + 1, __ATOMIC_RELEASE);
+    Profile_EndItems(PROF_LIVE, t, N * (3 * sizeof(float) + 1));
+}
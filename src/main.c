@@ -3,9 +3,18 @@
 #include "solver.h"
 #include "renderer.h"
 #include "analysis.h" 
+#include "scenario.h"
+#include "config.h"
+#include "snapshot.h"
+#include "checkpoint.h"
+#include "sim_thread.h"
+#include "livefeed.h"
+#include "profile.h"
+#include "arena.h"
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 
 #if defined(PLATFORM_WEB)
     #include <emscripten/emscripten.h>
@@ -13,10 +22,12 @@
 
 SimulationState state;
 RenderContext ctx;
+SnapshotWriter *snapshots = NULL; // Escritura de snapshots en segundo plano
+SimThread *sim = NULL; // Hilo del solver: desde que arranca, 'state' es suyo
+ProbeRecorder *probes = NULL; // Sondas (--probes)
+LiveFeed *live = NULL; // Feed en vivo en memoria compartida (--live)
 
 bool simulation_running = false; // Control de estado de la simulación
-int time_step_counter = 0; // Contador global de pasos
-double solver_accumulated_time = 0.0; // Acumulador de tiempo de procesamiento
 
 // Input buffer para Omega
 char omega_str[32] = "1.80"; 
@@ -34,49 +45,12 @@ char snapshot_str[32] = "1000";
 int snapshot_char_count = 4;
 int snapshot_period = 1000;
 
-void ResetBarriers(SimulationState *state) {
-    for(int i=0; i<GRID_W*GRID_H; i++) {
-        state->barrier[i] = false;
-    }
-}
-
-void InitScenario(SimulationState *state, int type) {
-    ResetBarriers(state);
-    int cx = GRID_W / 3; // Un poco a la izquierda
-    int cy = GRID_H / 2;
-
-    if (type == 1) { // Círculo
-        int r = GRID_H / 8;
-        for(int y=0; y<GRID_H; y++) {
-            for(int x=0; x<GRID_W; x++) {
-                if ((x-cx)*(x-cx) + (y-cy)*(y-cy) <= r*r) {
-                    state->barrier[idx(x,y)] = true;
-                }
-            }
-        }
-    } else if (type == 2) { // Cuadrado
-        int r = GRID_H / 8;
-        for(int y=cy-r; y<=cy+r; y++) {
-            for(int x=cx-r; x<=cx+r; x++) {
-                if(x>=0 && x<GRID_W && y>=0 && y<GRID_H)
-                    state->barrier[idx(x,y)] = true;
-            }
-        }
-    } else if (type == 3) { // Pared Vertical
-        int w = 10;
-        int h = GRID_H / 2;
-        for(int y=cy-h/2; y<=cy+h/2; y++) {
-            for(int x=cx; x<cx+w; x++) {
-                 if(x>=0 && x<GRID_W && y>=0 && y<GRID_H)
-                    state->barrier[idx(x,y)] = true;
-            }
-        }
-    }
-}
-
 void UpdateDrawFrame(void) {
+    // Último cuadro que publicó el solver
+    const FieldFrame *frame = SimThread_AcquireFrame(sim);
+
     // 1. Input (Interacción del usuario)
-    Renderer_HandleInput(&state);
+    Renderer_HandleInput(&ctx, sim);
     
     // Control de inicio de simulación
     if (!simulation_running) {
@@ -96,12 +70,14 @@ void UpdateDrawFrame(void) {
 
         if (edit_mode == 1) {
             // -- EDITAR OMEGA --
+            bool changed = false;
             int key = GetCharPressed();
             while (key > 0) {
                 if (((key >= 48 && key <= 57) || key == 46) && (omega_char_count < 10)) {
                     omega_str[omega_char_count] = (char)key;
                     omega_str[omega_char_count+1] = '\0';
                     omega_char_count++;
+                    changed = true;
                 }
                 key = GetCharPressed();
             }
@@ -109,22 +85,25 @@ void UpdateDrawFrame(void) {
                 if (omega_char_count > 0) {
                     omega_char_count--;
                     omega_str[omega_char_count] = '\0';
+                    changed = true;
                 }
             }
             // Actualizar Omega
             float val = (float)atof(omega_str);
             if (val < 0.1f) val = 0.1f;
             if (val > 1.99f) val = 1.99f;
-            state.omega = val;
+            if (changed) SimThread_Send(sim, (SimCommand){SIM_CMD_OMEGA, 0, 0, 0, val});
 
         } else if (edit_mode == 2) {
              // -- EDITAR VELOCIDAD --
+            bool changed = false;
             int key = GetCharPressed();
             while (key > 0) {
                 if (((key >= 48 && key <= 57) || key == 46) && (velocity_char_count < 10)) {
                     velocity_str[velocity_char_count] = (char)key;
                     velocity_str[velocity_char_count+1] = '\0';
                     velocity_char_count++;
+                    changed = true;
                 }
                 key = GetCharPressed();
             }
@@ -132,16 +111,18 @@ void UpdateDrawFrame(void) {
                 if (velocity_char_count > 0) {
                     velocity_char_count--;
                     velocity_str[velocity_char_count] = '\0';
+                    changed = true;
                 }
             }
             // Actualizar Velocidad
             float val = (float)atof(velocity_str);
             if (val < 0.0f) val = 0.0f;
             if (val > 0.5f) val = 0.5f; // Limite razonable
-            state.inlet_velocity = val;
+            if (changed) SimThread_Send(sim, (SimCommand){SIM_CMD_VELOCITY, 0, 0, 0, val});
             
         } else if (edit_mode == 3) {
              // -- EDITAR SNAPSHOT --
+            bool changed = false;
             int key = GetCharPressed();
             while (key > 0) {
                 // Solo números para snapshot (sin punto decimal)
@@ -149,6 +130,7 @@ void UpdateDrawFrame(void) {
                     snapshot_str[snapshot_char_count] = (char)key;
                     snapshot_str[snapshot_char_count+1] = '\0';
                     snapshot_char_count++;
+                    changed = true;
                 }
                 key = GetCharPressed();
             }
@@ -156,66 +138,42 @@ void UpdateDrawFrame(void) {
                 if (snapshot_char_count > 0) {
                     snapshot_char_count--;
                     snapshot_str[snapshot_char_count] = '\0';
+                    changed = true;
                 }
             }
             // Actualizar Snapshot Period
             int val = atoi(snapshot_str);
             if (val < 1) val = 1;
             snapshot_period = val;
+            if (changed) SimThread_Send(sim, (SimCommand){SIM_CMD_SNAPSHOT_PERIOD, 0, 0, val, 0.0f});
             
         } else {
             // -- MODO NORMAL --
-            if (IsKeyPressed(KEY_ENTER)) simulation_running = true;
+            if (IsKeyPressed(KEY_ENTER)) {
+                simulation_running = true;
+                SimThread_Send(sim, (SimCommand){SIM_CMD_RUN, 0, 0, 1, 0.0f});
+            }
             
             // Escenarios
-            if (IsKeyPressed(KEY_ONE)) InitScenario(&state, 1); 
-            if (IsKeyPressed(KEY_TWO)) InitScenario(&state, 2); 
-            if (IsKeyPressed(KEY_THREE)) InitScenario(&state, 3); 
-            if (IsKeyPressed(KEY_C)) ResetBarriers(&state);     
+            if (IsKeyPressed(KEY_ONE)) SimThread_Send(sim, (SimCommand){SIM_CMD_SCENARIO, 0, 0, 1, 0.0f});
+            if (IsKeyPressed(KEY_TWO)) SimThread_Send(sim, (SimCommand){SIM_CMD_SCENARIO, 0, 0, 2, 0.0f});
+            if (IsKeyPressed(KEY_THREE)) SimThread_Send(sim, (SimCommand){SIM_CMD_SCENARIO, 0, 0, 3, 0.0f});
+            if (IsKeyPressed(KEY_C)) SimThread_Send(sim, (SimCommand){SIM_CMD_CLEAR, 0, 0, 0, 0.0f});
         }
     }
 
-    // 2. Física y Análisis
-    if (simulation_running) {
-        // Ejecutamos varios pasos de física (ej: 4) por cada frame visual
-        // para que el fluido se mueva más rápido visualmente.
-        int steps_per_frame = 4;
-
-        for(int i=0; i<steps_per_frame; i++) {
-            double t0 = GetTime();
-            Solver_Step(&state);     // Avanza la física
-            double t1 = GetTime();
-            solver_accumulated_time += (t1 - t0);
-
-            time_step_counter++;     // Cuenta el paso
-            
-            if (time_step_counter % 1000 == 0) {
-                Analysis_LogPerformance(time_step_counter, solver_accumulated_time);
-                solver_accumulated_time = 0.0;
-            }
-
-            // --- BLOQUE DE GUARDADO DE DATOS ---
-            
-            // A. Métricas Globales (Energía/Masa) cada 100 pasos
-            // (Esto es ligero, se puede hacer frecuente)
-            if (time_step_counter % 100 == 0) {
-                Analysis_ComputeAndSave(&state, time_step_counter);
-            }
-
-            // B. Snapshots Completos (Archivos grandes) cada 'snapshot_period' pasos
-            if (time_step_counter % snapshot_period == 0) {
-                Analysis_SaveSnapshot(&state, time_step_counter);
-            }
-        }
-    }
+    // 2. Física y Análisis: los pasos, métricas, snapshots y checkpoints
+    // los da el hilo del solver (ver sim_thread.h) sin esperar al dibujo
 
     // 3. Render (Visualización)
     BeginDrawing();
         ClearBackground(BLACK);
-        Renderer_Draw(&ctx, &state);
+        Renderer_Draw(&ctx, frame);
         
         // Información visual extra
-        DrawText(TextFormat("Step: %d", time_step_counter), 10, 50, 10, GREEN);
+        DrawText(TextFormat("Step: %d", frame->time_step), 10, 50, 10, GREEN);
+        if (frame->running) DrawText(TextFormat("Solver: %.1f MLUPS", frame->mlups), 100, 50, 10, GREEN);
+        if (frame->drag != 0.0f) DrawText(TextFormat("Cd: %.3f  Cl: %.3f", frame->drag, frame->lift), 220, 50, 10, GREEN);
         
         if (!simulation_running) {
             DrawText("PAUSED - PRESS ENTER TO START", 10, 70, 20, YELLOW);
@@ -238,22 +196,84 @@ void UpdateDrawFrame(void) {
             DrawText("Presets: [1] Círculo  [2] Cuadrado  [3] Pared  [C] Limpiar", 10, 175, 10, GRAY);
             DrawText("Draw with Mouse Left Click", 10, 190, 10, GRAY);
         } else {
-            if (time_step_counter % snapshot_period < 60) {
+            if (frame->time_step % snapshot_period < 60) {
                 DrawText("GUARDANDO SNAPSHOT...", 10, 65, 10, RED);
             }
         }
     EndDrawing();
 }
 
-int main(void) {
-    InitWindow(800, 800, "Simulador de Fluidos LBM + Analisis");
+int main(int argc, char **argv) {
+    // Tamaño de grilla, hilos y layout desde la línea de comandos (se leen las
+    // opciones de HydroSimHeadless; las que solo sirven en batch se avisan)
+    RunConfig cfg;
+    Config_SetDefaults(&cfg);
+    if (!Config_ParseArgs(&cfg, argc, argv) || cfg.width < 3 || cfg.height < 3) {
+        Config_PrintUsage(argv[0]);
+        return 1;
+    }
+    // La grilla arranca vacía y el hilo da un paso por vez, sin cortar solo
+    if (cfg.warm_start.levels > 0 || cfg.refine_levels > 0 || cfg.block_depth > 1 || cfg.converge_tol > 0.0f) {
+        fprintf(stderr, "Aviso: la versión interactiva ignora --warm-start, --refine, "
+                        "--temporal-block y --converge-tol\n");
+    }
 
-    Solver_Init(&state);
-    Renderer_Init(&ctx);
+    Arena_SetHugePages((HugePageMode)cfg.huge_pages);
+    // Con --restart el tamaño de la grilla sale del checkpoint
+    if (cfg.restart_file[0] != '\0') {
+        if (!Checkpoint_Load(&state, cfg.restart_file)) {
+            fprintf(stderr, "No se pudo leer el checkpoint %s\n", cfg.restart_file);
+            return 1;
+        }
+        cfg.width = state.width;
+        cfg.height = state.height;
+        omega_char_count = snprintf(omega_str, sizeof(omega_str), "%.2f", state.omega);
+        velocity_char_count = snprintf(velocity_str, sizeof(velocity_str), "%.2f", state.inlet_velocity);
+    } else {
+        Solver_Init(&state, cfg.width, cfg.height);
+    }
+
+    // Ventana de hasta 800x800 con la proporción de la grilla
+    // (mínimo 400 de alto para que entre el texto de la interfaz)
+    float scale = fminf(800.0f / cfg.width, 800.0f / cfg.height);
+    int window_w = (int)(cfg.width * scale);
+    int window_h = (int)(cfg.height * scale);
+    if (window_h < 400) window_h = 400;
+    InitWindow(window_w, window_h, "Simulador de Fluidos LBM + Analisis");
+
+    Solver_SetThreads(&state, cfg.threads);
+    Solver_SetLayout(&state, (PopulationLayout)cfg.layout);
+    if (cfg.layout == LAYOUT_SOA) Solver_SetIsa(&state, (SolverIsa)cfg.isa);
+    Solver_SetSparseThreshold(&state, cfg.sparse_threshold);
+    Solver_SetInPlace(&state, cfg.in_place);
+    Solver_SetPrecision(&state, (PopulationPrecision)cfg.precision);
+    Renderer_Init(&ctx, cfg.width, cfg.height);
+
+    // Perfil por etapas (antes de crear hilos): el hilo del solver muestra
+    // el resumen cada --profile-every pasos, como la versión batch
+    if (cfg.profile_period > 0 || cfg.profile_trace[0] != '\0') {
+        Profile_Init(cfg.profile_trace, cfg.profile_counters);
+        Profile_NameThread("interfaz");
+    }
+    if (!cfg.snapshot_csv) snapshots = Snapshot_CreateWriter("", &cfg.snapshot);
     
-    // Inicializar el archivo CSV (escribir encabezados)
-    Analysis_Init(); 
-    Analysis_InitPerformanceLog(); 
+    // Inicializar el archivo CSV (escribir encabezados); al retomar se sigue agregando
+    if (cfg.restart_file[0] == '\0') {
+        Analysis_Init();
+        Analysis_InitPerformanceLog();
+    }
+    if (cfg.forces_period > 0) Analysis_InitForcesLog(cfg.restart_file[0] != '\0');
+    if (cfg.probes_file[0] != '\0') {
+        probes = Probes_Create(cfg.probes_file, cfg.probes_output, cfg.probe_period,
+                               state.width, state.height, cfg.restart_file[0] != '\0');
+    }
+    if (cfg.live_feed[0] != '\0') {
+        live = LiveFeed_Create(cfg.live_feed, state.width, state.height, cfg.live_frames, cfg.live_period);
+    }
+
+    // Desde acá el estado lo maneja el hilo del solver
+    sim = SimThread_Start(&state, snapshots, snapshot_period, cfg.forces_period, probes, live,
+                         cfg.profile_period, cfg.checkpoint_period, cfg.checkpoint_file);
 
 #if defined(PLATFORM_WEB)
     emscripten_set_main_loop(UpdateDrawFrame, 0, 1);
@@ -265,6 +285,12 @@ int main(void) {
 #endif
 
     // Limpieza de memoria
+    SimThread_Stop(sim); // Termina el paso en curso
+    Analysis_CloseForcesLog();
+    Probes_Destroy(probes); // Escribe los registros pendientes
+    LiveFeed_Destroy(live);
+    Snapshot_DestroyWriter(snapshots); // Termina de escribir lo pendiente
+    Profile_Shutdown();
     Solver_Cleanup(&state);
     Renderer_Cleanup(&ctx);
     CloseWindow();
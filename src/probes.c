@@ -0,0 +1,341 @@
+#include "probes.h"
+#include "profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#if !defined(PLATFORM_WEB)
+#define PROBES_THREADED 1
+#include <pthread.h>
+#endif
+
+#define PROBE_CHUNKS 4
+#define PROBE_CHUNK_BYTES (1 << 20)
+
+// Registros a la espera de ser escritos (ya en el formato del archivo)
+typedef struct {
+    unsigned char *data;
+    int records;
+} ProbeChunk;
+
+struct ProbeRecorder {
+    FILE *file;
+    int period;
+    int num_probes;
+    int num_cells;
+    ProbeInfo *info;
+    int *cell;          // Índice en la grilla de cada celda muestreada
+    int32_t *cell_x;
+    int32_t *cell_y;
+
+    size_t record_bytes;
+    int chunk_records;  // Registros por bloque
+    ProbeChunk chunks[PROBE_CHUNKS];
+    int fill;           // Bloque que se está llenando (solo el solver)
+    int head;           // Próximo bloque a escribir
+    int pending;        // Bloques llenos esperando al hilo (o siendo escritos)
+    int stalls;         // Veces que Probes_Record tuvo que esperar al disco
+    bool failed;        // Falló alguna escritura
+    bool threaded;
+    bool stop;
+#ifdef PROBES_THREADED
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+#endif
+};
+
+// Agrega las celdas de una sonda (las listas crecen de a una sonda)
+static bool AddProbe(ProbeRecorder *p, const ProbeInfo *probe, int width, int height, int n) {
+    int count = probe->type == PROBE_POINT ? 1
+              : probe->type == PROBE_LINE  ? n
+              : (abs(probe->x1 - probe->x0) + 1) * (abs(probe->y1 - probe->y0) + 1);
+
+    p->info = (ProbeInfo*)realloc(p->info, (p->num_probes + 1) * sizeof(ProbeInfo));
+    p->cell_x = (int32_t*)realloc(p->cell_x, (p->num_cells + count) * sizeof(int32_t));
+    p->cell_y = (int32_t*)realloc(p->cell_y, (p->num_cells + count) * sizeof(int32_t));
+    ProbeInfo *info = &p->info[p->num_probes];
+    *info = *probe;
+    info->offset = p->num_cells;
+    info->count = count;
+
+    int32_t *xs = p->cell_x + p->num_cells;
+    int32_t *ys = p->cell_y + p->num_cells;
+    if (probe->type == PROBE_POINT) {
+        xs[0] = probe->x0;
+        ys[0] = probe->y0;
+    } else if (probe->type == PROBE_LINE) {
+        // La celda más cercana a cada punto del segmento
+        for (int s = 0; s < n; s++) {
+            float t = n > 1 ? (float)s / (n - 1) : 0.0f;
+            xs[s] = (int32_t)(probe->x0 + t * (probe->x1 - probe->x0) + 0.5f);
+            ys[s] = (int32_t)(probe->y0 + t * (probe->y1 - probe->y0) + 0.5f);
+        }
+    } else {
+        int xa = probe->x0 < probe->x1 ? probe->x0 : probe->x1;
+        int ya = probe->y0 < probe->y1 ? probe->y0 : probe->y1;
+        int w = abs(probe->x1 - probe->x0) + 1;
+        for (int s = 0; s < count; s++) {
+            xs[s] = xa + s % w;
+            ys[s] = ya + s / w;
+        }
+    }
+
+    for (int s = 0; s < count; s++) {
+        if (xs[s] < 0 || xs[s] >= width || ys[s] < 0 || ys[s] >= height) return false;
+    }
+    p->num_probes++;
+    p->num_cells += count;
+    return true;
+}
+
+// Lee el archivo de configuración de sondas
+static bool LoadConfig(ProbeRecorder *p, const char *path, int width, int height) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "No se pudo abrir %s\n", path);
+        return false;
+    }
+
+    char line[256];
+    int line_number = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), f) != NULL) {
+        line_number++;
+        char *text = line;
+        while (isspace((unsigned char)*text)) text++;
+        if (text[0] == '\0' || text[0] == '#') continue;
+
+        char type[16], name[PROBE_NAME_SIZE] = "";
+        int v[5];
+        int fields = sscanf(text, "%15s %31s %d %d %d %d %d", type, name, &v[0], &v[1], &v[2], &v[3], &v[4]);
+
+        ProbeInfo probe;
+        memset(&probe, 0, sizeof(probe));
+        snprintf(probe.name, sizeof(probe.name), "%s", name);
+        int n = 0;
+        if (strcmp(type, "point") == 0 && fields == 4) {
+            probe.type = PROBE_POINT;
+            probe.x0 = probe.x1 = v[0];
+            probe.y0 = probe.y1 = v[1];
+        } else if (strcmp(type, "line") == 0 && (fields == 6 || fields == 7)) {
+            probe.type = PROBE_LINE;
+            probe.x0 = v[0]; probe.y0 = v[1]; probe.x1 = v[2]; probe.y1 = v[3];
+            int dx = abs(v[2] - v[0]), dy = abs(v[3] - v[1]);
+            n = fields == 7 ? v[4] : (dx > dy ? dx : dy) + 1;
+        } else if (strcmp(type, "rect") == 0 && fields == 6) {
+            probe.type = PROBE_RECT;
+            probe.x0 = v[0]; probe.y0 = v[1]; probe.x1 = v[2]; probe.y1 = v[3];
+        } else {
+            fprintf(stderr, "%s:%d: se esperaba 'point NOMBRE x y', 'line NOMBRE x0 y0 x1 y1 [n]' "
+                            "o 'rect NOMBRE x0 y0 x1 y1'\n", path, line_number);
+            ok = false;
+            break;
+        }
+        if (probe.type == PROBE_LINE && n < 1) {
+            fprintf(stderr, "%s:%d: la línea necesita al menos un punto\n", path, line_number);
+            ok = false;
+        } else if (!AddProbe(p, &probe, width, height, n)) {
+            fprintf(stderr, "%s:%d: la sonda '%s' sale de la grilla de %dx%d\n",
+                    path, line_number, probe.name, width, height);
+            ok = false;
+        }
+    }
+    fclose(f);
+
+    if (ok && p->num_cells == 0) {
+        fprintf(stderr, "%s no define ninguna sonda\n", path);
+        ok = false;
+    }
+    return ok;
+}
+
+// Cabecera y tablas tal como van al principio del archivo
+static unsigned char *BuildPreamble(const ProbeRecorder *p, int width, int height, size_t *bytes) {
+    size_t size = sizeof(ProbeFileHeader) + p->num_probes * sizeof(ProbeInfo)
+                + 2 * (size_t)p->num_cells * sizeof(int32_t);
+    unsigned char *buffer = (unsigned char*)calloc(1, size);
+
+    ProbeFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, PROBES_MAGIC, 4);
+    h.version = PROBES_VERSION;
+    h.header_size = (uint32_t)size;
+    h.width = width;
+    h.height = height;
+    h.period = p->period;
+    h.num_probes = p->num_probes;
+    h.num_cells = p->num_cells;
+
+    unsigned char *out = buffer;
+    memcpy(out, &h, sizeof(h));                                 out += sizeof(h);
+    memcpy(out, p->info, p->num_probes * sizeof(ProbeInfo));     out += p->num_probes * sizeof(ProbeInfo);
+    memcpy(out, p->cell_x, p->num_cells * sizeof(int32_t));      out += p->num_cells * sizeof(int32_t);
+    memcpy(out, p->cell_y, p->num_cells * sizeof(int32_t));
+    *bytes = size;
+    return buffer;
+}
+
+// Con 'append', ¿el archivo existente empieza con las mismas sondas?
+static bool SamePreamble(const char *path, const unsigned char *preamble, size_t bytes) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return false;
+    unsigned char *existing = (unsigned char*)malloc(bytes);
+    bool same = fread(existing, 1, bytes, f) == bytes && memcmp(existing, preamble, bytes) == 0;
+    free(existing);
+    fclose(f);
+    return same;
+}
+
+static void WriteChunk(ProbeRecorder *p, const ProbeChunk *chunk) {
+    size_t bytes = (size_t)chunk->records * p->record_bytes;
+    if (fwrite(chunk->data, 1, bytes, p->file) != bytes && !p->failed) {
+        fprintf(stderr, "No se pudieron escribir los registros de las sondas\n");
+        p->failed = true;
+    }
+}
+
+#ifdef PROBES_THREADED
+static void *WriterThread(void *arg) {
+    ProbeRecorder *p = (ProbeRecorder*)arg;
+    pthread_mutex_lock(&p->lock);
+    for (;;) {
+        while (p->pending == 0 && !p->stop) {
+            pthread_cond_wait(&p->cond, &p->lock);
+        }
+        if (p->pending == 0) break; // stop y nada pendiente
+
+        // El bloque de 'head' queda nuestro hasta bajar 'pending'
+        ProbeChunk *chunk = &p->chunks[p->head];
+        pthread_mutex_unlock(&p->lock);
+        WriteChunk(p, chunk);
+        pthread_mutex_lock(&p->lock);
+
+        chunk->records = 0;
+        p->head = (p->head + 1) % PROBE_CHUNKS;
+        p->pending--;
+        pthread_cond_broadcast(&p->cond);
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+#endif
+
+ProbeRecorder *Probes_Create(const char *config_file, const char *output_file,
+                             int period, int width, int height, bool append) {
+    ProbeRecorder *p = (ProbeRecorder*)calloc(1, sizeof(ProbeRecorder));
+    p->period = period > 0 ? period : 1;
+    if (!LoadConfig(p, config_file, width, height)) {
+        Probes_Destroy(p);
+        return NULL;
+    }
+
+    p->cell = (int*)malloc(p->num_cells * sizeof(int));
+    for (int s = 0; s < p->num_cells; s++) p->cell[s] = p->cell_y[s] * width + p->cell_x[s];
+
+    // Al retomar con otras sondas no se puede seguir el mismo archivo
+    size_t preamble_bytes;
+    unsigned char *preamble = BuildPreamble(p, width, height, &preamble_bytes);
+    bool extend = append && SamePreamble(output_file, preamble, preamble_bytes);
+    if (append && !extend) {
+        fprintf(stderr, "%s no tiene las mismas sondas: se empieza de nuevo\n", output_file);
+    }
+    p->file = fopen(output_file, extend ? "ab" : "wb");
+    if (p->file == NULL) {
+        fprintf(stderr, "No se pudo abrir %s\n", output_file);
+        free(preamble);
+        Probes_Destroy(p);
+        return NULL;
+    }
+    if (!extend) fwrite(preamble, 1, preamble_bytes, p->file);
+    free(preamble);
+
+    p->record_bytes = sizeof(int32_t) + 3 * (size_t)p->num_cells * sizeof(float);
+    p->chunk_records = (int)(PROBE_CHUNK_BYTES / p->record_bytes);
+    if (p->chunk_records < 1) p->chunk_records = 1;
+    for (int c = 0; c < PROBE_CHUNKS; c++) {
+        p->chunks[c].data = (unsigned char*)malloc(p->chunk_records * p->record_bytes);
+    }
+
+#ifdef PROBES_THREADED
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cond, NULL);
+    p->threaded = pthread_create(&p->thread, NULL, WriterThread, p) == 0;
+#endif
+    return p;
+}
+
+// Pasa el bloque que se está llenando al hilo de escritura
+static void SubmitChunk(ProbeRecorder *p) {
+    if (!p->threaded) {
+        WriteChunk(p, &p->chunks[p->fill]);
+        p->chunks[p->fill].records = 0;
+        return;
+    }
+
+#ifdef PROBES_THREADED
+    pthread_mutex_lock(&p->lock);
+    p->pending++;
+    pthread_cond_broadcast(&p->cond);
+    // El próximo bloque a llenar tiene que estar libre
+    if (p->pending == PROBE_CHUNKS) {
+        p->stalls++;
+        while (p->pending == PROBE_CHUNKS) {
+            pthread_cond_wait(&p->cond, &p->lock);
+        }
+    }
+    p->fill = (p->head + p->pending) % PROBE_CHUNKS;
+    pthread_mutex_unlock(&p->lock);
+#endif
+}
+
+void Probes_Record(ProbeRecorder *p, const SimulationState *state, int time_step) {
+    if (p == NULL || time_step % p->period != 0) return;
+    uint64_t t = Profile_Begin();
+
+    ProbeChunk *chunk = &p->chunks[p->fill];
+    unsigned char *record = chunk->data + (size_t)chunk->records * p->record_bytes;
+    int32_t step = time_step;
+    memcpy(record, &step, sizeof(step));
+    float *rho = (float*)(record + sizeof(int32_t));
+    float *ux = rho + p->num_cells;
+    float *uy = ux + p->num_cells;
+    for (int s = 0; s < p->num_cells; s++) {
+        int i = p->cell[s];
+        rho[s] = state->rho[i];
+        ux[s] = state->ux[i];
+        uy[s] = state->uy[i];
+    }
+
+    if (++chunk->records == p->chunk_records) SubmitChunk(p);
+    Profile_End(PROF_PROBES, t);
+}
+
+void Probes_Destroy(ProbeRecorder *p) {
+    if (p == NULL) return;
+
+    // El bloque a medio llenar también se escribe
+    if (p->file != NULL && p->chunks[p->fill].records > 0) SubmitChunk(p);
+
+#ifdef PROBES_THREADED
+    if (p->threaded) {
+        pthread_mutex_lock(&p->lock);
+        p->stop = true;
+        pthread_cond_broadcast(&p->cond);
+        pthread_mutex_unlock(&p->lock);
+        pthread_join(p->thread, NULL);
+        pthread_mutex_destroy(&p->lock);
+        pthread_cond_destroy(&p->cond);
+    }
+#endif
+
+    if (p->stalls > 0) printf("Sondas: %d veces se espero al disco\n", p->stalls);
+    if (p->file != NULL) fclose(p->file);
+    for (int c = 0; c < PROBE_CHUNKS; c++) free(p->chunks[c].data);
+    free(p->info);
+    free(p->cell);
+    free(p->cell_x);
+    free(p->cell_y);
+    free(p);
+}
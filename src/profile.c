@@ -0,0 +1,359 @@
+#include "profile.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(PLATFORM_WEB)
+#define PROFILE_THREADED 1
+#include <pthread.h>
+#endif
+
+#if defined(__linux__)
+#define PROFILE_PERF 1
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define PROFILE_TRACE_EVENTS (1 << 16) // Eventos por hilo; los que sobran se descartan
+#define PROFILE_COUNTERS 3             // Ciclos, instrucciones, fallos de caché
+#define CACHE_LINE 64
+
+bool profile_enabled = false;
+
+static const char *phase_names[PROF_PHASE_COUNT] = {
+    [PROF_STEP] = "paso",
+    [PROF_INTERIOR] = "interior",
+    [PROF_BOUNDARY] = "frontera",
+    [PROF_GEOMETRY] = "geometria",
+    [PROF_REFINE] = "refinamiento",
+    [PROF_ANALYSIS] = "analisis",
+    [PROF_FORCES] = "fuerzas",
+    [PROF_PROBES] = "sondas",
+    [PROF_SNAPSHOT_COPY] = "snapshot copia",
+    [PROF_SNAPSHOT_WRITE] = "snapshot escritura",
+    [PROF_CHECKPOINT] = "checkpoint",
+    [PROF_LIVE] = "en vivo",
+    [PROF_PUBLISH] = "publicacion",
+    [PROF_COLORMAP] = "colormap",
+    [PROF_UPLOAD] = "textura"
+};
+
+// Unidad de los elementos de cada etapa (sin entrada = no se cuentan)
+static const char *phase_units[PROF_PHASE_COUNT] = {
+    [PROF_STEP] = "cel",
+    [PROF_INTERIOR] = "cel",
+    [PROF_BOUNDARY] = "cel",
+    [PROF_REFINE] = "cel",
+    [PROF_SNAPSHOT_COPY] = "B",
+    [PROF_SNAPSHOT_WRITE] = "B",
+    [PROF_LIVE] = "B",
+    [PROF_PUBLISH] = "B",
+    [PROF_COLORMAP] = "tex",
+    [PROF_UPLOAD] = "B"
+};
+
+// Interior y frontera se miden fila por fila: solo van al total
+static const bool phase_traced[PROF_PHASE_COUNT] = {
+    [PROF_STEP] = true,
+    [PROF_GEOMETRY] = true,
+    [PROF_REFINE] = true,
+    [PROF_ANALYSIS] = true,
+    [PROF_FORCES] = true,
+    [PROF_PROBES] = true,
+    [PROF_SNAPSHOT_COPY] = true,
+    [PROF_SNAPSHOT_WRITE] = true,
+    [PROF_CHECKPOINT] = true,
+    [PROF_LIVE] = true,
+    [PROF_PUBLISH] = true,
+    [PROF_COLORMAP] = true,
+    [PROF_UPLOAD] = true
+};
+
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    int32_t phase;
+} TraceEvent;
+
+// Registro de un hilo. Los totales solo los escribe el hilo dueño y el
+// resumen los lee desde otro hilo (atómicos relajados: en x86 son un mov)
+typedef struct ProfileThread {
+    int id;
+    char name[32];
+    uint64_t ticks[PROF_PHASE_COUNT];
+    uint64_t calls[PROF_PHASE_COUNT];
+    uint64_t items[PROF_PHASE_COUNT];
+    // Lo que ya mostró el resumen anterior (solo Profile_Summary)
+    uint64_t last_ticks[PROF_PHASE_COUNT];
+    uint64_t last_calls[PROF_PHASE_COUNT];
+    uint64_t last_items[PROF_PHASE_COUNT];
+    TraceEvent *events;     // NULL sin traza
+    int event_count;
+    uint64_t dropped;
+    int perf_fd[PROFILE_COUNTERS];
+    uint64_t last_counter[PROFILE_COUNTERS];
+    struct ProfileThread *next;
+} ProfileThread;
+
+static __thread ProfileThread *current = NULL;
+static ProfileThread *threads = NULL;
+static int thread_count = 0;
+static char trace_path[256];
+static bool use_counters = false;
+static bool counters_warned = false;
+static double tick_seconds = 1e-9;
+static uint64_t base_ticks;
+static uint64_t summary_ticks;
+static int summary_step = 0;
+
+#ifdef PROFILE_THREADED
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK() pthread_mutex_lock(&registry_lock)
+#define UNLOCK() pthread_mutex_unlock(&registry_lock)
+#else
+#define LOCK()
+#define UNLOCK()
+#endif
+
+#ifdef PROFILE_PERF
+static const uint64_t counter_config[PROFILE_COUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES
+};
+
+// Contador del hilo que llama, en cualquier CPU, solo en modo usuario
+static int OpenCounter(uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static uint64_t ReadCounter(int fd) {
+    uint64_t value = 0;
+    if (read(fd, &value, sizeof(value)) != (ssize_t)sizeof(value)) value = 0;
+    return value;
+}
+#endif
+
+static void OpenCounters(ProfileThread *t) {
+    for (int c = 0; c < PROFILE_COUNTERS; c++) t->perf_fd[c] = -1;
+    if (!use_counters) return;
+#ifdef PROFILE_PERF
+    for (int c = 0; c < PROFILE_COUNTERS; c++) {
+        t->perf_fd[c] = OpenCounter(counter_config[c]);
+        if (t->perf_fd[c] < 0) {
+            for (int o = 0; o < c; o++) { close(t->perf_fd[o]); t->perf_fd[o] = -1; }
+            break;
+        }
+    }
+    if (t->perf_fd[0] >= 0) return;
+#endif
+    if (!counters_warned) {
+        fprintf(stderr, "Contadores de hardware no disponibles (perf_event_open): se sigue sin ellos\n");
+        counters_warned = true;
+    }
+}
+
+// Alta del hilo actual (la primera vez que mide algo)
+static ProfileThread *Register(void) {
+    ProfileThread *t = (ProfileThread*)calloc(1, sizeof(ProfileThread));
+    if (t == NULL) return NULL;
+    if (trace_path[0] != '\0') {
+        t->events = (TraceEvent*)malloc(PROFILE_TRACE_EVENTS * sizeof(TraceEvent));
+    }
+
+    LOCK();
+    OpenCounters(t);
+    t->id = thread_count++;
+    snprintf(t->name, sizeof(t->name), "hilo %d", t->id);
+    t->next = threads;
+    threads = t;
+    UNLOCK();
+
+    current = t;
+    return t;
+}
+
+static inline void Accumulate(ProfileThread *t, ProfilePhase phase, uint64_t ticks, uint64_t items) {
+    __atomic_store_n(&t->ticks[phase], t->ticks[phase] + ticks, __ATOMIC_RELAXED);
+    __atomic_store_n(&t->calls[phase], t->calls[phase] + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&t->items[phase], t->items[phase] + items, __ATOMIC_RELAXED);
+}
+
+void Profile_Record(ProfilePhase phase, uint64_t start, uint64_t end, uint64_t items) {
+    ProfileThread *t = current != NULL ? current : Register();
+    if (t == NULL) return;
+    Accumulate(t, phase, end - start, items);
+
+    if (t->events != NULL && phase_traced[phase]) {
+        int n = t->event_count;
+        if (n < PROFILE_TRACE_EVENTS) {
+            t->events[n].start = start;
+            t->events[n].end = end;
+            t->events[n].phase = phase;
+            __atomic_store_n(&t->event_count, n + 1, __ATOMIC_RELEASE);
+        } else {
+            t->dropped++;
+        }
+    }
+}
+
+void Profile_Add(ProfilePhase phase, uint64_t ticks, uint64_t items) {
+    if (!profile_enabled) return;
+    ProfileThread *t = current != NULL ? current : Register();
+    if (t != NULL) Accumulate(t, phase, ticks, items);
+}
+
+// Segundos por tick, contra el reloj monotónico
+static void Calibrate(void) {
+    double t0 = Timer_Now();
+    uint64_t k0 = Profile_Ticks();
+    while (Timer_Now() - t0 < 0.02) {}
+    double t1 = Timer_Now();
+    uint64_t k1 = Profile_Ticks();
+    if (k1 > k0) tick_seconds = (t1 - t0) / (double)(k1 - k0);
+}
+
+void Profile_Init(const char *trace_file, bool counters) {
+    snprintf(trace_path, sizeof(trace_path), "%s", trace_file ? trace_file : "");
+    use_counters = counters;
+    Calibrate();
+    base_ticks = summary_ticks = Profile_Ticks();
+    profile_enabled = true;
+}
+
+void Profile_NameThread(const char *name) {
+    if (!profile_enabled) return;
+    ProfileThread *t = current != NULL ? current : Register();
+    if (t == NULL) return;
+    LOCK();
+    snprintf(t->name, sizeof(t->name), "%s", name);
+    UNLOCK();
+}
+
+void Profile_Summary(FILE *out, int time_step) {
+    if (!profile_enabled) return;
+
+    double total[PROF_PHASE_COUNT] = {0};
+    double worst[PROF_PHASE_COUNT] = {0};
+    uint64_t calls[PROF_PHASE_COUNT] = {0};
+    uint64_t items[PROF_PHASE_COUNT] = {0};
+    uint64_t counters[PROFILE_COUNTERS] = {0};
+    bool have_counters = false;
+
+    uint64_t now = Profile_Ticks();
+    double wall = (double)(now - summary_ticks) * tick_seconds;
+
+    LOCK();
+    for (ProfileThread *t = threads; t != NULL; t = t->next) {
+        for (int p = 0; p < PROF_PHASE_COUNT; p++) {
+            uint64_t ticks = __atomic_load_n(&t->ticks[p], __ATOMIC_RELAXED);
+            uint64_t n = __atomic_load_n(&t->calls[p], __ATOMIC_RELAXED);
+            uint64_t count = __atomic_load_n(&t->items[p], __ATOMIC_RELAXED);
+            double seconds = (double)(ticks - t->last_ticks[p]) * tick_seconds;
+            total[p] += seconds;
+            if (seconds > worst[p]) worst[p] = seconds;
+            calls[p] += n - t->last_calls[p];
+            items[p] += count - t->last_items[p];
+            t->last_ticks[p] = ticks;
+            t->last_calls[p] = n;
+            t->last_items[p] = count;
+        }
+#ifdef PROFILE_PERF
+        for (int c = 0; c < PROFILE_COUNTERS; c++) {
+            if (t->perf_fd[c] < 0) continue;
+            uint64_t value = ReadCounter(t->perf_fd[c]);
+            counters[c] += value - t->last_counter[c];
+            t->last_counter[c] = value;
+            have_counters = true;
+        }
+#endif
+    }
+    UNLOCK();
+
+    fprintf(out, "Perfil, pasos %d a %d (%.3f s):\n", summary_step, time_step, wall);
+    fprintf(out, "  %-20s %10s %10s %10s %14s\n", "etapa", "ms", "max hilo", "llamadas", "rendimiento");
+    for (int p = 0; p < PROF_PHASE_COUNT; p++) {
+        if (calls[p] == 0) continue;
+        char rate[32] = "";
+        if (phase_units[p] != NULL && total[p] > 0.0) {
+            snprintf(rate, sizeof(rate), "%.1f M%s/s", items[p] / total[p] * 1e-6, phase_units[p]);
+        }
+        fprintf(out, "  %-20s %10.2f %10.2f %10llu %14s\n", phase_names[p], total[p] * 1e3,
+                worst[p] * 1e3, (unsigned long long)calls[p], rate);
+    }
+    if (have_counters && wall > 0.0) {
+        double ipc = counters[0] > 0 ? (double)counters[1] / counters[0] : 0.0;
+        fprintf(out, "  ciclos %.3g, instrucciones %.3g (IPC %.2f), fallos LLC %.3g (~%.2f GB/s)\n",
+                (double)counters[0], (double)counters[1], ipc, (double)counters[2],
+                counters[2] * (double)CACHE_LINE / wall * 1e-9);
+    }
+
+    summary_ticks = now;
+    summary_step = time_step;
+}
+
+// Traza en el formato de eventos de Chrome: un evento completo ("X") por
+// intervalo, con tiempos en microsegundos desde Profile_Init
+static void WriteTrace(void) {
+    FILE *f = fopen(trace_path, "w");
+    if (f == NULL) {
+        fprintf(stderr, "No se pudo escribir la traza %s\n", trace_path);
+        return;
+    }
+
+    long events = 0;
+    uint64_t dropped = 0;
+    double us = tick_seconds * 1e6;
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    for (ProfileThread *t = threads; t != NULL; t = t->next) {
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", t->id, t->name);
+        first = false;
+        int count = __atomic_load_n(&t->event_count, __ATOMIC_ACQUIRE);
+        for (int e = 0; e < count; e++) {
+            const TraceEvent *ev = &t->events[e];
+            fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"hydrosim\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                       "\"ts\":%.3f,\"dur\":%.3f}",
+                    phase_names[ev->phase], t->id, (double)(ev->start - base_ticks) * us,
+                    (double)(ev->end - ev->start) * us);
+        }
+        events += count;
+        dropped += t->dropped;
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+
+    printf("Traza de perfil: %s (%ld eventos", trace_path, events);
+    if (dropped > 0) printf(", %llu descartados", (unsigned long long)dropped);
+    printf(")\n");
+}
+
+void Profile_Shutdown(void) {
+    if (!profile_enabled) return;
+    profile_enabled = false;
+    if (trace_path[0] != '\0') WriteTrace();
+
+    LOCK();
+    ProfileThread *t = threads;
+    while (t != NULL) {
+        ProfileThread *next = t->next;
+#ifdef PROFILE_PERF
+        for (int c = 0; c < PROFILE_COUNTERS; c++) {
+            if (t->perf_fd[c] >= 0) close(t->perf_fd[c]);
+        }
+#endif
+        free(t->events);
+        free(t);
+        t = next;
+    }
+    threads = NULL;
+    thread_count = 0;
+    UNLOCK();
+    current = NULL;
+}
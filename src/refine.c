@@ -0,0 +1,441 @@
+#include "refine.h"
+#include "solver.h"
+#include "solver_internal.h"
+#include "scenario.h"
+#include "lattice.h"
+#include "profile.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MOMENTS 6 // rho, ux, uy, sxx, sxy, syy
+
+// Caja de cada nivel alrededor de las paredes, en diámetros (alto o ancho
+// mayor de la caja de las paredes). Cada nivel más fino usa la mitad.
+#define REFINE_UPSTREAM 0.5
+#define REFINE_SIDE     0.5
+#define REFINE_WAKE     2.0
+
+static SimulationState *ParentOf(RefinedGrid *grid, const RefineBlock *block) {
+    return block->parent < 0 ? grid->base : &grid->blocks[block->parent].state;
+}
+
+// Omega de la grilla hija con la misma viscosidad física: nu = (tau - 1/2) / 3
+// en unidades de la grilla, y con dx y dt a la mitad nu_hijo = 2 nu_padre
+static float ChildOmega(float omega) {
+    float tau = 1.0f / omega;
+    return 1.0f / (2.0f * tau - 0.5f);
+}
+
+// Velocidad de la celda (x, y), recortada a la grilla; 0 en las paredes
+static inline void Velocity(const SimulationState *s, int x, int y, float *ux, float *uy) {
+    int i = idx(s, x, y);
+    *ux = s->barrier[i] ? 0.0f : s->ux[i];
+    *uy = s->barrier[i] ? 0.0f : s->uy[i];
+}
+
+// rho, u y el tensor de deformación (diferencias centradas) de la celda (x, y)
+static void CellMoments(const SimulationState *s, int x, int y, float m[MOMENTS]) {
+    int i = idx(s, x, y);
+    float ux_w, uy_w, ux_e, uy_e, ux_s, uy_s, ux_n, uy_n;
+    Velocity(s, x - 1, y, &ux_w, &uy_w);
+    Velocity(s, x + 1, y, &ux_e, &uy_e);
+    Velocity(s, x, y - 1, &ux_s, &uy_s);
+    Velocity(s, x, y + 1, &ux_n, &uy_n);
+
+    m[0] = s->barrier[i] ? 1.0f : s->rho[i];
+    Velocity(s, x, y, &m[1], &m[2]);
+    m[3] = 0.5f * (ux_e - ux_w);
+    m[4] = 0.25f * ((ux_n - ux_s) + (uy_e - uy_w));
+    m[5] = 0.5f * (uy_n - uy_s);
+}
+
+// Pisa la celda i (post-colisión del último paso, en f) y sus campos con
+// esos momentos: equilibrio más la parte de no equilibrio de Chapman-Enskog,
+// -3 w rho tau Q:S, que la colisión deja multiplicada por (1 - omega). S va en
+// unidades de esta grilla, así el reescalado entre niveles sale solo de tau y
+// de S. Q:S por dirección: eje x, eje y y diagonales (signo de cx*cy).
+static void SetCell(SimulationState *s, int i, const float m[MOMENTS]) {
+    if (s->barrier[i]) return;
+    float rho = m[0], ux = m[1], uy = m[2];
+    float sxx = m[3], sxy = m[4], syy = m[5];
+    float neq = -3.0f * rho * (1.0f / s->omega - 1.0f); // (1 - omega) tau = tau - 1
+    float q_rest = -(sxx + syy) / 3.0f;
+    float q_x = (2.0f * sxx - syy) / 3.0f;
+    float q_y = (2.0f * syy - sxx) / 3.0f;
+    float q_diag = 2.0f * (sxx + syy) / 3.0f;
+    float qs[Q] = { q_rest, q_x, q_y, q_x, q_y,
+                    q_diag + 2.0f * sxy, q_diag - 2.0f * sxy, q_diag + 2.0f * sxy, q_diag - 2.0f * sxy };
+
+    size_t ks = s->layout == LAYOUT_SOA ? (size_t)s->stride : 1;
+    float *f = s->f + (s->layout == LAYOUT_SOA ? (size_t)i : (size_t)i * Q);
+    float usq = 1.5f * (ux*ux + uy*uy);
+    for (int k = 0; k < Q; k++) {
+        float cu = 3.0f * (cx[k]*ux + cy[k]*uy);
+        float f_eq = w[k] * rho * (1.0f + cu + 0.5f*(cu*cu) - usq);
+        f[k * ks] = f_eq + neq * w[k] * qs[k];
+    }
+    s->rho[i] = rho;
+    s->ux[i] = ux;
+    s->uy[i] = uy;
+}
+
+// Momentos del padre en [x0-1, x0+w] x [y0-1, y0+h]. Solo el anillo de dos
+// celdas alrededor del borde (lo que usan los fantasmas), o todo con full.
+static void Capture(const RefineBlock *block, const SimulationState *parent, float *out, bool full) {
+    int LW = block->w + 2;
+    int LH = block->h + 2;
+    for (int ly = 0; ly < LH; ly++) {
+        bool edge_row = full || ly < 2 || ly >= block->h;
+        for (int lx = 0; lx < LW; lx++) {
+            if (!edge_row && lx == 2) lx = block->w; // Salta el interior
+            CellMoments(parent, block->x0 - 1 + lx, block->y0 - 1 + ly,
+                        out + ((size_t)ly * LW + lx) * MOMENTS);
+        }
+    }
+}
+
+// Momentos del padre en la celda fina (fx, fy), interpolados entre los dos
+// pasos del padre (t = 0: anterior, 1: actual) y pasados a unidades del hijo
+static void Interpolate(const RefineBlock *block, int fx, int fy, float t, float m[MOMENTS]) {
+    int LW = block->w + 2;
+    // Centro de la celda fina en celdas del padre, con 0 = x0 - 1
+    float px = 0.5f * fx + 0.75f;
+    float py = 0.5f * fy + 0.75f;
+    int ix = (int)px, iy = (int)py;
+    float tx = px - ix, ty = py - iy;
+    float weight[4] = { (1 - tx) * (1 - ty), tx * (1 - ty), (1 - tx) * ty, tx * ty };
+    size_t corner[4] = {
+        (size_t)iy * LW + ix, (size_t)iy * LW + ix + 1,
+        (size_t)(iy + 1) * LW + ix, (size_t)(iy + 1) * LW + ix + 1
+    };
+
+    for (int c = 0; c < MOMENTS; c++) {
+        float value = 0.0f;
+        for (int n = 0; n < 4; n++) {
+            const float *a = block->previous + corner[n] * MOMENTS;
+            const float *b = block->current + corner[n] * MOMENTS;
+            value += weight[n] * ((1.0f - t) * a[c] + t * b[c]);
+        }
+        m[c] = value;
+    }
+    // Mismo u, gradiente por celda fina a la mitad
+    m[3] *= 0.5f;
+    m[4] *= 0.5f;
+    m[5] *= 0.5f;
+}
+
+// Rearma el anillo exterior del bloque en el instante t del paso del padre
+static void FillGhosts(RefineBlock *block, float t) {
+    SimulationState *s = &block->state;
+    int FW = s->width, FH = s->height;
+    float m[MOMENTS];
+    for (int fy = 0; fy < FH; fy++) {
+        int step = (fy == 0 || fy == FH - 1) ? 1 : FW - 1;
+        for (int fx = 0; fx < FW; fx += step) {
+            Interpolate(block, fx, fy, t, m);
+            SetCell(s, fy * FW + fx, m);
+        }
+    }
+}
+
+// Velocidad de la celda j (0 en las paredes)
+static inline float FluidValue(const float *u, const bool *barrier, int j) {
+    return barrier[j] ? 0.0f : u[j];
+}
+
+// Gradiente de u promediado en las 2x2 celdas finas con esquina j, en
+// unidades finas: la suma de las diferencias centradas se telescopa a las
+// columnas (filas) vecinas del cuadrado
+static inline void PatchGradient(const float *u, const bool *barrier, int j, int W,
+                                 float *du_dx, float *du_dy) {
+    float east = 0.0f, west = 0.0f, north = 0.0f, south = 0.0f;
+    for (int r = 0; r < 2; r++) {
+        int row = j + r * W;
+        east += FluidValue(u, barrier, row + 1) + FluidValue(u, barrier, row + 2);
+        west += FluidValue(u, barrier, row - 1) + FluidValue(u, barrier, row);
+        north += FluidValue(u, barrier, j + W + r) + FluidValue(u, barrier, j + 2 * W + r);
+        south += FluidValue(u, barrier, j - W + r) + FluidValue(u, barrier, j + r);
+    }
+    *du_dx = 0.125f * (east - west);
+    *du_dy = 0.125f * (north - south);
+}
+
+// Promedio de las 4 celdas finas en la celda (lx, ly) del padre (relativa al bloque)
+static void RestrictCell(const RefineBlock *block, SimulationState *parent, int lx, int ly) {
+    const SimulationState *fine = &block->state;
+    int i = (block->y0 + ly) * parent->width + block->x0 + lx;
+    if (parent->barrier[i]) return;
+
+    int FW = fine->width;
+    int j = 2 * ly * FW + 2 * lx; // Esquina inferior izquierda
+    int patch[4] = { j, j + 1, j + FW, j + FW + 1 };
+    float m[MOMENTS] = {0};
+    int count = 0;
+    for (int n = 0; n < 4; n++) {
+        if (fine->barrier[patch[n]]) continue;
+        m[0] += fine->rho[patch[n]];
+        m[1] += fine->ux[patch[n]];
+        m[2] += fine->uy[patch[n]];
+        count++;
+    }
+    if (count == 0) return; // Pared a la resolución fina
+    m[0] /= count;
+    m[1] /= count;
+    m[2] /= count;
+
+    // En unidades del padre el gradiente es el doble
+    float dux_dx, dux_dy, duy_dx, duy_dy;
+    PatchGradient(fine->ux, fine->barrier, j, FW, &dux_dx, &dux_dy);
+    PatchGradient(fine->uy, fine->barrier, j, FW, &duy_dx, &duy_dy);
+    m[3] = 2.0f * dux_dx;
+    m[4] = dux_dy + duy_dx;
+    m[5] = 2.0f * duy_dy;
+    SetCell(parent, i, m);
+}
+
+// Vuelta al padre de las celdas cubiertas por el bloque, salvo REFINE_OVERLAP
+// en el borde (las que dependen de los fantasmas). Para la evolución del
+// padre alcanza con el contorno de esa zona: es lo único que leen sus celdas
+// de afuera en el paso siguiente, y el interior se vuelve a pisar antes de
+// que llegue a ellas. Con 'full' se pisa todo (para mirar los campos).
+static void Restrict(RefineBlock *block, SimulationState *parent, bool full) {
+    int x0 = REFINE_OVERLAP, x1 = block->w - REFINE_OVERLAP - 1;
+    int y0 = REFINE_OVERLAP, y1 = block->h - REFINE_OVERLAP - 1;
+    #pragma omp parallel for schedule(static) num_threads(parent->num_threads)
+    for (int ly = y0; ly <= y1; ly++) {
+        int step = (full || ly == y0 || ly == y1) ? 1 : x1 - x0;
+        for (int lx = x0; lx <= x1; lx += step) RestrictCell(block, parent, lx, ly);
+    }
+}
+
+// Un paso del padre para el bloque b: dos subpasos (con los de sus hijos) y
+// la vuelta al padre
+static void CycleBlock(RefinedGrid *grid, int b, bool full) {
+    RefineBlock *block = &grid->blocks[b];
+    SimulationState *parent = ParentOf(grid, block);
+
+    uint64_t t = Profile_Begin();
+    Capture(block, parent, block->current, false);
+    Profile_End(PROF_REFINE, t);
+
+    for (int sub = 0; sub < 2; sub++) {
+        t = Profile_Begin();
+        FillGhosts(block, 0.5f * sub);
+        Profile_End(PROF_REFINE, t);
+
+        Solver_Step(&block->state);
+        for (int c = b + 1; c < grid->num_blocks; c++) {
+            if (grid->blocks[c].parent == b) CycleBlock(grid, c, full);
+        }
+    }
+
+    t = Profile_Begin();
+    Restrict(block, parent, full);
+    Profile_End(PROF_REFINE, t);
+
+    float *temp = block->previous;
+    block->previous = block->current;
+    block->current = temp;
+}
+
+void Refine_Advance(RefinedGrid *grid, int steps) {
+    if (steps <= 0) return;
+    SimulationState *base = grid->base;
+    bool request = base->diagnostics_requested;
+    base->diagnostics_requested = false;
+    for (int s = 0; s < steps; s++) {
+        if (s == steps - 1) base->diagnostics_requested = request;
+        Solver_Step(base);
+        // Los dos últimos pasos con todos los campos al día: el último paso
+        // de la base (métricas) parte de los valores de los bloques
+        bool full = s >= steps - 2;
+        for (int b = 0; b < grid->num_blocks; b++) {
+            if (grid->blocks[b].parent < 0) CycleBlock(grid, b, full);
+        }
+    }
+}
+
+// Región [x0, x1) x [y0, y1) en celdas base, pasada a celdas del padre
+// (origen y escala del padre) y recortada a 'margin' de sus bordes
+static bool PlaceBlock(RefineBlock *block, const SimulationState *parent, int origin_x, int origin_y,
+                       int scale, double x0, double y0, double x1, double y1, int margin) {
+    int px0 = (int)floor(x0 * scale) - origin_x;
+    int py0 = (int)floor(y0 * scale) - origin_y;
+    int px1 = (int)ceil(x1 * scale) - origin_x;
+    int py1 = (int)ceil(y1 * scale) - origin_y;
+    if (px0 < margin) px0 = margin;
+    if (py0 < margin) py0 = margin;
+    if (px1 > parent->width - margin) px1 = parent->width - margin;
+    if (py1 > parent->height - margin) py1 = parent->height - margin;
+
+    block->x0 = px0;
+    block->y0 = py0;
+    block->w = px1 - px0;
+    block->h = py1 - py0;
+    return block->w >= 2 * REFINE_OVERLAP + 2 && block->h >= 2 * REFINE_OVERLAP + 2;
+}
+
+bool Refine_Init(RefinedGrid *grid, SimulationState *base, int levels, int scenario) {
+    memset(grid, 0, sizeof(*grid));
+    grid->base = base;
+    if (levels > REFINE_MAX_LEVELS) levels = REFINE_MAX_LEVELS;
+    if (base->in_place || base->precision != PRECISION_FP32) {
+        fprintf(stderr, "El refinamiento local necesita poblaciones en float con dos buffers\n");
+        return false;
+    }
+
+    // Caja de las paredes de la base
+    int W = base->width, H = base->height;
+    int bx0 = W, by0 = H, bx1 = -1, by1 = -1;
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            if (!base->barrier[y * W + x]) continue;
+            if (x < bx0) bx0 = x;
+            if (x > bx1) bx1 = x;
+            if (y < by0) by0 = y;
+            if (y > by1) by1 = y;
+        }
+    }
+    if (bx1 < 0) {
+        fprintf(stderr, "El refinamiento local se ubica alrededor de las paredes y no hay ninguna\n");
+        return false;
+    }
+    double size = bx1 - bx0 + 1 > by1 - by0 + 1 ? bx1 - bx0 + 1 : by1 - by0 + 1;
+
+    // Los bloques reescriben f de la base: siempre densa
+    Solver_SetSparseThreshold(base, 2.0f);
+
+    int origin_x = 0, origin_y = 0; // Del padre, en celdas de su nivel
+    for (int l = 1; l <= levels; l++) {
+        RefineBlock *block = &grid->blocks[grid->num_blocks];
+        SimulationState *parent = l == 1 ? base : &grid->blocks[grid->num_blocks - 1].state;
+        double d = size / (1 << (l - 1));
+        // Sin tocar la entrada ni la salida de la base; dentro de un bloque,
+        // fuera de las celdas que lee el contorno que se restringe al abuelo
+        int margin = l == 1 ? 3 : REFINE_OVERLAP + 2;
+        if (!PlaceBlock(block, parent, origin_x, origin_y, 1 << (l - 1),
+                        bx0 - REFINE_UPSTREAM * d, by0 - REFINE_SIDE * d,
+                        bx1 + 1 + REFINE_WAKE * d, by1 + 1 + REFINE_SIDE * d, margin)) {
+            fprintf(stderr, "El nivel %d de refinamiento no entra en el nivel anterior; se usan %d\n",
+                    l, l - 1);
+            break;
+        }
+        block->parent = l == 1 ? -1 : grid->num_blocks - 1;
+        block->level = l;
+        origin_x = 2 * (origin_x + block->x0);
+        origin_y = 2 * (origin_y + block->y0);
+
+        SimulationState *s = &block->state;
+        Solver_Init(s, 2 * block->w, 2 * block->h);
+        s->omega = ChildOmega(parent->omega);
+        s->inlet_velocity = base->inlet_velocity; // Solo para los coeficientes
+        Solver_SetThreads(s, base->num_threads);
+        Solver_SetLayout(s, (PopulationLayout)base->layout);
+        if (base->layout == LAYOUT_SOA) Solver_SetIsa(s, (SolverIsa)base->isa);
+        Solver_SetSparseThreshold(s, 2.0f);
+
+        // Paredes a la resolución del bloque; sin escenario (p.ej. paredes
+        // dibujadas a mano), las del padre
+        if (scenario != SCENARIO_NONE) {
+            InitScenarioRegion(s, scenario, W, H, 1 << l, origin_x, origin_y);
+        } else {
+            for (int fy = 0; fy < s->height; fy++) {
+                for (int fx = 0; fx < s->width; fx++) {
+                    s->barrier[fy * s->width + fx] =
+                        parent->barrier[(block->y0 + fy / 2) * parent->width + block->x0 + fx / 2];
+                }
+            }
+            s->barrier_dirty = true;
+        }
+
+        // Todo el bloque interpolado del estado actual del padre
+        size_t count = (size_t)(block->w + 2) * (block->h + 2) * MOMENTS;
+        block->previous = (float*)malloc(count * sizeof(float));
+        block->current = (float*)malloc(count * sizeof(float));
+        Capture(block, parent, block->previous, true);
+        memcpy(block->current, block->previous, count * sizeof(float));
+        float m[MOMENTS];
+        for (int fy = 0; fy < s->height; fy++) {
+            for (int fx = 0; fx < s->width; fx++) {
+                Interpolate(block, fx, fy, 0.0f, m);
+                SetCell(s, fy * s->width + fx, m);
+            }
+        }
+        grid->num_blocks++;
+    }
+    return grid->num_blocks > 0;
+}
+
+void Refine_Prolong(const SimulationState *coarse, SimulationState *fine) {
+    int CW = coarse->width, CH = coarse->height;
+    float *moments = (float*)malloc((size_t)CW * CH * MOMENTS * sizeof(float));
+    #pragma omp parallel for schedule(static) num_threads(fine->num_threads)
+    for (int y = 0; y < CH; y++) {
+        for (int x = 0; x < CW; x++) CellMoments(coarse, x, y, moments + ((size_t)y * CW + x) * MOMENTS);
+    }
+
+    float rx = (float)CW / fine->width;
+    float ry = (float)CH / fine->height;
+    #pragma omp parallel for schedule(static) num_threads(fine->num_threads)
+    for (int fy = 0; fy < fine->height; fy++) {
+        // Centro de la celda fina en celdas gruesas, recortado a la grilla
+        float py = (fy + 0.5f) * ry - 0.5f;
+        if (py < 0.0f) py = 0.0f;
+        if (py > CH - 1) py = (float)(CH - 1);
+        int iy = (int)py;
+        int iy1 = iy + 1 < CH ? iy + 1 : iy;
+        float ty = py - iy;
+        for (int fx = 0; fx < fine->width; fx++) {
+            float px = (fx + 0.5f) * rx - 0.5f;
+            if (px < 0.0f) px = 0.0f;
+            if (px > CW - 1) px = (float)(CW - 1);
+            int ix = (int)px;
+            int ix1 = ix + 1 < CW ? ix + 1 : ix;
+            float tx = px - ix;
+
+            const float *c00 = moments + ((size_t)iy * CW + ix) * MOMENTS;
+            const float *c10 = moments + ((size_t)iy * CW + ix1) * MOMENTS;
+            const float *c01 = moments + ((size_t)iy1 * CW + ix) * MOMENTS;
+            const float *c11 = moments + ((size_t)iy1 * CW + ix1) * MOMENTS;
+            float m[MOMENTS];
+            for (int c = 0; c < MOMENTS; c++) {
+                m[c] = (1 - ty) * ((1 - tx) * c00[c] + tx * c10[c]) + ty * ((1 - tx) * c01[c] + tx * c11[c]);
+            }
+            m[3] *= rx;
+            m[4] *= 0.5f * (rx + ry);
+            m[5] *= ry;
+            SetCell(fine, fy * fine->width + fx, m);
+        }
+    }
+    free(moments);
+}
+
+const SimulationState *Refine_Finest(const RefinedGrid *grid, int *scale) {
+    if (grid->num_blocks == 0) {
+        *scale = 1;
+        return grid->base;
+    }
+    const RefineBlock *block = &grid->blocks[grid->num_blocks - 1];
+    *scale = 1 << block->level;
+    return &block->state;
+}
+
+double Refine_CellUpdates(const RefinedGrid *grid) {
+    double updates = (double)grid->base->width * grid->base->height;
+    for (int b = 0; b < grid->num_blocks; b++) {
+        const SimulationState *s = &grid->blocks[b].state;
+        updates += (double)s->width * s->height * (1 << grid->blocks[b].level);
+    }
+    return updates;
+}
+
+void Refine_Cleanup(RefinedGrid *grid) {
+    for (int b = 0; b < grid->num_blocks; b++) {
+        Solver_Cleanup(&grid->blocks[b].state);
+        free(grid->blocks[b].previous);
+        free(grid->blocks[b].current);
+    }
+    grid->num_blocks = 0;
+}
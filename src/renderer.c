@@ -1,75 +1,155 @@
 #include "renderer.h"
+#include "profile.h"
 #include <stdlib.h>
 #include <math.h>
 
-void Renderer_Init(RenderContext *ctx) {
-    // Imagen en CPU
-    ctx->image = GenImageColor(GRID_W, GRID_H, BLACK);
-    // Textura en GPU
-    ctx->texture = LoadTextureFromImage(ctx->image);
-    // Puntero directo para escribir rápido
-    ctx->pixels = (Color*)ctx->image.data;
+#define MAX_ZOOM 64.0f
+
+void Renderer_Init(RenderContext *ctx, int width, int height) {
+    ctx->grid_width = width;
+    ctx->grid_height = height;
+    ctx->factor = 0; // La textura se crea en el primer cuadro
+    ctx->field = FIELD_SPEED;
+    ctx->zoom = 1.0f;
+    ctx->view_x = 0.0f;
+    ctx->view_y = 0.0f;
+}
+
+// Zona de la ventana donde se dibuja la grilla: escala uniforme (sin
+// deformar grillas no cuadradas) y centrada.
+static Rectangle ViewRect(int width, int height) {
+    float sw = (float)GetScreenWidth();
+    float sh = (float)GetScreenHeight();
+    float scale = fminf(sw / width, sh / height);
+    float w = width * scale;
+    float h = height * scale;
+    return (Rectangle){(sw - w) / 2, (sh - h) / 2, w, h};
+}
+
+// Parte de la grilla (en celdas) que se ve con el zoom actual
+static Rectangle VisibleCells(const RenderContext *ctx) {
+    return (Rectangle){ctx->view_x, ctx->view_y,
+                       ctx->grid_width / ctx->zoom, ctx->grid_height / ctx->zoom};
+}
+
+static void ClampView(RenderContext *ctx) {
+    Rectangle cells = VisibleCells(ctx);
+    ctx->view_x = fminf(fmaxf(ctx->view_x, 0.0f), ctx->grid_width - cells.width);
+    ctx->view_y = fminf(fmaxf(ctx->view_y, 0.0f), ctx->grid_height - cells.height);
+}
+
+// Celda (con fracción) bajo un punto de la ventana
+static Vector2 ScreenToGrid(const RenderContext *ctx, Vector2 point) {
+    Rectangle view = ViewRect(ctx->grid_width, ctx->grid_height);
+    Rectangle cells = VisibleCells(ctx);
+    return (Vector2){cells.x + (point.x - view.x) / view.width * cells.width,
+                     cells.y + (point.y - view.y) / view.height * cells.height};
 }
 
-void Renderer_HandleInput(SimulationState *state) {
+void Renderer_HandleInput(RenderContext *ctx, SimThread *sim) {
+    if (IsKeyPressed(KEY_F)) ctx->field = (FieldKind)((ctx->field + 1) % FIELD_COUNT);
+    if (IsKeyPressed(KEY_Z)) {
+        ctx->zoom = 1.0f;
+        ctx->view_x = 0.0f;
+        ctx->view_y = 0.0f;
+    }
+
+    // Zoom con la rueda, dejando fija la celda bajo el mouse
+    float wheel = GetMouseWheelMove();
+    if (wheel != 0.0f) {
+        Vector2 mouse = GetMousePosition();
+        Vector2 before = ScreenToGrid(ctx, mouse);
+        ctx->zoom = fminf(fmaxf(ctx->zoom * powf(1.25f, wheel), 1.0f), MAX_ZOOM);
+        Vector2 after = ScreenToGrid(ctx, mouse);
+        ctx->view_x += before.x - after.x;
+        ctx->view_y += before.y - after.y;
+        ClampView(ctx);
+    }
+
+    // Mover la vista arrastrando con clic derecho
+    if (IsMouseButtonDown(MOUSE_RIGHT_BUTTON)) {
+        Vector2 delta = GetMouseDelta();
+        Rectangle view = ViewRect(ctx->grid_width, ctx->grid_height);
+        Rectangle cells = VisibleCells(ctx);
+        ctx->view_x -= delta.x / view.width * cells.width;
+        ctx->view_y -= delta.y / view.height * cells.height;
+        ClampView(ctx);
+    }
+
     // Dibujar paredes con clic izquierdo
     if (IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
-        Vector2 mouse = GetMousePosition();
-        
         // Escalar mouse a coordenadas de grilla
-        float scaleX = (float)GetScreenWidth() / GRID_W;
-        float scaleY = (float)GetScreenHeight() / GRID_H;
+        Vector2 cell = ScreenToGrid(ctx, GetMousePosition());
+        int gx = (int)floorf(cell.x);
+        int gy = (int)floorf(cell.y);
         
-        int gx = (int)(mouse.x / scaleX);
-        int gy = (int)(mouse.y / scaleY);
-        
-        // Pincel de radio 2
-        for(int dy=-1; dy<=1; dy++) {
-            for(int dx=-1; dx<=1; dx++) {
-                int nx = gx + dx;
-                int ny = gy + dy;
-                if(nx >=0 && nx < GRID_W && ny >=0 && ny < GRID_H) {
-                    state->barrier[idx(nx, ny)] = true;
-                    // Resetear velocidad en la pared
-                    state->ux[idx(nx, ny)] = 0;
-                    state->uy[idx(nx, ny)] = 0;
-                }
-            }
-        }
+        // El pincel (radio 2) lo aplica el solver entre pasos
+        SimThread_Send(sim, (SimCommand){SIM_CMD_PAINT, gx, gy, 0, 0.0f});
     }
 }
 
-void Renderer_Draw(RenderContext *ctx, SimulationState *state) {
-    int N = GRID_W * GRID_H;
-
-    for (int i = 0; i < N; i++) {
-        if (state->barrier[i]) {
-            ctx->pixels[i] = (Color){255, 100, 100, 255}; // Obstáculo Rojo
-        } else {
-            // Visualizar Velocidad (Magnitud)
-            float vx = state->ux[i];
-            float vy = state->uy[i];
-            float speed = sqrtf(vx*vx + vy*vy);
-            
-            // Mapear velocidad a color (Azul lento -> Verde rápido)
-            unsigned char val = (unsigned char)(fminf(speed * 2000.0f, 255.0f));
-            ctx->pixels[i] = (Color){0, val, val/2 + 50, 255};
-        }
+// Textura de la grilla reducida por 'factor'
+static void ResizeTexture(RenderContext *ctx, int factor) {
+    if (ctx->factor > 0) {
+        UnloadTexture(ctx->texture);
+        UnloadImage(ctx->image);
     }
+    int tw = (ctx->grid_width + factor - 1) / factor;
+    int th = (ctx->grid_height + factor - 1) / factor;
+    // Imagen en CPU
+    ctx->image = GenImageColor(tw, th, BLACK);
+    // Textura en GPU
+    ctx->texture = LoadTextureFromImage(ctx->image);
+    // Puntero directo para escribir rápido
+    ctx->pixels = (Color*)ctx->image.data;
+    ctx->factor = factor;
+}
+
+void Renderer_Draw(RenderContext *ctx, const FieldFrame *frame) {
+    Rectangle view = ViewRect(frame->width, frame->height);
+    Rectangle cells = VisibleCells(ctx);
+
+    // Con más celdas que píxeles se promedian bloques en CPU: la textura
+    // queda del tamaño de la ventana y no se sube lo que no se ve
+    int factor = (int)(cells.width / view.width);
+    if (factor < 1) factor = 1;
+    if (factor != ctx->factor) ResizeTexture(ctx, factor);
 
-    UpdateTexture(ctx->texture, ctx->pixels);
+    // Texels visibles: solo se colorean y se suben esos
+    int tx0 = (int)floorf(cells.x / factor);
+    int ty0 = (int)floorf(cells.y / factor);
+    int tx1 = (int)ceilf((cells.x + cells.width) / factor);
+    int ty1 = (int)ceilf((cells.y + cells.height) / factor);
+    if (tx1 > ctx->texture.width) tx1 = ctx->texture.width;
+    if (ty1 > ctx->texture.height) ty1 = ctx->texture.height;
+
+    uint64_t t = Profile_Begin();
+    Colormap_Render(frame, ctx->field, factor, tx0, ty0, tx1, ty1, (unsigned char*)ctx->pixels);
+    uint64_t texels = (uint64_t)(tx1 - tx0) * (ty1 - ty0);
+    Profile_EndItems(PROF_COLORMAP, t, texels);
+
+    t = Profile_Begin();
+    if (tx0 == 0 && ty0 == 0 && tx1 == ctx->texture.width && ty1 == ctx->texture.height) {
+        UpdateTexture(ctx->texture, ctx->pixels);
+    } else {
+        UpdateTextureRec(ctx->texture, (Rectangle){tx0, ty0, tx1 - tx0, ty1 - ty0}, ctx->pixels);
+    }
+    Profile_EndItems(PROF_UPLOAD, t, texels * 4);
     
-    // Dibujar estirado
+    // Dibujar escalado a la ventana
     DrawTexturePro(ctx->texture, 
-        (Rectangle){0, 0, GRID_W, GRID_H},
-        (Rectangle){0, 0, GetScreenWidth(), GetScreenHeight()},
+        (Rectangle){cells.x / factor, cells.y / factor, cells.width / factor, cells.height / factor},
+        view,
         (Vector2){0,0}, 0.0f, WHITE);
         
     DrawText("Click Izquierdo: Dibujar Pared", 10, 10, 20, WHITE);
     DrawFPS(10, 30);
+    DrawText(TextFormat("Campo: %s [F]  Zoom x%.1f [rueda, clic der., Z]",
+                        Colormap_FieldName(ctx->field), ctx->zoom), 100, 30, 10, GRAY);
 }
 
 void Renderer_Cleanup(RenderContext *ctx) {
+    if (ctx->factor == 0) return;
     UnloadTexture(ctx->texture);
     UnloadImage(ctx->image);
-}
\ No newline at end of file
+}
@@ -0,0 +1,60 @@
+#include "scenario.h"
+#include <string.h>
+
+static const char *SCENARIO_NAMES[] = { "none", "circle", "square", "wall" };
+
+const char *ScenarioName(int type) {
+    return type >= SCENARIO_NONE && type <= SCENARIO_WALL ? SCENARIO_NAMES[type] : "?";
+}
+
+bool ParseScenarioName(const char *text, int *type) {
+    for (int s = SCENARIO_NONE; s <= SCENARIO_WALL; s++) {
+        if (strcmp(text, SCENARIO_NAMES[s]) == 0) { *type = s; return true; }
+    }
+    return false;
+}
+
+void ResetBarriers(SimulationState *state) {
+    for(int i=0; i<state->width*state->height; i++) {
+        state->barrier[i] = false;
+    }
+    state->barrier_dirty = true;
+}
+
+void InitScenario(SimulationState *state, int type) {
+    InitScenarioRows(state, type, state->height, 0);
+}
+
+void InitScenarioRows(SimulationState *state, int type, int global_height, int y_offset) {
+    InitScenarioRegion(state, type, state->width, global_height, 1, 0, y_offset);
+}
+
+void InitScenarioRegion(SimulationState *state, int type, int base_width, int base_height,
+                        int scale, int x_offset, int y_offset) {
+    ResetBarriers(state);
+    int W = base_width;
+    int H = base_height;
+    int cx = W / 3; // Un poco a la izquierda
+    int cy = H / 2;
+
+    for(int y=0; y<state->height; y++) {
+        for(int x=0; x<state->width; x++) {
+            // Centro de la celda en celdas de la grilla base (con scale = 1, x e y)
+            double bx = (x + x_offset + 0.5) / scale - 0.5;
+            double by = (y + y_offset + 0.5) / scale - 0.5;
+            bool wall = false;
+            if (type == SCENARIO_CIRCLE) { // Círculo
+                int r = H / 8;
+                wall = (bx-cx)*(bx-cx) + (by-cy)*(by-cy) <= (double)r*r;
+            } else if (type == SCENARIO_SQUARE) { // Cuadrado
+                int r = H / 8;
+                wall = bx >= cx-r-0.5 && bx < cx+r+0.5 && by >= cy-r-0.5 && by < cy+r+0.5;
+            } else if (type == SCENARIO_WALL) { // Pared Vertical
+                int w = 10;
+                int h = H / 2;
+                wall = bx >= cx-0.5 && bx < cx+w-0.5 && by >= cy-h/2-0.5 && by < cy+h/2+0.5;
+            }
+            if (wall) state->barrier[idx(state, x, y)] = true;
+        }
+    }
+}
@@ -0,0 +1,290 @@
+#include "sim_thread.h"
+#include "solver.h"
+#include "scenario.h"
+#include "analysis.h"
+#include "checkpoint.h"
+#include "timer.h"
+#include "profile.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(PLATFORM_WEB) && !defined(_WIN32)
+#define SIM_THREADED 1
+#include <pthread.h>
+#include <time.h>
+#endif
+
+// Pasos por cuadro cuando no hay hilo (el ritmo de antes)
+#define STEPS_PER_FRAME 4
+
+// Métricas globales y tiempos de proceso (como en el loop de main.c de antes)
+#define LOG_PERIOD 100
+#define PERF_PERIOD 1000
+
+// Triple buffer: 'middle' guarda el índice del cuadro intermedio y este bit
+// si el solver lo publicó después de la última lectura
+#define FRAME_FRESH 4
+
+struct SimThread {
+    SimulationState *state;
+    SnapshotWriter *snapshots;
+    int snapshot_period;
+    int forces_period;
+    ProbeRecorder *probes;
+    LiveFeed *live;
+    int profile_period;
+    int checkpoint_period;
+    const char *checkpoint_file;
+    bool running;
+
+    FieldFrame frames[3];
+    int back;    // Solo el solver
+    int middle;  // Atómico: índice | FRAME_FRESH
+    int front;   // Solo la interfaz
+
+    SimCommand queue[SIM_QUEUE_SIZE];
+    unsigned head;   // Atómico: próximo a leer (solver)
+    unsigned tail;   // Atómico: próximo a escribir (interfaz)
+
+    double solver_time;      // Para Analysis_LogPerformance
+    double rate_time;        // Para FieldFrame.mlups
+    int rate_steps;
+    double rate_mlups;
+
+#ifdef SIM_THREADED
+    pthread_t thread;
+    bool started;
+    int quit;        // Atómico
+#endif
+};
+
+static void AllocFrame(FieldFrame *frame, int width, int height) {
+    size_t N = (size_t)width * height;
+    memset(frame, 0, sizeof(*frame));
+    frame->width = width;
+    frame->height = height;
+    frame->rho = (float*)calloc(N, sizeof(float));
+    frame->ux = (float*)calloc(N, sizeof(float));
+    frame->uy = (float*)calloc(N, sizeof(float));
+    frame->barrier = (bool*)calloc(N, sizeof(bool));
+}
+
+static void FreeFrame(FieldFrame *frame) {
+    free(frame->rho);
+    free(frame->ux);
+    free(frame->uy);
+    free(frame->barrier);
+}
+
+// Copia el estado al cuadro de atrás y lo intercambia con el intermedio
+static void Publish(SimThread *sim) {
+    const SimulationState *state = sim->state;
+    FieldFrame *frame = &sim->frames[sim->back];
+    size_t N = (size_t)state->width * state->height;
+    uint64_t t = Profile_Begin();
+    memcpy(frame->rho, state->rho, N * sizeof(float));
+    memcpy(frame->ux, state->ux, N * sizeof(float));
+    memcpy(frame->uy, state->uy, N * sizeof(float));
+    memcpy(frame->barrier, state->barrier, N * sizeof(bool));
+    frame->time_step = state->time_step;
+    frame->running = sim->running;
+    frame->omega = state->omega;
+    frame->inlet_velocity = state->inlet_velocity;
+    double fx, fy, cd, cl;
+    Solver_ComputeForces(state, &fx, &fy);
+    Analysis_ForceCoefficients(state, fx, fy, &cd, &cl);
+    frame->drag = (float)cd;
+    frame->lift = (float)cl;
+    Profile_EndItems(PROF_PUBLISH, t, N * (3 * sizeof(float) + sizeof(bool)));
+
+    double now = Timer_Now();
+    if (sim->rate_steps > 0 && now > sim->rate_time) {
+        sim->rate_mlups = (double)N * sim->rate_steps / (now - sim->rate_time) * 1e-6;
+    } else if (!sim->running) {
+        sim->rate_mlups = 0.0;
+    }
+    frame->mlups = sim->rate_mlups;
+    sim->rate_time = now;
+    sim->rate_steps = 0;
+
+    int previous = __atomic_exchange_n(&sim->middle, sim->back | FRAME_FRESH, __ATOMIC_ACQ_REL);
+    sim->back = previous & ~FRAME_FRESH;
+}
+
+// La interfaz todavía no tomó el último cuadro: no hace falta copiar otro
+static bool FramePending(SimThread *sim) {
+    return (__atomic_load_n(&sim->middle, __ATOMIC_ACQUIRE) & FRAME_FRESH) != 0;
+}
+
+static void Paint(SimulationState *state, int gx, int gy) {
+    // Pincel de radio 2
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            int nx = gx + dx;
+            int ny = gy + dy;
+            if (nx >= 0 && nx < state->width && ny >= 0 && ny < state->height) {
+                state->barrier[idx(state, nx, ny)] = true;
+                state->barrier_dirty = true;
+                // Resetear velocidad en la pared
+                state->ux[idx(state, nx, ny)] = 0;
+                state->uy[idx(state, nx, ny)] = 0;
+            }
+        }
+    }
+}
+
+// Aplica los comandos encolados; true si cambió algo que se ve
+static bool ApplyCommands(SimThread *sim) {
+    SimulationState *state = sim->state;
+    bool changed = false;
+    unsigned head = sim->head;
+    unsigned tail = __atomic_load_n(&sim->tail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; head++) {
+        const SimCommand *c = &sim->queue[head % SIM_QUEUE_SIZE];
+        switch (c->type) {
+            case SIM_CMD_RUN:             sim->running = c->value != 0; break;
+            case SIM_CMD_PAINT:           Paint(state, c->x, c->y); break;
+            case SIM_CMD_SCENARIO:        InitScenario(state, c->value); break;
+            case SIM_CMD_CLEAR:           ResetBarriers(state); break;
+            case SIM_CMD_OMEGA:           state->omega = c->number; break;
+            case SIM_CMD_VELOCITY:        state->inlet_velocity = c->number; break;
+            case SIM_CMD_SNAPSHOT_PERIOD: sim->snapshot_period = c->value > 0 ? c->value : 1; break;
+        }
+        changed = true;
+    }
+    __atomic_store_n(&sim->head, head, __ATOMIC_RELEASE);
+    return changed;
+}
+
+// Un paso con todo lo que se registra
+static void Step(SimThread *sim) {
+    SimulationState *state = sim->state;
+
+    // Las métricas del paso 100, 200, ... se acumulan dentro del solver
+    int next = state->time_step + 1;
+    if (next % LOG_PERIOD == 0 || LiveFeed_Due(sim->live, next)) Solver_RequestDiagnostics(state);
+
+    double t0 = Timer_Now();
+    Solver_Step(state);
+    sim->solver_time += Timer_Now() - t0;
+    sim->rate_steps++;
+
+    int step = state->time_step;
+    if (step % PERF_PERIOD == 0) {
+        Analysis_LogPerformance(step, sim->solver_time);
+        sim->solver_time = 0.0;
+    }
+    if (sim->profile_period > 0 && step % sim->profile_period == 0) Profile_Summary(stdout, step);
+    if (step % LOG_PERIOD == 0) Analysis_ComputeAndSave(state, step);
+    if (sim->forces_period > 0 && step % sim->forces_period == 0) Analysis_LogForces(state, step);
+    Probes_Record(sim->probes, state, step);
+    LiveFeed_Publish(sim->live, state, step);
+    if (step % sim->snapshot_period == 0) {
+        if (sim->snapshots == NULL) Analysis_SaveSnapshot(state, step);
+        else Snapshot_Submit(sim->snapshots, state, step);
+    }
+    if (sim->checkpoint_period > 0 && step % sim->checkpoint_period == 0) {
+        uint64_t t = Profile_Begin();
+        Checkpoint_Save(state, sim->checkpoint_file);
+        Profile_End(PROF_CHECKPOINT, t);
+    }
+}
+
+#ifdef SIM_THREADED
+static void SleepBriefly(void) {
+    struct timespec ts = {0, 1000000};
+    nanosleep(&ts, NULL);
+}
+
+static void *SolverThread(void *data) {
+    SimThread *sim = (SimThread*)data;
+    Profile_NameThread("solver");
+    bool unpublished = false; // Hay cambios que la interfaz todavía no vio
+    while (!__atomic_load_n(&sim->quit, __ATOMIC_ACQUIRE)) {
+        bool changed = ApplyCommands(sim);
+        if (sim->running) {
+            Step(sim);
+            changed = true;
+        } else if (!changed) {
+            SleepBriefly(); // En pausa solo se esperan comandos
+        }
+        unpublished = unpublished || changed;
+        // Solo se copia un cuadro nuevo cuando la interfaz tomó el anterior
+        if (unpublished && !FramePending(sim)) {
+            Publish(sim);
+            unpublished = false;
+        }
+    }
+    ApplyCommands(sim);
+    return NULL;
+}
+#endif
+
+SimThread *SimThread_Start(SimulationState *state, SnapshotWriter *snapshots, int snapshot_period,
+                           int forces_period, ProbeRecorder *probes, LiveFeed *live,
+                           int profile_period, int checkpoint_period, const char *checkpoint_file) {
+    SimThread *sim = (SimThread*)calloc(1, sizeof(SimThread));
+    sim->state = state;
+    sim->snapshots = snapshots;
+    sim->snapshot_period = snapshot_period > 0 ? snapshot_period : 1;
+    sim->forces_period = forces_period;
+    sim->probes = probes;
+    sim->live = live;
+    sim->profile_period = profile_period;
+    sim->checkpoint_period = checkpoint_period;
+    sim->checkpoint_file = checkpoint_file;
+    for (int i = 0; i < 3; i++) AllocFrame(&sim->frames[i], state->width, state->height);
+    sim->back = 0;
+    sim->middle = 1;
+    sim->front = 2;
+    sim->rate_time = Timer_Now();
+    Publish(sim);
+
+#ifdef SIM_THREADED
+    sim->started = pthread_create(&sim->thread, NULL, SolverThread, sim) == 0;
+#endif
+    return sim;
+}
+
+bool SimThread_Send(SimThread *sim, SimCommand command) {
+    unsigned tail = sim->tail;
+    unsigned head = __atomic_load_n(&sim->head, __ATOMIC_ACQUIRE);
+    if (tail - head >= SIM_QUEUE_SIZE) return false;
+    sim->queue[tail % SIM_QUEUE_SIZE] = command;
+    __atomic_store_n(&sim->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+const FieldFrame *SimThread_AcquireFrame(SimThread *sim) {
+#ifdef SIM_THREADED
+    if (!sim->started) {
+#endif
+        // Sin hilo: los pasos del cuadro se dan acá mismo
+        ApplyCommands(sim);
+        if (sim->running) {
+            for (int i = 0; i < STEPS_PER_FRAME; i++) Step(sim);
+        }
+        Publish(sim);
+#ifdef SIM_THREADED
+    }
+#endif
+
+    if (__atomic_load_n(&sim->middle, __ATOMIC_ACQUIRE) & FRAME_FRESH) {
+        int previous = __atomic_exchange_n(&sim->middle, sim->front, __ATOMIC_ACQ_REL);
+        sim->front = previous & ~FRAME_FRESH;
+    }
+    return &sim->frames[sim->front];
+}
+
+void SimThread_Stop(SimThread *sim) {
+    if (sim == NULL) return;
+#ifdef SIM_THREADED
+    if (sim->started) {
+        __atomic_store_n(&sim->quit, 1, __ATOMIC_RELEASE);
+        pthread_join(sim->thread, NULL);
+    }
+#endif
+    for (int i = 0; i < 3; i++) FreeFrame(&sim->frames[i]);
+    free(sim);
+}
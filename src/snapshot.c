@@ -0,0 +1,379 @@
+#include "snapshot.h"
+#include "profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef HYDROSIM_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#if !defined(PLATFORM_WEB)
+#define SNAPSHOT_THREADED 1
+#include <pthread.h>
+#endif
+
+#define SNAPSHOT_BUFFERS 2
+
+// Memoria de trabajo que se reusa entre snapshots
+typedef struct {
+    unsigned char *data;
+    size_t capacity;
+} ScratchBuffer;
+
+// Copia de los campos de un snapshot (ya recortados y decimados) a la
+// espera de ser escrita, más lo que usa cada plano al codificarse
+typedef struct {
+    SnapshotHeader header;
+    float *rho;
+    float *ux;
+    float *uy;
+    unsigned char *barrier;
+    int capacity; // Celdas reservadas
+    ScratchBuffer quantized[SNAPSHOT_PLANES];
+    ScratchBuffer shuffled[SNAPSHOT_PLANES];
+    ScratchBuffer packed[SNAPSHOT_PLANES];
+} SnapshotBuffer;
+
+struct SnapshotWriter {
+    char prefix[256];
+    SnapshotOptions options;
+    SnapshotBuffer buffers[SNAPSHOT_BUFFERS];
+    int head;     // Próximo buffer a escribir
+    int pending;  // Buffers llenos esperando al hilo (o siendo escritos)
+    int stalls;   // Veces que Submit tuvo que esperar al disco
+    int written;
+    bool threaded;
+    bool stop;
+#ifdef SNAPSHOT_THREADED
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+#endif
+};
+
+void Snapshot_DefaultOptions(SnapshotOptions *options) {
+    memset(options, 0, sizeof(*options));
+    options->stride = 1;
+    options->quant_bits = 32;
+    options->compression = SNAPSHOT_RAW;
+}
+
+// Cabecera y planos ya codificados
+static bool WritePlanes(const char *filename, const SnapshotHeader *header,
+                        const void *planes[SNAPSHOT_PLANES], const size_t bytes[SNAPSHOT_PLANES]) {
+    FILE *f = fopen(filename, "wb");
+    if (f == NULL) return false;
+
+    bool ok = fwrite(header, sizeof(*header), 1, f) == 1;
+    for (int p = 0; p < SNAPSHOT_PLANES && ok; p++) {
+        ok = fwrite(planes[p], 1, bytes[p], f) == bytes[p];
+    }
+    if (fclose(f) != 0) ok = false;
+    return ok;
+}
+
+bool Snapshot_WriteFile(const char *filename, const SnapshotHeader *header,
+                        const float *rho, const float *ux, const float *uy,
+                        const unsigned char *barrier) {
+    size_t N = (size_t)header->width * header->height;
+    const void *planes[SNAPSHOT_PLANES] = {rho, ux, uy, barrier};
+    size_t bytes[SNAPSHOT_PLANES] = {N * sizeof(float), N * sizeof(float), N * sizeof(float), N};
+    return WritePlanes(filename, header, planes, bytes);
+}
+
+static unsigned char *Reserve(ScratchBuffer *scratch, size_t bytes) {
+    if (scratch->capacity < bytes) {
+        free(scratch->data);
+        scratch->data = (unsigned char*)malloc(bytes);
+        scratch->capacity = bytes;
+    }
+    return scratch->data;
+}
+
+// Pasa 'n' floats a enteros de 'bits' bits en [min, max] del plano
+static void Quantize(const float *values, size_t n, int bits, SnapshotPlane *plane, unsigned char *out) {
+    float lo = INFINITY, hi = -INFINITY;
+    for (size_t i = 0; i < n; i++) {
+        if (values[i] < lo) lo = values[i];
+        if (values[i] > hi) hi = values[i];
+    }
+    if (!(lo <= hi)) lo = hi = 0.0f; // Plano vacío o todo NaN
+
+    float top = (float)((1u << bits) - 1);
+    plane->offset = lo;
+    plane->scale = hi > lo ? (hi - lo) / top : 1.0f;
+    float inv = 1.0f / plane->scale;
+    for (size_t i = 0; i < n; i++) {
+        float t = (values[i] - lo) * inv + 0.5f;
+        if (!(t > 0.0f)) t = 0.0f; // NaN también
+        if (t > top) t = top;
+        if (bits == 16) ((uint16_t*)out)[i] = (uint16_t)t;
+        else out[i] = (unsigned char)t;
+    }
+}
+
+// Agrupa el byte b de todos los valores (los bytes altos de floats
+// parecidos se repiten y comprimen mucho mejor)
+static void Shuffle(const unsigned char *in, size_t n, int size, unsigned char *out) {
+    for (int b = 0; b < size; b++) {
+        unsigned char *dst = out + (size_t)b * n;
+        for (size_t i = 0; i < n; i++) dst[i] = in[i * size + b];
+    }
+}
+
+// Deja el plano p en su forma del archivo; devuelve los datos y su tamaño.
+// Si comprimido no achica, va sin comprimir (planes[p].bytes = 0).
+static const void *EncodePlane(SnapshotBuffer *buffer, int p, size_t *bytes) {
+    SnapshotHeader *h = &buffer->header;
+    SnapshotPlane *plane = &h->planes[p];
+    size_t n = (size_t)h->width * h->height;
+    const float *fields[3] = {buffer->rho, buffer->ux, buffer->uy};
+
+    const unsigned char *data;
+    int size;
+    if (p == SNAPSHOT_PLANES - 1) {
+        data = buffer->barrier;
+        size = 1;
+    } else if (h->quant_bits == 16 || h->quant_bits == 8) {
+        size = h->quant_bits / 8;
+        unsigned char *q = Reserve(&buffer->quantized[p], n * size);
+        Quantize(fields[p], n, h->quant_bits, plane, q);
+        data = q;
+    } else {
+        data = (const unsigned char*)fields[p];
+        size = sizeof(float);
+    }
+    *bytes = n * size;
+    plane->bytes = 0;
+
+#ifdef HYDROSIM_HAVE_ZLIB
+    if (h->compression == SNAPSHOT_ZLIB) {
+        const unsigned char *src = data;
+        if (h->shuffle && size > 1) {
+            unsigned char *tmp = Reserve(&buffer->shuffled[p], *bytes);
+            Shuffle(data, n, size, tmp);
+            src = tmp;
+        }
+        uLongf packed = compressBound((uLong)*bytes);
+        unsigned char *out = Reserve(&buffer->packed[p], packed);
+        if (compress2(out, &packed, src, (uLong)*bytes, Z_BEST_SPEED) == Z_OK && packed < *bytes) {
+            plane->bytes = packed;
+            *bytes = packed;
+            return out;
+        }
+    }
+#endif
+    return data;
+}
+
+static void WriteBuffer(SnapshotWriter *writer, SnapshotBuffer *buffer) {
+    char filename[300];
+    snprintf(filename, sizeof(filename), "%ssnapshot_%05d.bin", writer->prefix, buffer->header.step);
+
+    uint64_t t = Profile_Begin();
+
+    // Cada plano se cuantiza y comprime por su lado
+    const void *planes[SNAPSHOT_PLANES];
+    size_t bytes[SNAPSHOT_PLANES];
+    bool encode = buffer->header.quant_bits != 0 || buffer->header.compression != SNAPSHOT_RAW;
+    #pragma omp parallel for schedule(dynamic) if(encode)
+    for (int p = 0; p < SNAPSHOT_PLANES; p++) {
+        planes[p] = EncodePlane(buffer, p, &bytes[p]);
+    }
+
+    bool ok = WritePlanes(filename, &buffer->header, planes, bytes);
+    uint64_t total = sizeof(SnapshotHeader);
+    for (int p = 0; p < SNAPSHOT_PLANES; p++) total += bytes[p];
+    Profile_EndItems(PROF_SNAPSHOT_WRITE, t, total);
+
+    if (ok) {
+        printf("Snapshot guardado: %s\n", filename);
+    } else {
+        fprintf(stderr, "No se pudo escribir %s\n", filename);
+    }
+}
+
+#ifdef SNAPSHOT_THREADED
+static void *WriterThread(void *arg) {
+    SnapshotWriter *writer = (SnapshotWriter*)arg;
+    Profile_NameThread("snapshots");
+    pthread_mutex_lock(&writer->lock);
+    for (;;) {
+        while (writer->pending == 0 && !writer->stop) {
+            pthread_cond_wait(&writer->cond, &writer->lock);
+        }
+        if (writer->pending == 0) break; // stop y nada pendiente
+
+        // El buffer de 'head' queda nuestro hasta bajar 'pending'
+        SnapshotBuffer *buffer = &writer->buffers[writer->head];
+        pthread_mutex_unlock(&writer->lock);
+        WriteBuffer(writer, buffer);
+        pthread_mutex_lock(&writer->lock);
+
+        writer->head = (writer->head + 1) % SNAPSHOT_BUFFERS;
+        writer->pending--;
+        writer->written++;
+        pthread_cond_broadcast(&writer->cond);
+    }
+    pthread_mutex_unlock(&writer->lock);
+    return NULL;
+}
+#endif
+
+SnapshotWriter *Snapshot_CreateWriter(const char *prefix, const SnapshotOptions *options) {
+    SnapshotWriter *writer = (SnapshotWriter*)calloc(1, sizeof(SnapshotWriter));
+    if (writer == NULL) return NULL;
+    snprintf(writer->prefix, sizeof(writer->prefix), "%s", prefix ? prefix : "");
+
+    if (options != NULL) writer->options = *options;
+    else Snapshot_DefaultOptions(&writer->options);
+    SnapshotOptions *o = &writer->options;
+    if (o->stride < 1) o->stride = 1;
+    if (o->quant_bits != 16 && o->quant_bits != 8) o->quant_bits = 32;
+#ifndef HYDROSIM_HAVE_ZLIB
+    if (o->compression != SNAPSHOT_RAW) {
+        fprintf(stderr, "Compilado sin zlib: los snapshots van sin comprimir\n");
+        o->compression = SNAPSHOT_RAW;
+    }
+#endif
+
+#ifdef SNAPSHOT_THREADED
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->cond, NULL);
+    writer->threaded = pthread_create(&writer->thread, NULL, WriterThread, writer) == 0;
+#endif
+    return writer;
+}
+
+// Copia la región pedida de los campos al buffer (lo agranda si hace falta)
+static void FillBuffer(SnapshotBuffer *buffer, const SnapshotOptions *o,
+                       const SimulationState *state, int time_step) {
+    int W = state->width;
+    int H = state->height;
+    int x0 = o->roi_x0 > 0 ? (o->roi_x0 < W ? o->roi_x0 : W - 1) : 0;
+    int y0 = o->roi_y0 > 0 ? (o->roi_y0 < H ? o->roi_y0 : H - 1) : 0;
+    int x1 = o->roi_x1 > x0 && o->roi_x1 < W ? o->roi_x1 : W;
+    int y1 = o->roi_y1 > y0 && o->roi_y1 < H ? o->roi_y1 : H;
+    int stride = o->stride;
+    int w = (x1 - x0 + stride - 1) / stride;
+    int h = (y1 - y0 + stride - 1) / stride;
+
+    int N = w * h;
+    if (buffer->capacity < N) {
+        free(buffer->rho); free(buffer->ux); free(buffer->uy); free(buffer->barrier);
+        buffer->rho = (float*)malloc((size_t)N * sizeof(float));
+        buffer->ux = (float*)malloc((size_t)N * sizeof(float));
+        buffer->uy = (float*)malloc((size_t)N * sizeof(float));
+        buffer->barrier = (unsigned char*)malloc((size_t)N);
+        buffer->capacity = N;
+    }
+
+    SnapshotHeader *hd = &buffer->header;
+    memset(hd, 0, sizeof(*hd));
+    memcpy(hd->magic, SNAPSHOT_MAGIC, 4);
+    hd->version = SNAPSHOT_VERSION;
+    hd->header_size = sizeof(SnapshotHeader);
+    hd->width = w;
+    hd->height = h;
+    hd->step = time_step;
+    hd->omega = state->omega;
+    hd->inlet_velocity = state->inlet_velocity;
+    hd->grid_width = W;
+    hd->grid_height = H;
+    hd->roi_x0 = x0;
+    hd->roi_y0 = y0;
+    hd->stride = stride;
+    hd->quant_bits = o->quant_bits == 32 ? 0 : o->quant_bits;
+    hd->compression = o->compression;
+    hd->shuffle = o->compression != SNAPSHOT_RAW;
+
+    for (int j = 0; j < h; j++) {
+        size_t src = (size_t)(y0 + j * stride) * W + x0;
+        size_t dst = (size_t)j * w;
+        if (stride == 1) {
+            memcpy(buffer->rho + dst, state->rho + src, (size_t)w * sizeof(float));
+            memcpy(buffer->ux + dst, state->ux + src, (size_t)w * sizeof(float));
+            memcpy(buffer->uy + dst, state->uy + src, (size_t)w * sizeof(float));
+        } else {
+            for (int i = 0; i < w; i++) {
+                size_t c = src + (size_t)i * stride;
+                buffer->rho[dst + i] = state->rho[c];
+                buffer->ux[dst + i] = state->ux[c];
+                buffer->uy[dst + i] = state->uy[c];
+            }
+        }
+        for (int i = 0; i < w; i++) buffer->barrier[dst + i] = state->barrier[src + (size_t)i * stride] ? 1 : 0;
+    }
+}
+
+// Bytes que copió FillBuffer (para el perfil)
+static uint64_t CopiedBytes(const SnapshotBuffer *buffer) {
+    return (uint64_t)buffer->header.width * buffer->header.height * (3 * sizeof(float) + 1);
+}
+
+void Snapshot_Submit(SnapshotWriter *writer, const SimulationState *state, int time_step) {
+    if (writer == NULL) return;
+
+    if (!writer->threaded) {
+        uint64_t t = Profile_Begin();
+        FillBuffer(&writer->buffers[0], &writer->options, state, time_step);
+        Profile_EndItems(PROF_SNAPSHOT_COPY, t, CopiedBytes(&writer->buffers[0]));
+        WriteBuffer(writer, &writer->buffers[0]);
+        writer->written++;
+        return;
+    }
+
+#ifdef SNAPSHOT_THREADED
+    pthread_mutex_lock(&writer->lock);
+    if (writer->pending == SNAPSHOT_BUFFERS) {
+        writer->stalls++;
+        while (writer->pending == SNAPSHOT_BUFFERS) {
+            pthread_cond_wait(&writer->cond, &writer->lock);
+        }
+    }
+    int slot = (writer->head + writer->pending) % SNAPSHOT_BUFFERS;
+    pthread_mutex_unlock(&writer->lock);
+
+    // El buffer libre no lo toca el hilo: se copia sin el lock
+    uint64_t t = Profile_Begin();
+    FillBuffer(&writer->buffers[slot], &writer->options, state, time_step);
+    Profile_EndItems(PROF_SNAPSHOT_COPY, t, CopiedBytes(&writer->buffers[slot]));
+
+    pthread_mutex_lock(&writer->lock);
+    writer->pending++;
+    pthread_cond_broadcast(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+#endif
+}
+
+void Snapshot_DestroyWriter(SnapshotWriter *writer) {
+    if (writer == NULL) return;
+
+#ifdef SNAPSHOT_THREADED
+    if (writer->threaded) {
+        pthread_mutex_lock(&writer->lock);
+        writer->stop = true;
+        pthread_cond_broadcast(&writer->cond);
+        pthread_mutex_unlock(&writer->lock);
+        pthread_join(writer->thread, NULL);
+    }
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->cond);
+#endif
+
+    if (writer->stalls > 0) {
+        printf("Snapshots: %d escritos, %d veces se espero al disco\n", writer->written, writer->stalls);
+    }
+    for (int b = 0; b < SNAPSHOT_BUFFERS; b++) {
+        SnapshotBuffer *buffer = &writer->buffers[b];
+        free(buffer->rho); free(buffer->ux); free(buffer->uy); free(buffer->barrier);
+        for (int p = 0; p < SNAPSHOT_PLANES; p++) {
+            free(buffer->quantized[p].data);
+            free(buffer->shuffled[p].data);
+            free(buffer->packed[p].data);
+        }
+    }
+    free(writer);
+}
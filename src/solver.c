@@ -1,27 +1,108 @@
 #include "solver.h"
+#include "solver_internal.h"
+#include "solver_simd.h"
+#include "lattice.h"
+#include "checkpoint.h"
+#include "half.h"
+#include "profile.h"
+#include "arena.h"
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
-// Constantes LBM D2Q9
-const float w[9] = {4.0/9, 1.0/9, 1.0/9, 1.0/9, 1.0/9, 1.0/36, 1.0/36, 1.0/36, 1.0/36};
-const int cx[9] = {0, 1, 0, -1, 0, 1, -1, -1, 1};
-const int cy[9] = {0, 0, 1, 0, -1, 1, 1, -1, -1};
-const int opp[9] = {0, 3, 4, 1, 2, 7, 8, 5, 6}; // Dirección opuesta para rebote
-
-void Solver_Init(SimulationState *state) {
-    int N = GRID_W * GRID_H;
-    state->f = (float*)calloc(N * Q, sizeof(float));
-    state->new_f = (float*)calloc(N * Q, sizeof(float));
-    state->rho = (float*)calloc(N, sizeof(float));
-    state->ux = (float*)calloc(N, sizeof(float));
-    state->uy = (float*)calloc(N, sizeof(float));
-    state->barrier = (bool*)calloc(N, sizeof(bool));
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+float *Solver_AllocPopulations(size_t count) {
+    return (float*)Arena_Alloc(count * sizeof(float));
+}
+
+void Solver_FreePopulations(float *ptr) {
+    Arena_Free(ptr);
+}
+
+// Bytes de un array de campo, redondeados a una línea de caché
+static size_t FieldBytes(size_t count, size_t size) {
+    return (count * size + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+}
+
+void Solver_ReleasePopulations(SimulationState *state, float *ptr) {
+    if (ptr != NULL && ptr == state->mapped_f) {
+        Checkpoint_Unmap(ptr, state->mapped_bytes);
+        state->mapped_f = NULL;
+        state->mapped_bytes = 0;
+    } else {
+        Solver_FreePopulations(ptr);
+    }
+}
+
+void Solver_InitFields(SimulationState *state, int width, int height) {
+    state->width = width;
+    state->height = height;
+    int N = width * height;
+    state->time_step = 0;
+    state->layout = LAYOUT_AOS;
+    state->stride = N;
+    state->isa = ISA_SCALAR;
+    state->f = NULL;
+    state->new_f = NULL;
+    state->mapped_f = NULL;
+    state->mapped_bytes = 0;
+
+    // rho, ux, uy y barrier en un solo bloque, cada uno en su línea de caché
+    size_t field = FieldBytes(N, sizeof(float));
+    unsigned char *arena = (unsigned char*)Arena_Alloc(3 * field + FieldBytes(N, sizeof(bool)));
+    state->field_arena = arena;
+    state->rho = (float*)arena;
+    state->ux = (float*)(arena + field);
+    state->uy = (float*)(arena + 2 * field);
+    state->barrier = (bool*)(arena + 3 * field);
+    state->barrier_shared = false;
+    memset(&state->links, 0, sizeof(state->links));
+    memset(&state->wall_links, 0, sizeof(state->wall_links));
+    state->barrier_dirty = true;
+    state->precision = PRECISION_FP32;
+    state->f_half = NULL;
+    state->new_f_half = NULL;
+    state->in_place = false;
+    state->aa_phase = 0;
+    state->sparse = false;
+    state->sparse_threshold = SOLVER_DEFAULT_SPARSE_THRESHOLD;
+    memset(&state->sparse_lattice, 0, sizeof(state->sparse_lattice));
+    state->diagnostics_requested = false;
+    memset(&state->diagnostics, 0, sizeof(state->diagnostics));
+    state->diagnostics.step = -1;
+    state->diagnostics_scratch = NULL;
+    state->diagnostics_scratch_bytes = 0;
+
+    // Por defecto se usan todos los núcleos disponibles
+    Solver_SetThreads(state, 0);
+    state->block_depth = 1;
+
+    // Primer toque con el mismo reparto que el paso (celdas contiguas por
+    // hilo = bandas de filas): cada banda queda en el nodo NUMA de su hilo
+    #pragma omp parallel for schedule(static) num_threads(state->num_threads)
+    for (int i = 0; i < N; i++) {
+        state->rho[i] = 0.0f;
+        state->ux[i] = 0.0f;
+        state->uy[i] = 0.0f;
+        state->barrier[i] = false;
+    }
 
     // Inicializar omega
     state->omega = 1.8f;
     state->inlet_velocity = 0.06f; 
+}
 
-    // Inicializar fluido quieto con densidad 1.0
+void Solver_Init(SimulationState *state, int width, int height) {
+    Solver_InitFields(state, width, height);
+    int N = width * height;
+    state->f = Solver_AllocPopulations((size_t)N * Q);
+    state->new_f = Solver_AllocPopulations((size_t)N * Q);
+
+    // Inicializar fluido quieto con densidad 1.0 (primer toque por bandas)
+    #pragma omp parallel for schedule(static) num_threads(state->num_threads)
     for (int i = 0; i < N; i++) {
         state->rho[i] = 1.0f;
         for (int k = 0; k < Q; k++) {
@@ -31,92 +112,721 @@ void Solver_Init(SimulationState *state) {
     }
 }
 
-void Solver_Step(SimulationState *state) {
-    int N = GRID_W * GRID_H;
+void Solver_SetThreads(SimulationState *state, int num_threads) {
+#ifdef _OPENMP
+    if (num_threads <= 0) num_threads = omp_get_max_threads();
+#else
+    num_threads = 1; // Compilado sin OpenMP: siempre serial
+#endif
+    if (num_threads > state->height) num_threads = state->height;
+    state->num_threads = num_threads;
+}
 
-    // 1. STREAMING (Propagación) + COLISIÓN BGK
-    for (int y = 0; y < GRID_H; y++) {
-        for (int x = 0; x < GRID_W; x++) {
-            int i = idx(x, y);
+SolverIsa Solver_DetectIsa(void) {
+    if (SolverSimd_HasAVX512()) return ISA_AVX512;
+    if (SolverSimd_HasAVX2()) return ISA_AVX2;
+    return ISA_SCALAR;
+}
 
-            // Si es barrera, no calculamos física compleja
-            if (state->barrier[i]) {
-                // Bounce-back simple (reflejo) se maneja al leer los vecinos
-                continue;
-            }
+const char *Solver_IsaName(SolverIsa isa) {
+    switch (isa) {
+        case ISA_AVX2: return "avx2";
+        case ISA_AVX512: return "avx512";
+        default: return "scalar";
+    }
+}
+
+SolverIsa Solver_SetIsa(SimulationState *state, SolverIsa isa) {
+    SolverIsa best = Solver_DetectIsa();
+    if (isa > best) isa = best;
+    state->isa = isa;
+    return isa;
+}
+
+void Solver_SetInPlace(SimulationState *state, bool in_place) {
+    if (in_place) {
+        SolverHalf_Leave(state);
+        SolverInPlace_Enter(state);
+    } else {
+        SolverInPlace_Leave(state);
+    }
+}
+
+void Solver_ShareBarrier(SimulationState *state, bool *barrier) {
+    // El propio queda sin usar dentro de field_arena
+    state->barrier = barrier;
+    state->barrier_shared = true;
+    state->barrier_dirty = true;
+}
+
+void Solver_SetPrecision(SimulationState *state, PopulationPrecision precision) {
+    if (precision == PRECISION_FP16) SolverHalf_Enter(state);
+    else SolverHalf_Leave(state);
+}
+
+// Intercambia f y new_f (en float o en half)
+static void SwapPopulations(SimulationState *state) {
+    float *temp = state->f;
+    state->f = state->new_f;
+    state->new_f = temp;
+
+    uint16_t *temp_half = state->f_half;
+    state->f_half = state->new_f_half;
+    state->new_f_half = temp_half;
+}
+
+void Solver_SetLayout(SimulationState *state, PopulationLayout layout) {
+    if (layout == LAYOUT_SOA) Solver_SetIsa(state, ISA_AVX512);
+    if ((int)layout == state->layout) return;
+    if (state->precision == PRECISION_FP16) {
+        // Half es siempre por planos: otro layout vuelve a float
+        SolverHalf_Leave(state);
+    }
+    if (state->in_place) {
+        // Se reordena en el formato normal y se vuelve al patrón AA
+        SolverInPlace_Leave(state);
+        Solver_SetLayout(state, layout);
+        SolverInPlace_Enter(state);
+        return;
+    }
+    if (state->sparse) {
+        // El almacenamiento compacto tiene su propio orden; el layout se
+        // aplica al volver a la grilla densa
+        state->layout = layout;
+        return;
+    }
+
+    int N = state->width * state->height;
+    int stride = Solver_DenseStride(layout, N);
+    size_t count = (size_t)stride * Q;
+
+    SimulationState next = *state;
+    next.layout = layout;
+    next.stride = stride;
+    next.f = Solver_AllocPopulations(count);
+    next.new_f = Solver_AllocPopulations(count);
+
+    // Llegan en cero; el reordenamiento es el primer toque, por bandas
+    #pragma omp parallel for schedule(static) num_threads(state->num_threads)
+    for (int i = 0; i < N; i++) {
+        for (int k = 0; k < Q; k++) {
+            next.f[PopIndex(&next, i, k)] = state->f[PopIndex(state, i, k)];
+            next.new_f[PopIndex(&next, i, k)] = state->new_f[PopIndex(state, i, k)];
+        }
+    }
 
-            // --- MACROSCOPIC (Calcular u y rho) ---
-            float rho = 0.0f;
-            float ux = 0.0f;
-            float uy = 0.0f;
-
-            // Leer distribuciones de los vecinos (STREAMING implícito)
-            for (int k = 0; k < Q; k++) {
-                // Celda vecina desde donde viene la partícula
-                int nx = x - cx[k];
-                int ny = y - cy[k];
-                
-                float f_val;
-                if (nx >= 0 && nx < GRID_W && ny >= 0 && ny < GRID_H) {
-                    int neighbor_idx = idx(nx, ny);
-                    
-                    if (state->barrier[neighbor_idx]) {
-                        // Si el vecino es pared, rebota la partícula que iba hacia allá
-                        // Leemos de NOSOTROS mismos en la dirección opuesta (opp[k])
-                        f_val = state->f[i*Q + opp[k]]; 
-                    } else {
-                        f_val = state->f[neighbor_idx*Q + k];
+    Solver_ReleasePopulations(state, state->f);
+    Solver_ReleasePopulations(state, state->new_f);
+    next.mapped_f = state->mapped_f;
+    next.mapped_bytes = state->mapped_bytes;
+    *state = next;
+}
+
+// Filas [y0, y1) que le tocan al hilo 'band' de 'num_bands'.
+// Bandas contiguas: cada hilo lee 'f' (compartido) y escribe solo sus filas de 'new_f'.
+static void BandRange(int height, int band, int num_bands, int *y0, int *y1) {
+    *y0 = (int)((long)height * band / num_bands);
+    *y1 = (int)((long)height * (band + 1) / num_bands);
+}
+
+// Rearma state->links a partir de barrier. Dos pasadas: contar y llenar,
+// así la memoria es exacta (las celdas de frontera suelen ser pocas).
+static void RebuildLinks(SimulationState *state) {
+    BoundaryLinks *links = &state->links;
+    int W = state->width;
+    int H = state->height;
+    const bool *barrier = state->barrier;
+
+    free(links->run_offset); free(links->run_begin); free(links->run_end);
+    free(links->cell_offset); free(links->cell); free(links->src);
+
+    links->run_offset = (int*)malloc((H + 1) * sizeof(int));
+    links->cell_offset = (int*)malloc((H + 1) * sizeof(int));
+
+    for (int pass = 0; pass < 2; pass++) {
+        int num_runs = 0, num_cells = 0, num_interior = 0;
+        for (int y = 0; y < H; y++) {
+            links->run_offset[y] = num_runs;
+            links->cell_offset[y] = num_cells;
+            int run_start = -1;
+            for (int x = 0; x <= W; x++) {
+                int i = y * W + x;
+                bool interior = false;
+                bool fluid = x < W && !barrier[i];
+                if (fluid && x > 0 && x < W - 1 && y > 0 && y < H - 1) {
+                    interior = true;
+                    for (int k = 1; k < Q; k++) {
+                        if (barrier[i - cx[k] - cy[k] * W]) { interior = false; break; }
+                    }
+                }
+
+                // Tramo de interiores: empieza / termina
+                if (interior && run_start < 0) run_start = i;
+                if (!interior && run_start >= 0) {
+                    if (pass == 1) {
+                        links->run_begin[num_runs] = run_start;
+                        links->run_end[num_runs] = i;
                     }
-                } else {
-                    f_val = w[k]; // Fronteras abiertas simples
+                    num_interior += i - run_start;
+                    num_runs++;
+                    run_start = -1;
                 }
 
-                // Sumamos para momentos macroscópicos
-                rho += f_val;
-                ux  += f_val * cx[k];
-                uy  += f_val * cy[k];
-                
-                // Guardamos temporalmente en new_f para usarlo en collision
-                state->new_f[i*Q + k] = f_val;
+                if (fluid && !interior) {
+                    if (pass == 1) {
+                        links->cell[num_cells] = i;
+                        int *src = links->src + (size_t)num_cells * Q;
+                        for (int k = 0; k < Q; k++) {
+                            int nx = x - cx[k];
+                            int ny = y - cy[k];
+                            if (nx < 0 || nx >= W || ny < 0 || ny >= H) src[k] = LINK_OPEN;
+                            else if (barrier[ny * W + nx]) src[k] = LINK_BOUNCE;
+                            else src[k] = ny * W + nx;
+                        }
+                    }
+                    num_cells++;
+                }
             }
-            
-            // Normalizar velocidad
-            if (rho > 0) {
-                ux /= rho;
-                uy /= rho;
+        }
+        links->run_offset[H] = num_runs;
+        links->cell_offset[H] = num_cells;
+        links->num_runs = num_runs;
+        links->num_cells = num_cells;
+        links->num_interior = num_interior;
+
+        if (pass == 0) {
+            // +1 para no pedir malloc(0) en grillas sin interiores o sin frontera
+            links->run_begin = (int*)malloc((num_runs + 1) * sizeof(int));
+            links->run_end = (int*)malloc((num_runs + 1) * sizeof(int));
+            links->cell = (int*)malloc((num_cells + 1) * sizeof(int));
+            links->src = (int*)malloc(((size_t)num_cells * Q + 1) * sizeof(int));
+        }
+    }
+    state->barrier_dirty = false;
+}
+
+void Solver_SetSparseThreshold(SimulationState *state, float solid_fraction) {
+    state->sparse_threshold = solid_fraction;
+    state->barrier_dirty = true; // Se reevalúa en el próximo paso
+}
+
+// Rearma state->wall_links: cada par (celda de fluido, dirección hacia una
+// pared vecina). Mismo recorrido en dos pasadas que RebuildLinks.
+static void RebuildWallLinks(SimulationState *state) {
+    WallLinks *walls = &state->wall_links;
+    int W = state->width;
+    int H = state->height;
+    const bool *barrier = state->barrier;
+
+    free(walls->cell); free(walls->dir);
+    walls->cell = NULL;
+    walls->dir = NULL;
+
+    for (int pass = 0; pass < 2; pass++) {
+        int count = 0, rows = 0;
+        for (int y = 0; y < H; y++) {
+            bool row_has_wall = false;
+            for (int x = 0; x < W; x++) {
+                int i = y * W + x;
+                if (barrier[i]) { row_has_wall = true; continue; }
+                for (int k = 1; k < Q; k++) {
+                    int nx = x + cx[k];
+                    int ny = y + cy[k];
+                    if (nx < 0 || nx >= W || ny < 0 || ny >= H || !barrier[ny * W + nx]) continue;
+                    if (pass == 1) {
+                        walls->cell[count] = i;
+                        walls->dir[count] = (unsigned char)k;
+                    }
+                    count++;
+                }
             }
+            rows += row_has_wall;
+        }
+        walls->count = count;
+        walls->frontal_height = rows;
+        if (pass == 0) {
+            walls->cell = (int*)malloc((count + 1) * sizeof(int));
+            walls->dir = (unsigned char*)malloc(count + 1);
+        }
+    }
+}
+
+// Rearma las estructuras que dependen de barrier y elige el almacenamiento:
+// compacto si la fracción de paredes alcanza sparse_threshold, denso si no.
+static void RebuildGeometry(SimulationState *state) {
+    RebuildWallLinks(state);
+    if (state->in_place) {
+        SolverInPlace_Normalize(state);
+        RebuildLinks(state);
+        return;
+    }
+    if (state->precision == PRECISION_FP16) {
+        RebuildLinks(state);
+        return;
+    }
+
+    int N = state->width * state->height;
+    int solid = 0;
+    for (int i = 0; i < N; i++) solid += state->barrier[i];
+
+    if ((float)solid >= state->sparse_threshold * N) {
+        SolverSparse_Build(state);
+        state->barrier_dirty = false;
+    } else {
+        SolverSparse_ToDense(state);
+        RebuildLinks(state);
+    }
+}
+
+// Stream + collide de las celdas interiores [i0, i1). La población k de la
+// celda i está en f[i*cs + k*ks]: (Q, 1) para AoS y (1, stride) para SoA.
+// Todos los vecinos son fluido dentro de la grilla: lectura directa, sin ramas.
+SOLVER_INLINE void StreamCollideInterior(SimulationState *state, int i0, int i1, int W, int cs, int ks) {
+    const float *f = state->f;
+    float *new_f = state->new_f;
+    const float omega = state->omega;
 
-            // --- INLET (Viento desde la izquierda) ---
-            if (x == 0) {
-                ux = state->inlet_velocity; // Velocidad de entrada
-                uy = 0.0f;
-                rho = 1.0f;
+    for (int i = i0; i < i1; i++) {
+        float fin[Q];
+        // Leer distribuciones de los vecinos (STREAMING implícito)
+        for (int k = 0; k < Q; k++) {
+            int neighbor_idx = i - cx[k] - cy[k] * W;
+            fin[k] = f[(size_t)neighbor_idx*cs + (size_t)k*ks];
+        }
+
+        float rho, ux, uy;
+        Lattice_Collide(fin, omega, false, 0.0f, &rho, &ux, &uy);
+
+        state->rho[i] = rho;
+        state->ux[i] = ux;
+        state->uy[i] = uy;
+
+        // Una sola escritura por población (ya colisionada)
+        for (int k = 0; k < Q; k++) {
+            new_f[(size_t)i*cs + (size_t)k*ks] = fin[k];
+        }
+    }
+}
+
+// Stream + collide de la celda de frontera número b (de la fila y)
+SOLVER_INLINE void StreamCollideBoundary(SimulationState *state, int b, int y, int W, int cs, int ks) {
+    const float *f = state->f;
+    int i = state->links.cell[b];
+    const int *src = state->links.src + (size_t)b * Q;
+    float fin[Q];
+
+    for (int k = 0; k < Q; k++) {
+        if (src[k] >= 0) {
+            fin[k] = f[(size_t)src[k]*cs + (size_t)k*ks];
+        } else if (src[k] == LINK_BOUNCE) {
+            // Si el vecino es pared, rebota la partícula que iba hacia allá
+            // Leemos de NOSOTROS mismos en la dirección opuesta (opp[k])
+            fin[k] = f[(size_t)i*cs + (size_t)opp[k]*ks];
+        } else {
+            fin[k] = w[k]; // Fronteras abiertas simples
+        }
+    }
+
+    float rho, ux, uy;
+    bool inlet = (i - y * W) == 0; // Columna x = 0
+    Lattice_Collide(fin, state->omega, inlet, state->inlet_velocity, &rho, &ux, &uy);
+
+    state->rho[i] = rho;
+    state->ux[i] = ux;
+    state->uy[i] = uy;
+
+    for (int k = 0; k < Q; k++) {
+        state->new_f[(size_t)i*cs + (size_t)k*ks] = fin[k];
+    }
+}
+
+// Filas [y0, y1): primero los tramos interiores (SIMD si hay), después las
+// celdas de frontera. Las barreras no se recorren.
+SOLVER_INLINE void StepRowsLayout(SimulationState *state, int y0, int y1, int W, int cs, int ks) {
+    const BoundaryLinks *links = &state->links;
+    bool simd = state->layout == LAYOUT_SOA && state->isa != ISA_SCALAR;
+
+    // Perfil: interior y frontera se acumulan por fila y se suman al final
+    uint64_t interior_ticks = 0, boundary_ticks = 0, interior_cells = 0;
+    bool profile = profile_enabled;
+
+    for (int y = y0; y < y1; y++) {
+        uint64_t t0 = profile ? Profile_Ticks() : 0;
+        for (int r = links->run_offset[y]; r < links->run_offset[y + 1]; r++) {
+            int i = links->run_begin[r];
+            int end = links->run_end[r];
+            if (profile) interior_cells += end - i;
+            if (simd) {
+                i = (state->isa == ISA_AVX512) ? SolverSimd_InteriorAVX512(state, i, end)
+                                               : SolverSimd_InteriorAVX2(state, i, end);
             }
+            StreamCollideInterior(state, i, end, W, cs, ks);
+        }
+        uint64_t t1 = profile ? Profile_Ticks() : 0;
+        for (int b = links->cell_offset[y]; b < links->cell_offset[y + 1]; b++) {
+            StreamCollideBoundary(state, b, y, W, cs, ks);
+        }
+        if (profile) {
+            interior_ticks += t1 - t0;
+            boundary_ticks += Profile_Ticks() - t1;
+        }
+    }
+
+    if (profile) {
+        Profile_Add(PROF_INTERIOR, interior_ticks, interior_cells);
+        Profile_Add(PROF_BOUNDARY, boundary_ticks, links->cell_offset[y1] - links->cell_offset[y0]);
+    }
+}
+
+SOLVER_INLINE void StepRowsAoS(SimulationState *state, int y0, int y1, int W) {
+    StepRowsLayout(state, y0, y1, W, Q, 1);
+}
+
+SOLVER_INLINE void StepRowsSoA(SimulationState *state, int y0, int y1, int W) {
+    StepRowsLayout(state, y0, y1, W, 1, state->stride);
+}
+
+// Stream + collide de las filas [y0, y1). Cada celda depende solo de 'f',
+// así que el resultado no depende de cómo se repartan las filas.
+// Con el ancho como constante el compilador resuelve los desplazamientos a
+// los vecinos; los tamaños habituales tienen su propia copia del kernel.
+#define STEP_ROWS_WIDTH(W) \
+    if (state->layout == LAYOUT_SOA) StepRowsSoA(state, y0, y1, W); \
+    else StepRowsAoS(state, y0, y1, W);
+
+static void StepRows(SimulationState *state, int y0, int y1) {
+    if (state->in_place) {
+        SolverInPlace_StepRows(state, y0, y1);
+        return;
+    }
+    if (state->precision == PRECISION_FP16) {
+        SolverHalf_StepRows(state, y0, y1);
+        return;
+    }
+    if (state->sparse) {
+        SolverSparse_StepRows(state, y0, y1);
+        return;
+    }
+    switch (state->width) {
+        case 256:  STEP_ROWS_WIDTH(256);  break;
+        case 400:  STEP_ROWS_WIDTH(400);  break;
+        case 512:  STEP_ROWS_WIDTH(512);  break;
+        case 1024: STEP_ROWS_WIDTH(1024); break;
+        case 2000: STEP_ROWS_WIDTH(2000); break;
+        case 4096: STEP_ROWS_WIDTH(4096); break;
+        default:   STEP_ROWS_WIDTH(state->width); break;
+    }
+}
+
+void Solver_RequestDiagnostics(SimulationState *state) {
+    state->diagnostics_requested = true;
+}
+
+// Post-colisión del último paso de la celda i en la dirección k, que va hacia
+// una pared: en cada modo es la que el próximo paso rebota
+static inline float WallPopulation(const SimulationState *state, int i, int k) {
+    if (state->precision == PRECISION_FP16) {
+        return Half_ToFloat(state->f_half[(size_t)k * state->stride + i]) * HALF_INV_SCALE + w[k];
+    }
+    if (state->sparse) {
+        const SparseLattice *sparse = &state->sparse_lattice;
+        return state->f[(size_t)k * sparse->stride + sparse->slot[i]];
+    }
+    // Patrón AA: en las dos fases el rebote queda invertido en la propia celda
+    if (state->in_place) return state->f[PopIndex(state, i, opp[k])];
+    return state->f[PopIndex(state, i, k)];
+}
+
+void Solver_ComputeForces(const SimulationState *state, double *fx, double *fy) {
+    const WallLinks *walls = &state->wall_links;
+    double sum_x = 0.0, sum_y = 0.0;
+    for (int l = 0; l < walls->count; l++) {
+        int k = walls->dir[l];
+        // La población va y vuelve: le deja 2 f c_k de momento a la pared
+        double f2 = 2.0 * WallPopulation(state, walls->cell[l], k);
+        sum_x += f2 * cx[k];
+        sum_y += f2 * cy[k];
+    }
+    *fx = sum_x;
+    *fy = sum_y;
+}
+
+// Sumas parciales de una banda, rellenadas a una línea de caché para que
+// los hilos no compartan líneas al acumular
+typedef struct {
+    double mass;
+    double energy;
+    double diff2;   // Suma de |u(n) - u(n-1)|^2
+    double norm2;   // Suma de |u(n)|^2
+    float max_usq;
+    char pad[64 - 4 * sizeof(double) - sizeof(float)];
+} DiagnosticsPartial;
+
+// StepRows fila por fila, acumulando las métricas de cada fila apenas se
+// calcula (todavía en caché). La velocidad anterior se copia a 'old_u'
+// (2 W floats de la banda) antes de que el kernel la pise, así el residual
+// no necesita otra copia del campo.
+static void StepRowsDiagnostics(SimulationState *state, int y0, int y1, float *old_u,
+                                DiagnosticsPartial *out) {
+    int W = state->width;
+    double mass = 0.0, energy = 0.0, diff2 = 0.0, norm2 = 0.0;
+    float max_usq = 0.0f;
+
+    for (int y = y0; y < y1; y++) {
+        int row = y * W;
+        memcpy(old_u, state->ux + row, W * sizeof(float));
+        memcpy(old_u + W, state->uy + row, W * sizeof(float));
+
+        StepRows(state, y, y + 1);
+
+        // Sumas en double (en filas anchas una suma en float de rho ~ 1 ya
+        // pierde la deriva de masa que se quiere ver). Masa y energía de
+        // todas las celdas; residual y máximo solo del fluido.
+        const float *rho = state->rho + row;
+        const float *ux = state->ux + row;
+        const float *uy = state->uy + row;
+        const bool *barrier = state->barrier + row;
+        #pragma omp simd reduction(+:mass, energy, diff2, norm2) reduction(max:max_usq)
+        for (int x = 0; x < W; x++) {
+            float fluid = barrier[x] ? 0.0f : 1.0f;
+            float usq = ux[x]*ux[x] + uy[x]*uy[x];
+            float dx = ux[x] - old_u[x];
+            float dy = uy[x] - old_u[W + x];
+            mass += rho[x];
+            energy += 0.5 * rho[x] * usq;
+            diff2 += (double)((dx*dx + dy*dy) * fluid);
+            norm2 += (double)(usq * fluid);
+            max_usq = usq * fluid > max_usq ? usq * fluid : max_usq;
+        }
+    }
+
+    out->mass = mass;
+    out->energy = energy;
+    out->diff2 = diff2;
+    out->norm2 = norm2;
+    out->max_usq = max_usq;
+}
+
+// Filas [y0, y1) con métricas: las bandas son las mismas que sin métricas y
+// las parciales se suman a state->diagnostics en orden de banda (resultado
+// reproducible)
+static void StepRangeDiagnostics(SimulationState *state, int y0, int y1) {
+    int num_bands = state->num_threads > 1 ? state->num_threads : 1;
+
+    // Memoria de trabajo del estado: las sumas de cada banda y, después,
+    // la velocidad anterior de cada banda (cada una en sus líneas de caché)
+    size_t row_bytes = (2 * (size_t)state->width * sizeof(float) + 63) / 64 * 64;
+    size_t bytes = num_bands * (sizeof(DiagnosticsPartial) + row_bytes);
+    if (state->diagnostics_scratch_bytes < bytes) {
+        Arena_Free(state->diagnostics_scratch);
+        state->diagnostics_scratch = Arena_Alloc(bytes);
+        state->diagnostics_scratch_bytes = bytes;
+    }
+    DiagnosticsPartial *partial = (DiagnosticsPartial*)state->diagnostics_scratch;
+    unsigned char *old_u = (unsigned char*)(partial + num_bands);
+    memset(partial, 0, num_bands * sizeof(DiagnosticsPartial));
 
-            state->rho[i] = rho;
-            state->ux[i] = ux;
-            state->uy[i] = uy;
-
-            // --- COLLISION (Relajación al equilibrio) ---
-            for (int k = 0; k < Q; k++) {
-                float cu = 3.0f * (cx[k]*ux + cy[k]*uy);
-                float f_eq = w[k] * rho * (1.0f + cu + 0.5f*(cu*cu) - 1.5f*(ux*ux + uy*uy));
-                
-                // Relajación (omega variable)
-                float omega = state->omega; 
-                state->new_f[i*Q + k] = (1.0f - omega) * state->new_f[i*Q + k] + omega * f_eq;
+#ifdef _OPENMP
+    if (num_bands > 1) {
+        #pragma omp parallel num_threads(num_bands)
+        {
+            int b0, b1;
+            int band = omp_get_thread_num();
+            BandRange(y1 - y0, band, omp_get_num_threads(), &b0, &b1);
+            uint64_t t = Profile_Begin();
+            StepRowsDiagnostics(state, y0 + b0, y0 + b1, (float*)(old_u + band * row_bytes), &partial[band]);
+            Profile_EndItems(PROF_STEP, t, (uint64_t)(b1 - b0) * state->width);
+        }
+    } else
+#endif
+    {
+        uint64_t t = Profile_Begin();
+        StepRowsDiagnostics(state, y0, y1, (float*)old_u, &partial[0]);
+        Profile_EndItems(PROF_STEP, t, (uint64_t)(y1 - y0) * state->width);
+    }
+
+    SolverDiagnostics *d = &state->diagnostics;
+    for (int b = 0; b < num_bands; b++) {
+        d->mass += partial[b].mass;
+        d->kinetic_energy += partial[b].energy;
+        d->velocity_change2 += partial[b].diff2;
+        d->velocity_norm2 += partial[b].norm2;
+        // sqrtf es monótona: igual que tomar la raíz del máximo
+        float max_velocity = sqrtf(partial[b].max_usq);
+        if (max_velocity > d->max_velocity) d->max_velocity = max_velocity;
+    }
+}
+
+// Reconstrucción de la geometría, medida
+static void UpdateGeometry(SimulationState *state) {
+    uint64_t t = Profile_Begin();
+    RebuildGeometry(state);
+    Profile_End(PROF_GEOMETRY, t);
+}
+
+void Solver_BeginStep(SimulationState *state) {
+    if (state->barrier_dirty) UpdateGeometry(state);
+
+    if (state->diagnostics_requested) {
+        SolverDiagnostics *d = &state->diagnostics;
+        d->mass = 0.0;
+        d->kinetic_energy = 0.0;
+        d->max_velocity = 0.0f;
+        d->velocity_change2 = 0.0;
+        d->velocity_norm2 = 0.0;
+    }
+}
+
+void Solver_StepRange(SimulationState *state, int y0, int y1) {
+    if (y0 >= y1) return;
+    if (state->diagnostics_requested) {
+        StepRangeDiagnostics(state, y0, y1);
+        return;
+    }
+#ifdef _OPENMP
+    if (state->num_threads > 1) {
+        #pragma omp parallel num_threads(state->num_threads)
+        {
+            int b0, b1;
+            BandRange(y1 - y0, omp_get_thread_num(), omp_get_num_threads(), &b0, &b1);
+            uint64_t t = Profile_Begin();
+            StepRows(state, y0 + b0, y0 + b1);
+            Profile_EndItems(PROF_STEP, t, (uint64_t)(b1 - b0) * state->width);
+        }
+        return;
+    }
+#endif
+    uint64_t t = Profile_Begin();
+    StepRows(state, y0, y1);
+    Profile_EndItems(PROF_STEP, t, (uint64_t)(y1 - y0) * state->width);
+}
+
+void Solver_EndStep(SimulationState *state) {
+    if (state->diagnostics_requested) {
+        SolverDiagnostics *d = &state->diagnostics;
+        d->residual = d->velocity_norm2 > 0.0 ? sqrt(d->velocity_change2 / d->velocity_norm2) : 0.0;
+        d->step = state->time_step + 1;
+        state->diagnostics_requested = false;
+    }
+
+    // Actualizar punteros (Swap); en el lugar solo cambia la fase
+    if (state->in_place) state->aa_phase ^= 1;
+    else SwapPopulations(state);
+
+    state->time_step++;
+}
+
+void Solver_Step(SimulationState *state) {
+    Solver_BeginStep(state);
+    Solver_StepRange(state, 0, state->height);
+    Solver_EndStep(state);
+}
+
+void Solver_SetTemporalBlocking(SimulationState *state, int depth) {
+    state->block_depth = depth < 1 ? 1 : depth;
+}
+
+// Bloqueo temporal. El nivel d (1..depth) es el paso time_step + d: lee el
+// buffer del nivel d-1 y escribe sobre el del nivel d-2 (los mismos dos
+// buffers de siempre). levels[0] escribe en new_f y levels[1] en f.
+//
+// Fase 1, por banda: frente de onda. En la etapa s el nivel d calcula la
+// fila s-(d-1), así las tres filas que necesita del nivel anterior ya están
+// y la fila que pisa ya no la usa nadie. Hacia los bordes con otra banda
+// cada nivel se achica una fila (trapecio) para no leer filas ajenas.
+static void BlockBand(SimulationState *levels[2], int depth, int y0, int y1) {
+    int H = levels[0]->height;
+    int shrink_lo = y0 > 0 ? 1 : 0;
+    int shrink_hi = y1 < H ? 1 : 0;
+
+    for (int s = y0; s < y1 + depth - 1; s++) {
+        for (int d = 1; d <= depth; d++) {
+            int y = s - (d - 1);
+            if (y >= y0 + shrink_lo * (d - 1) && y < y1 - shrink_hi * (d - 1)) {
+                StepRows(levels[(d - 1) & 1], y, y + 1);
             }
         }
     }
+}
 
-    // 2. Actualizar punteros (Swap)
-    float *temp = state->f;
-    state->f = state->new_f;
-    state->new_f = temp;
+// Fase 2: el triángulo que quedó sin calcular alrededor del borde b entre
+// dos bandas, nivel por nivel (todas sus dependencias ya están)
+static void BlockSeam(SimulationState *levels[2], int depth, int b) {
+    for (int d = 2; d <= depth; d++) {
+        StepRows(levels[(d - 1) & 1], b - (d - 1), b + (d - 1));
+    }
+}
+
+// 'depth' pasos en un barrido
+static void StepBlock(SimulationState *state, int depth) {
+    if (state->barrier_dirty) UpdateGeometry(state);
+
+    SimulationState swapped = *state;
+    SwapPopulations(&swapped);
+    SimulationState *levels[2] = { state, &swapped };
+
+    // Cada banda necesita al menos 2*depth filas para su trapecio
+    int num_bands = state->num_threads;
+    if (num_bands > state->height / (2 * depth)) num_bands = state->height / (2 * depth);
+    if (num_bands < 1) num_bands = 1;
+
+#ifdef _OPENMP
+    if (num_bands > 1) {
+        #pragma omp parallel num_threads(num_bands)
+        {
+            int y0, y1;
+            int band = omp_get_thread_num();
+            BandRange(state->height, band, omp_get_num_threads(), &y0, &y1);
+            uint64_t t = Profile_Begin();
+            BlockBand(levels, depth, y0, y1);
+            Profile_EndItems(PROF_STEP, t, (uint64_t)(y1 - y0) * state->width * depth);
+            #pragma omp barrier
+            t = Profile_Begin();
+            if (band > 0) BlockSeam(levels, depth, y0);
+            Profile_End(PROF_STEP, t);
+        }
+    } else
+#endif
+    {
+        uint64_t t = Profile_Begin();
+        BlockBand(levels, depth, 0, state->height);
+        Profile_EndItems(PROF_STEP, t, (uint64_t)state->width * state->height * depth);
+    }
+
+    // Con una cantidad impar de niveles el último quedó en new_f
+    if (depth & 1) SwapPopulations(state);
+    state->time_step += depth;
+}
+
+void Solver_Advance(SimulationState *state, int steps) {
+    // Las métricas necesitan la velocidad del paso anterior: el último paso va aparte
+    int last = state->diagnostics_requested ? 1 : 0;
+    if (steps < last) return;
+
+    int remaining = steps - last;
+    if (state->block_depth > 1 && !state->in_place) {
+        while (remaining >= state->block_depth) {
+            StepBlock(state, state->block_depth);
+            remaining -= state->block_depth;
+        }
+    }
+    bool request = state->diagnostics_requested;
+    state->diagnostics_requested = false;
+    for (; remaining > 0; remaining--) Solver_Step(state);
+    state->diagnostics_requested = request;
+    if (last) Solver_Step(state);
 }
 
 void Solver_Cleanup(SimulationState *state) {
-    free(state->f); free(state->new_f);
-    free(state->rho); free(state->ux); free(state->uy);
-    free(state->barrier);
-}
\ No newline at end of file
+    Solver_ReleasePopulations(state, state->f);
+    Solver_ReleasePopulations(state, state->new_f);
+    Arena_Free(state->field_arena); // rho, ux, uy y barrier (si no es compartida)
+
+    BoundaryLinks *links = &state->links;
+    free(links->run_offset); free(links->run_begin); free(links->run_end);
+    free(links->cell_offset); free(links->cell); free(links->src);
+    free(state->wall_links.cell); free(state->wall_links.dir);
+    SolverSparse_Free(&state->sparse_lattice);
+    SolverHalf_Free(state);
+    Arena_Free(state->diagnostics_scratch);
+}
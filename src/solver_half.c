@@ -0,0 +1,175 @@
+#include "solver.h"
+#include "solver_internal.h"
+#include "solver_simd.h"
+#include "lattice.h"
+#include "half.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Poblaciones en 16 bits (IEEE half) guardadas como desvío del equilibrio en
+// reposo: f = half * HALF_INV_SCALE + w[k]. Los desvíos son chicos, así el
+// half conserva ~3-4 cifras de f. La colisión se hace en float con el mismo
+// Lattice_Collide. Los kernels SIMD hacen exactamente las mismas operaciones.
+// Siempre por planos (LAYOUT_SOA) y con la grilla densa.
+
+static uint16_t *AllocHalf(size_t count) {
+    // Mismo alineamiento que las poblaciones en float (el tamaño es par)
+    return (uint16_t*)Solver_AllocPopulations((count + 1) / 2);
+}
+
+static void FreeHalf(uint16_t *ptr) {
+    Solver_FreePopulations((float*)ptr);
+}
+
+SOLVER_INLINE float FromHalf(uint16_t h, int k) {
+    return Half_ToFloat(h) * HALF_INV_SCALE + w[k];
+}
+
+SOLVER_INLINE uint16_t ToHalf(float f, int k) {
+    return Half_FromFloat((f - w[k]) * HALF_SCALE);
+}
+
+SOLVER_INLINE float LoadPop(const uint16_t *f, size_t p, int k) {
+    return FromHalf(f[p], k);
+}
+
+SOLVER_INLINE void StoreCell(SimulationState *state, int i, float fin[Q]) {
+    const size_t S = state->stride;
+    uint16_t *new_f = state->new_f_half;
+    for (int k = 0; k < Q; k++) new_f[(size_t)k*S + i] = ToHalf(fin[k], k);
+}
+
+// Celda interior [i0, i1): todos los vecinos son fluido
+static void StreamCollideInterior(SimulationState *state, int i0, int i1) {
+    const size_t S = state->stride;
+    const int W = state->width;
+    const uint16_t *f = state->f_half;
+
+    for (int i = i0; i < i1; i++) {
+        float fin[Q];
+        for (int k = 0; k < Q; k++) {
+            fin[k] = LoadPop(f, (size_t)k*S + (i - cx[k] - cy[k] * W), k);
+        }
+
+        float rho, ux, uy;
+        Lattice_Collide(fin, state->omega, false, 0.0f, &rho, &ux, &uy);
+        state->rho[i] = rho;
+        state->ux[i] = ux;
+        state->uy[i] = uy;
+        StoreCell(state, i, fin);
+    }
+}
+
+// Celda de frontera número b de la fila y (tabla de vecinos de 'links')
+static void StreamCollideBoundary(SimulationState *state, int b, int y) {
+    const size_t S = state->stride;
+    const uint16_t *f = state->f_half;
+    int i = state->links.cell[b];
+    const int *src = state->links.src + (size_t)b * Q;
+    float fin[Q];
+
+    for (int k = 0; k < Q; k++) {
+        if (src[k] >= 0) fin[k] = LoadPop(f, (size_t)k*S + src[k], k);
+        else if (src[k] == LINK_BOUNCE) fin[k] = LoadPop(f, (size_t)opp[k]*S + i, k); // w[opp k] == w[k]
+        else fin[k] = w[k];
+    }
+
+    float rho, ux, uy;
+    bool inlet = (i - y * state->width) == 0;
+    Lattice_Collide(fin, state->omega, inlet, state->inlet_velocity, &rho, &ux, &uy);
+    state->rho[i] = rho;
+    state->ux[i] = ux;
+    state->uy[i] = uy;
+    StoreCell(state, i, fin);
+}
+
+void SolverHalf_StepRows(SimulationState *state, int y0, int y1) {
+    const BoundaryLinks *links = &state->links;
+    bool avx512 = state->isa == ISA_AVX512;
+    bool avx2 = state->isa == ISA_AVX2 && SolverSimd_HasF16C();
+
+    for (int y = y0; y < y1; y++) {
+        for (int r = links->run_offset[y]; r < links->run_offset[y + 1]; r++) {
+            int i = links->run_begin[r];
+            int end = links->run_end[r];
+            if (avx512) i = SolverSimd_HalfAVX512(state, i, end);
+            else if (avx2) i = SolverSimd_HalfAVX2(state, i, end);
+            StreamCollideInterior(state, i, end);
+        }
+        for (int b = links->cell_offset[y]; b < links->cell_offset[y + 1]; b++) {
+            StreamCollideBoundary(state, b, y);
+        }
+    }
+}
+
+// Las conversiones recorren celdas (todas las direcciones de cada una) con
+// el reparto del paso: si 'out' es nuevo, cada banda queda en su nodo NUMA
+void SolverHalf_Export(const SimulationState *state, float *out) {
+    int S = state->stride;
+    #pragma omp parallel for schedule(static) num_threads(state->num_threads)
+    for (int i = 0; i < S; i++) {
+        for (int k = 0; k < Q; k++) {
+            size_t p = (size_t)k * S + i;
+            out[p] = FromHalf(state->f_half[p], k);
+        }
+    }
+}
+
+void SolverHalf_Enter(SimulationState *state) {
+    if (state->precision == PRECISION_FP16) return;
+    SolverInPlace_Leave(state);
+    SolverSparse_ToDense(state);
+    Solver_SetLayout(state, LAYOUT_SOA);
+
+    int S = state->stride;
+    SolverHalf_Alloc(state);
+    #pragma omp parallel for schedule(static) num_threads(state->num_threads)
+    for (int i = 0; i < S; i++) {
+        for (int k = 0; k < Q; k++) {
+            size_t p = (size_t)k * S + i;
+            state->f_half[p] = ToHalf(state->f[p], k);
+            state->new_f_half[p] = ToHalf(state->new_f[p], k);
+        }
+    }
+
+    Solver_ReleasePopulations(state, state->f);
+    Solver_ReleasePopulations(state, state->new_f);
+    state->f = NULL;
+    state->new_f = NULL;
+    state->precision = PRECISION_FP16;
+    state->barrier_dirty = true; // Sin almacenamiento compacto en este modo
+}
+
+void SolverHalf_Leave(SimulationState *state) {
+    if (state->precision != PRECISION_FP16) return;
+
+    size_t count = (size_t)Q * state->stride;
+    state->f = Solver_AllocPopulations(count);
+    state->new_f = Solver_AllocPopulations(count);
+    SolverHalf_Export(state, state->f);
+    int S = state->stride;
+    #pragma omp parallel for schedule(static) num_threads(state->num_threads)
+    for (int i = 0; i < S; i++) {
+        for (int k = 0; k < Q; k++) {
+            size_t p = (size_t)k * S + i;
+            state->new_f[p] = FromHalf(state->new_f_half[p], k);
+        }
+    }
+
+    SolverHalf_Free(state);
+    state->precision = PRECISION_FP32;
+    state->barrier_dirty = true;
+}
+
+void SolverHalf_Alloc(SimulationState *state) {
+    size_t count = (size_t)Q * state->stride;
+    state->f_half = AllocHalf(count);
+    state->new_f_half = AllocHalf(count);
+}
+
+void SolverHalf_Free(SimulationState *state) {
+    FreeHalf(state->f_half);
+    FreeHalf(state->new_f_half);
+    state->f_half = NULL;
+    state->new_f_half = NULL;
+}
@@ -0,0 +1,190 @@
+#include "solver.h"
+#include "solver_internal.h"
+#include "solver_simd.h"
+#include "lattice.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Propagación en el lugar (patrón AA): un solo arreglo de poblaciones.
+//
+// Fase 1 (f guarda las post-colisión de cada celda invertidas, f[x][opp k]):
+//   la celda x junta sus entradas de los vecinos, colisiona y escribe cada
+//   salida directamente en la celda destino, f[x + c_k][k]. Si el destino es
+//   pared rebota sobre sí misma (f[x][opp k]) y si cae fuera de la grilla se
+//   deja el equilibrio en reposo, igual que el kernel de dos buffers.
+// Fase 0 (f guarda las entradas ya propagadas, f[x][k]):
+//   todo local: lee f[x][k], colisiona y guarda invertido en f[x][opp k].
+//
+// En las dos fases cada posición de f la lee y la escribe una sola celda,
+// así las celdas se pueden recorrer en cualquier orden y con varios hilos.
+// La aritmética es la de Lattice_Collide: mismos bits que Solver_Step normal.
+
+// Entradas (ya propagadas) de la celda i en la fase 1, según sus vecinos
+SOLVER_INLINE void GatherOdd(const float *f, int i, const int *src, int W, int cs, int ks, float fin[Q]) {
+    for (int k = 0; k < Q; k++) {
+        int s = src != NULL ? src[k] : i - cx[k] - cy[k] * W;
+        if (s >= 0) fin[k] = f[(size_t)s*cs + (size_t)opp[k]*ks];
+        else if (s == LINK_BOUNCE) fin[k] = f[(size_t)i*cs + (size_t)k*ks];
+        else fin[k] = w[k];
+    }
+}
+
+// Salidas de la celda i en la fase 1: a los vecinos (src[opp k] = i + c_k)
+SOLVER_INLINE void ScatterOdd(float *f, int i, const int *src, int W, int cs, int ks, const float out[Q]) {
+    for (int k = 0; k < Q; k++) {
+        int t = src != NULL ? src[opp[k]] : i + cx[k] + cy[k] * W;
+        if (t >= 0) f[(size_t)t*cs + (size_t)k*ks] = out[k];
+        else if (t == LINK_BOUNCE) f[(size_t)i*cs + (size_t)opp[k]*ks] = out[k];
+        else f[(size_t)i*cs + (size_t)opp[k]*ks] = w[opp[k]];
+    }
+}
+
+// Una celda (src == NULL: interior, todos los vecinos son fluido)
+SOLVER_INLINE void StepCell(SimulationState *state, int i, const int *src, bool inlet,
+                            int W, int cs, int ks) {
+    float *f = state->f;
+    float fin[Q];
+    if (state->aa_phase) {
+        GatherOdd(f, i, src, W, cs, ks, fin);
+    } else {
+        for (int k = 0; k < Q; k++) fin[k] = f[(size_t)i*cs + (size_t)k*ks];
+    }
+
+    float rho, ux, uy;
+    Lattice_Collide(fin, state->omega, inlet, state->inlet_velocity, &rho, &ux, &uy);
+    state->rho[i] = rho;
+    state->ux[i] = ux;
+    state->uy[i] = uy;
+
+    if (state->aa_phase) {
+        ScatterOdd(f, i, src, W, cs, ks, fin);
+    } else {
+        for (int k = 0; k < Q; k++) f[(size_t)i*cs + (size_t)opp[k]*ks] = fin[k];
+    }
+}
+
+// Filas [y0, y1) con los mismos tramos interiores / celdas de frontera que el
+// kernel de dos buffers (state->links)
+SOLVER_INLINE void StepRowsLayout(SimulationState *state, int y0, int y1, int cs, int ks) {
+    const BoundaryLinks *links = &state->links;
+    int W = state->width;
+    bool simd = state->layout == LAYOUT_SOA && state->isa != ISA_SCALAR;
+    bool odd = state->aa_phase != 0;
+
+    for (int y = y0; y < y1; y++) {
+        for (int r = links->run_offset[y]; r < links->run_offset[y + 1]; r++) {
+            int i = links->run_begin[r];
+            int end = links->run_end[r];
+            if (simd) {
+                i = (state->isa == ISA_AVX512) ? SolverSimd_InPlaceAVX512(state, i, end, odd)
+                                               : SolverSimd_InPlaceAVX2(state, i, end, odd);
+            }
+            for (; i < end; i++) StepCell(state, i, NULL, false, W, cs, ks);
+        }
+        for (int b = links->cell_offset[y]; b < links->cell_offset[y + 1]; b++) {
+            int i = links->cell[b];
+            StepCell(state, i, links->src + (size_t)b * Q, i == y * W, W, cs, ks);
+        }
+    }
+}
+
+void SolverInPlace_StepRows(SimulationState *state, int y0, int y1) {
+    if (state->layout == LAYOUT_SOA) StepRowsLayout(state, y0, y1, 1, state->stride);
+    else StepRowsLayout(state, y0, y1, Q, 1);
+}
+
+// Invierte las direcciones de cada celda (f[x][k] <-> f[x][opp k])
+static void ReverseCells(SimulationState *state, float *f) {
+    int N = state->width * state->height;
+    for (int i = 0; i < N; i++) {
+        for (int k = 1; k < Q; k++) {
+            if (opp[k] < k) continue;
+            size_t a = PopIndex(state, i, k);
+            size_t b = PopIndex(state, i, opp[k]);
+            float t = f[a];
+            f[a] = f[b];
+            f[b] = t;
+        }
+    }
+}
+
+void SolverInPlace_Canonical(const SimulationState *state, float *out) {
+    int N = state->width * state->height;
+    const float *f = state->f;
+
+    // Fase 1 y paredes: solo invertir
+    for (int i = 0; i < N; i++) {
+        for (int k = 0; k < Q; k++) out[PopIndex(state, i, k)] = f[PopIndex(state, i, opp[k])];
+    }
+    if (state->aa_phase) return;
+
+    // Fase 0: la post-colisión de x en la dirección k ya se propagó a x + c_k
+    // (o rebotó en x). Las celdas de fluido son las de 'links', que describe
+    // la geometría con la que se dio el último paso.
+    const BoundaryLinks *links = &state->links;
+    int W = state->width;
+    for (int r = 0; r < links->num_runs; r++) {
+        for (int i = links->run_begin[r]; i < links->run_end[r]; i++) {
+            for (int k = 0; k < Q; k++) {
+                out[PopIndex(state, i, k)] = f[PopIndex(state, i + cx[k] + cy[k] * W, k)];
+            }
+        }
+    }
+    for (int b = 0; b < links->num_cells; b++) {
+        int i = links->cell[b];
+        const int *src = links->src + (size_t)b * Q;
+        for (int k = 0; k < Q; k++) {
+            int t = src[opp[k]];
+            if (t >= 0) out[PopIndex(state, i, k)] = f[PopIndex(state, t, k)];
+            else if (t == LINK_BOUNCE) out[PopIndex(state, i, k)] = f[PopIndex(state, i, opp[k])];
+            else out[PopIndex(state, i, k)] = w[k]; // Salió de la grilla: nadie la lee
+        }
+    }
+}
+
+void SolverInPlace_Normalize(SimulationState *state) {
+    if (state->aa_phase) return;
+
+    // Pasar de fase 0 a fase 1 necesita un arreglo temporal (solo al editar
+    // paredes o cambiar de modo, nunca en el paso normal)
+    size_t count = (size_t)Q * state->stride;
+    float *canonical = Solver_AllocPopulations(count);
+    SolverInPlace_Canonical(state, canonical);
+    Solver_ReleasePopulations(state, state->f);
+    state->f = canonical;
+    ReverseCells(state, state->f);
+    state->aa_phase = 1;
+}
+
+void SolverInPlace_Enter(SimulationState *state) {
+    if (state->in_place) return;
+    SolverSparse_ToDense(state);
+
+    Solver_ReleasePopulations(state, state->new_f);
+    state->new_f = NULL;
+    ReverseCells(state, state->f);
+    state->aa_phase = 1;
+    state->in_place = true;
+    state->barrier_dirty = true; // Sin almacenamiento compacto en este modo
+}
+
+void SolverInPlace_Leave(SimulationState *state) {
+    if (!state->in_place) return;
+    SolverInPlace_Normalize(state);
+    ReverseCells(state, state->f);
+
+    size_t count = (size_t)Q * state->stride;
+    state->new_f = Solver_AllocPopulations(count);
+    // Copia por celdas con el reparto del paso (primer toque de new_f)
+    int N = state->width * state->height;
+    #pragma omp parallel for schedule(static) num_threads(state->num_threads)
+    for (int i = 0; i < N; i++) {
+        for (int k = 0; k < Q; k++) {
+            size_t p = PopIndex(state, i, k);
+            state->new_f[p] = state->f[p];
+        }
+    }
+    state->in_place = false;
+    state->aa_phase = 0;
+    state->barrier_dirty = true;
+}
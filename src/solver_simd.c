@@ -0,0 +1,455 @@
+#include "solver_simd.h"
+#include "solver_internal.h"
+#include "lattice.h"
+
+// Cada función se compila con su propio target, así el resto del proyecto
+// sigue siendo x86-64 genérico y la elección se hace en tiempo de ejecución.
+// Las operaciones replican Lattice_Collide paso a paso (sin FMA) para que el
+// resultado sea idéntico bit a bit al kernel escalar.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SOLVER_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+#ifdef SOLVER_SIMD_X86
+
+#define AVX2_FN __attribute__((target("avx2")))
+#define AVX2_INLINE static inline __attribute__((always_inline, target("avx2")))
+#define AVX2_F16C_FN __attribute__((target("avx2,f16c")))
+#define AVX512_FN __attribute__((target("avx512f")))
+#define AVX512_INLINE static inline __attribute__((always_inline, target("avx512f")))
+
+bool SolverSimd_HasAVX2(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+bool SolverSimd_HasAVX512(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f");
+}
+
+bool SolverSimd_HasF16C(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("f16c");
+}
+
+// Momentos + colisión BGK de 8 celdas. 'fin' entra propagado y sale colisionado.
+AVX2_INLINE void CollideAVX2(__m256 fin[Q], float omega_value,
+                             __m256 *rho_out, __m256 *ux_out, __m256 *uy_out) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 three = _mm256_set1_ps(3.0f);
+    const __m256 three_half = _mm256_set1_ps(1.5f);
+    const __m256 omega = _mm256_set1_ps(omega_value);
+    const __m256 one_m_omega = _mm256_set1_ps(1.0f - omega_value);
+    const __m256 neg = _mm256_set1_ps(-0.0f);
+
+    // MACROSCOPIC (mismo orden de sumas que Lattice_Collide)
+    __m256 rho = _mm256_add_ps(fin[0], fin[1]);
+    for (int k = 2; k < Q; k++) rho = _mm256_add_ps(rho, fin[k]);
+    __m256 ux = _mm256_sub_ps(fin[1], fin[3]);
+    ux = _mm256_add_ps(ux, fin[5]);
+    ux = _mm256_sub_ps(ux, fin[6]);
+    ux = _mm256_sub_ps(ux, fin[7]);
+    ux = _mm256_add_ps(ux, fin[8]);
+    __m256 uy = _mm256_sub_ps(fin[2], fin[4]);
+    uy = _mm256_add_ps(uy, fin[5]);
+    uy = _mm256_add_ps(uy, fin[6]);
+    uy = _mm256_sub_ps(uy, fin[7]);
+    uy = _mm256_sub_ps(uy, fin[8]);
+
+    __m256 positive = _mm256_cmp_ps(rho, zero, _CMP_GT_OQ);
+    ux = _mm256_blendv_ps(ux, _mm256_div_ps(ux, rho), positive);
+    uy = _mm256_blendv_ps(uy, _mm256_div_ps(uy, rho), positive);
+
+    // COLLISION
+    __m256 usq = _mm256_mul_ps(three_half,
+                    _mm256_add_ps(_mm256_mul_ps(ux, ux), _mm256_mul_ps(uy, uy)));
+    __m256 cu[Q];
+    cu[0] = zero;
+    cu[1] = _mm256_mul_ps(three, ux);
+    cu[2] = _mm256_mul_ps(three, uy);
+    cu[5] = _mm256_mul_ps(three, _mm256_add_ps(ux, uy));
+    cu[6] = _mm256_mul_ps(three, _mm256_sub_ps(uy, ux));
+    cu[3] = _mm256_xor_ps(cu[1], neg);
+    cu[4] = _mm256_xor_ps(cu[2], neg);
+    cu[7] = _mm256_xor_ps(cu[5], neg);
+    cu[8] = _mm256_xor_ps(cu[6], neg);
+
+    for (int k = 0; k < Q; k++) {
+        __m256 wr = _mm256_mul_ps(_mm256_set1_ps(w[k]), rho);
+        __m256 t = _mm256_add_ps(one, cu[k]);
+        t = _mm256_add_ps(t, _mm256_mul_ps(half, _mm256_mul_ps(cu[k], cu[k])));
+        t = _mm256_sub_ps(t, usq);
+        __m256 f_eq = _mm256_mul_ps(wr, t);
+        fin[k] = _mm256_add_ps(_mm256_mul_ps(one_m_omega, fin[k]),
+                               _mm256_mul_ps(omega, f_eq));
+    }
+
+    *rho_out = rho;
+    *ux_out = ux;
+    *uy_out = uy;
+}
+
+// Ídem con 16 celdas
+AVX512_INLINE void CollideAVX512(__m512 fin[Q], float omega_value,
+                                 __m512 *rho_out, __m512 *ux_out, __m512 *uy_out) {
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 one = _mm512_set1_ps(1.0f);
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 three = _mm512_set1_ps(3.0f);
+    const __m512 three_half = _mm512_set1_ps(1.5f);
+    const __m512 omega = _mm512_set1_ps(omega_value);
+    const __m512 one_m_omega = _mm512_set1_ps(1.0f - omega_value);
+    const __m512i neg = _mm512_set1_epi32((int)0x80000000u);
+
+    // MACROSCOPIC (mismo orden de sumas que Lattice_Collide)
+    __m512 rho = _mm512_add_ps(fin[0], fin[1]);
+    for (int k = 2; k < Q; k++) rho = _mm512_add_ps(rho, fin[k]);
+    __m512 ux = _mm512_sub_ps(fin[1], fin[3]);
+    ux = _mm512_add_ps(ux, fin[5]);
+    ux = _mm512_sub_ps(ux, fin[6]);
+    ux = _mm512_sub_ps(ux, fin[7]);
+    ux = _mm512_add_ps(ux, fin[8]);
+    __m512 uy = _mm512_sub_ps(fin[2], fin[4]);
+    uy = _mm512_add_ps(uy, fin[5]);
+    uy = _mm512_add_ps(uy, fin[6]);
+    uy = _mm512_sub_ps(uy, fin[7]);
+    uy = _mm512_sub_ps(uy, fin[8]);
+
+    __mmask16 positive = _mm512_cmp_ps_mask(rho, zero, _CMP_GT_OQ);
+    ux = _mm512_mask_div_ps(ux, positive, ux, rho);
+    uy = _mm512_mask_div_ps(uy, positive, uy, rho);
+
+    // COLLISION
+    __m512 usq = _mm512_mul_ps(three_half,
+                    _mm512_add_ps(_mm512_mul_ps(ux, ux), _mm512_mul_ps(uy, uy)));
+    __m512 cu[Q];
+    cu[0] = zero;
+    cu[1] = _mm512_mul_ps(three, ux);
+    cu[2] = _mm512_mul_ps(three, uy);
+    cu[5] = _mm512_mul_ps(three, _mm512_add_ps(ux, uy));
+    cu[6] = _mm512_mul_ps(three, _mm512_sub_ps(uy, ux));
+    cu[3] = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(cu[1]), neg));
+    cu[4] = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(cu[2]), neg));
+    cu[7] = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(cu[5]), neg));
+    cu[8] = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(cu[6]), neg));
+
+    for (int k = 0; k < Q; k++) {
+        __m512 wr = _mm512_mul_ps(_mm512_set1_ps(w[k]), rho);
+        __m512 t = _mm512_add_ps(one, cu[k]);
+        t = _mm512_add_ps(t, _mm512_mul_ps(half, _mm512_mul_ps(cu[k], cu[k])));
+        t = _mm512_sub_ps(t, usq);
+        __m512 f_eq = _mm512_mul_ps(wr, t);
+        fin[k] = _mm512_add_ps(_mm512_mul_ps(one_m_omega, fin[k]),
+                               _mm512_mul_ps(omega, f_eq));
+    }
+
+    *rho_out = rho;
+    *ux_out = ux;
+    *uy_out = uy;
+}
+
+AVX2_FN
+int SolverSimd_InteriorAVX2(SimulationState *state, int i0, int i1) {
+    const int S = state->stride;
+    const int W = state->width;
+    const float *f = state->f;
+    float *new_f = state->new_f;
+
+    int i = i0;
+    for (; i + 8 <= i1; i += 8) {
+        // STREAMING: lectura directa de los vecinos
+        __m256 fin[Q];
+        for (int k = 0; k < Q; k++) {
+            int nb = i - cx[k] - cy[k] * W;
+            fin[k] = _mm256_loadu_ps(f + (size_t)k*S + nb);
+        }
+
+        __m256 rho, ux, uy;
+        CollideAVX2(fin, state->omega, &rho, &ux, &uy);
+
+        _mm256_storeu_ps(state->rho + i, rho);
+        _mm256_storeu_ps(state->ux + i, ux);
+        _mm256_storeu_ps(state->uy + i, uy);
+        for (int k = 0; k < Q; k++) {
+            _mm256_storeu_ps(new_f + (size_t)k*S + i, fin[k]);
+        }
+    }
+    return i;
+}
+
+AVX512_FN
+int SolverSimd_InteriorAVX512(SimulationState *state, int i0, int i1) {
+    const int S = state->stride;
+    const int W = state->width;
+    const float *f = state->f;
+    float *new_f = state->new_f;
+
+    int i = i0;
+    for (; i + 16 <= i1; i += 16) {
+        // STREAMING: lectura directa de los vecinos
+        __m512 fin[Q];
+        for (int k = 0; k < Q; k++) {
+            int nb = i - cx[k] - cy[k] * W;
+            fin[k] = _mm512_loadu_ps(f + (size_t)k*S + nb);
+        }
+
+        __m512 rho, ux, uy;
+        CollideAVX512(fin, state->omega, &rho, &ux, &uy);
+
+        _mm512_storeu_ps(state->rho + i, rho);
+        _mm512_storeu_ps(state->ux + i, ux);
+        _mm512_storeu_ps(state->uy + i, uy);
+        for (int k = 0; k < Q; k++) {
+            _mm512_storeu_ps(new_f + (size_t)k*S + i, fin[k]);
+        }
+    }
+    return i;
+}
+
+// Propagación en el lugar (solver_inplace.c). Fase 0: lee f[k][i] y guarda
+// en f[opp k][i]. Fase 1: lee f[opp k][i - c_k] y guarda en f[k][i + c_k].
+// Cada bloque lee todo antes de escribir y solo toca posiciones propias.
+AVX2_FN
+int SolverSimd_InPlaceAVX2(SimulationState *state, int i0, int i1, bool odd) {
+    const int S = state->stride;
+    const int W = state->width;
+    float *f = state->f;
+
+    int i = i0;
+    for (; i + 8 <= i1; i += 8) {
+        __m256 fin[Q];
+        for (int k = 0; k < Q; k++) {
+            int nb = odd ? i - cx[k] - cy[k] * W : i;
+            int plane = odd ? opp[k] : k;
+            fin[k] = _mm256_loadu_ps(f + (size_t)plane*S + nb);
+        }
+
+        __m256 rho, ux, uy;
+        CollideAVX2(fin, state->omega, &rho, &ux, &uy);
+
+        _mm256_storeu_ps(state->rho + i, rho);
+        _mm256_storeu_ps(state->ux + i, ux);
+        _mm256_storeu_ps(state->uy + i, uy);
+        for (int k = 0; k < Q; k++) {
+            int dst = odd ? i + cx[k] + cy[k] * W : i;
+            int plane = odd ? k : opp[k];
+            _mm256_storeu_ps(f + (size_t)plane*S + dst, fin[k]);
+        }
+    }
+    return i;
+}
+
+AVX512_FN
+int SolverSimd_InPlaceAVX512(SimulationState *state, int i0, int i1, bool odd) {
+    const int S = state->stride;
+    const int W = state->width;
+    float *f = state->f;
+
+    int i = i0;
+    for (; i + 16 <= i1; i += 16) {
+        __m512 fin[Q];
+        for (int k = 0; k < Q; k++) {
+            int nb = odd ? i - cx[k] - cy[k] * W : i;
+            int plane = odd ? opp[k] : k;
+            fin[k] = _mm512_loadu_ps(f + (size_t)plane*S + nb);
+        }
+
+        __m512 rho, ux, uy;
+        CollideAVX512(fin, state->omega, &rho, &ux, &uy);
+
+        _mm512_storeu_ps(state->rho + i, rho);
+        _mm512_storeu_ps(state->ux + i, ux);
+        _mm512_storeu_ps(state->uy + i, uy);
+        for (int k = 0; k < Q; k++) {
+            int dst = odd ? i + cx[k] + cy[k] * W : i;
+            int plane = odd ? k : opp[k];
+            _mm512_storeu_ps(f + (size_t)plane*S + dst, fin[k]);
+        }
+    }
+    return i;
+}
+
+// Poblaciones en half: f = half + w[k] (mismas operaciones que solver_half.c)
+AVX2_F16C_FN
+int SolverSimd_HalfAVX2(SimulationState *state, int i0, int i1) {
+    const int S = state->stride;
+    const int W = state->width;
+    const uint16_t *f = state->f_half;
+    uint16_t *new_f = state->new_f_half;
+
+    int i = i0;
+    for (; i + 8 <= i1; i += 8) {
+        __m256 fin[Q];
+        for (int k = 0; k < Q; k++) {
+            int nb = i - cx[k] - cy[k] * W;
+            __m128i h = _mm_loadu_si128((const __m128i*)(f + (size_t)k*S + nb));
+            fin[k] = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtph_ps(h), _mm256_set1_ps(HALF_INV_SCALE)),
+                                   _mm256_set1_ps(w[k]));
+        }
+
+        __m256 rho, ux, uy;
+        CollideAVX2(fin, state->omega, &rho, &ux, &uy);
+
+        _mm256_storeu_ps(state->rho + i, rho);
+        _mm256_storeu_ps(state->ux + i, ux);
+        _mm256_storeu_ps(state->uy + i, uy);
+        for (int k = 0; k < Q; k++) {
+            __m256 shifted = _mm256_mul_ps(_mm256_sub_ps(fin[k], _mm256_set1_ps(w[k])),
+                                           _mm256_set1_ps(HALF_SCALE));
+            __m128i h = _mm256_cvtps_ph(shifted, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            _mm_storeu_si128((__m128i*)(new_f + (size_t)k*S + i), h);
+        }
+    }
+    return i;
+}
+
+AVX512_FN
+int SolverSimd_HalfAVX512(SimulationState *state, int i0, int i1) {
+    const int S = state->stride;
+    const int W = state->width;
+    const uint16_t *f = state->f_half;
+    uint16_t *new_f = state->new_f_half;
+
+    int i = i0;
+    for (; i + 16 <= i1; i += 16) {
+        __m512 fin[Q];
+        for (int k = 0; k < Q; k++) {
+            int nb = i - cx[k] - cy[k] * W;
+            __m256i h = _mm256_loadu_si256((const __m256i*)(f + (size_t)k*S + nb));
+            fin[k] = _mm512_add_ps(_mm512_mul_ps(_mm512_cvtph_ps(h), _mm512_set1_ps(HALF_INV_SCALE)),
+                                   _mm512_set1_ps(w[k]));
+        }
+
+        __m512 rho, ux, uy;
+        CollideAVX512(fin, state->omega, &rho, &ux, &uy);
+
+        _mm512_storeu_ps(state->rho + i, rho);
+        _mm512_storeu_ps(state->ux + i, ux);
+        _mm512_storeu_ps(state->uy + i, uy);
+        for (int k = 0; k < Q; k++) {
+            __m512 shifted = _mm512_mul_ps(_mm512_sub_ps(fin[k], _mm512_set1_ps(w[k])),
+                                           _mm512_set1_ps(HALF_SCALE));
+            __m256i h = _mm512_cvtps_ph(shifted, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            _mm256_storeu_si256((__m256i*)(new_f + (size_t)k*S + i), h);
+        }
+    }
+    return i;
+}
+
+AVX2_FN
+int SolverSimd_SparseAVX2(SimulationState *state, int j0, int j1) {
+    const SparseLattice *sp = &state->sparse_lattice;
+    const int S = sp->stride;
+    const float *f = state->f;
+    float *new_f = state->new_f;
+
+    int j = j0;
+    for (; j + 8 <= j1; j += 8) {
+        // STREAMING: gather según la tabla de vecinos
+        __m256 fin[Q];
+        fin[0] = _mm256_loadu_ps(f + j);
+        for (int k = 1; k < Q; k++) {
+            __m256i src = _mm256_loadu_si256((const __m256i*)(sp->src + (size_t)(k-1)*S + j));
+            fin[k] = _mm256_i32gather_ps(f, src, 4);
+        }
+
+        __m256 rho, ux, uy;
+        CollideAVX2(fin, state->omega, &rho, &ux, &uy);
+
+        for (int k = 0; k < Q; k++) {
+            _mm256_storeu_ps(new_f + (size_t)k*S + j, fin[k]);
+        }
+
+        // Momentos a la grilla densa (AVX2 no tiene scatter)
+        float rho_v[8], ux_v[8], uy_v[8];
+        _mm256_storeu_ps(rho_v, rho);
+        _mm256_storeu_ps(ux_v, ux);
+        _mm256_storeu_ps(uy_v, uy);
+        for (int l = 0; l < 8; l++) {
+            int i = sp->cell[j + l];
+            state->rho[i] = rho_v[l];
+            state->ux[i] = ux_v[l];
+            state->uy[i] = uy_v[l];
+        }
+    }
+    return j;
+}
+
+AVX512_FN
+int SolverSimd_SparseAVX512(SimulationState *state, int j0, int j1) {
+    const SparseLattice *sp = &state->sparse_lattice;
+    const int S = sp->stride;
+    const float *f = state->f;
+    float *new_f = state->new_f;
+
+    int j = j0;
+    for (; j + 16 <= j1; j += 16) {
+        // STREAMING: gather según la tabla de vecinos
+        __m512 fin[Q];
+        fin[0] = _mm512_loadu_ps(f + j);
+        for (int k = 1; k < Q; k++) {
+            __m512i src = _mm512_loadu_si512((const void*)(sp->src + (size_t)(k-1)*S + j));
+            fin[k] = _mm512_i32gather_ps(src, f, 4);
+        }
+
+        __m512 rho, ux, uy;
+        CollideAVX512(fin, state->omega, &rho, &ux, &uy);
+
+        for (int k = 0; k < Q; k++) {
+            _mm512_storeu_ps(new_f + (size_t)k*S + j, fin[k]);
+        }
+
+        // Momentos a la grilla densa
+        __m512i cell = _mm512_loadu_si512((const void*)(sp->cell + j));
+        _mm512_i32scatter_ps(state->rho, cell, rho, 4);
+        _mm512_i32scatter_ps(state->ux, cell, ux, 4);
+        _mm512_i32scatter_ps(state->uy, cell, uy, 4);
+    }
+    return j;
+}
+
+#else
+
+// Sin x86 o sin GCC/Clang: solo el kernel escalar
+bool SolverSimd_HasAVX2(void) { return false; }
+bool SolverSimd_HasAVX512(void) { return false; }
+bool SolverSimd_HasF16C(void) { return false; }
+
+int SolverSimd_InteriorAVX2(SimulationState *state, int i0, int i1) {
+    (void)state; (void)i1;
+    return i0;
+}
+int SolverSimd_InteriorAVX512(SimulationState *state, int i0, int i1) {
+    (void)state; (void)i1;
+    return i0;
+}
+int SolverSimd_InPlaceAVX2(SimulationState *state, int i0, int i1, bool odd) {
+    (void)state; (void)i1; (void)odd;
+    return i0;
+}
+int SolverSimd_InPlaceAVX512(SimulationState *state, int i0, int i1, bool odd) {
+    (void)state; (void)i1; (void)odd;
+    return i0;
+}
+int SolverSimd_HalfAVX2(SimulationState *state, int i0, int i1) {
+    (void)state; (void)i1;
+    return i0;
+}
+int SolverSimd_HalfAVX512(SimulationState *state, int i0, int i1) {
+    (void)state; (void)i1;
+    return i0;
+}
+int SolverSimd_SparseAVX2(SimulationState *state, int j0, int j1) {
+    (void)state; (void)j1;
+    return j0;
+}
+int SolverSimd_SparseAVX512(SimulationState *state, int j0, int j1) {
+    (void)state; (void)j1;
+    return j0;
+}
+
+#endif
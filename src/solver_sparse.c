@@ -0,0 +1,176 @@
+// Almacenamiento compacto (direccionamiento indirecto) de solo las celdas de
+// fluido. Con geometrías densas (medios porosos, muchos obstáculos dibujados)
+// la memoria y el costo del paso pasan a depender del número de celdas de
+// fluido en lugar del área de la grilla. solver.c decide cuándo usarlo.
+#include "solver_internal.h"
+#include "solver_simd.h"
+#include "lattice.h"
+#include <stdlib.h>
+#include <string.h>
+
+void SolverSparse_Free(SparseLattice *sparse) {
+    free(sparse->cell);
+    free(sparse->slot);
+    free(sparse->row_offset);
+    free(sparse->src);
+    memset(sparse, 0, sizeof(*sparse));
+}
+
+// Valor actual de la población k de la celda i (de la grilla densa o del
+// almacenamiento compacto anterior). Las celdas sin valor arrancan en reposo.
+static float OldPopulation(const SimulationState *state, const float *f, int i, int k) {
+    if (!state->sparse) return f[PopIndex(state, i, k)];
+    const SparseLattice *old = &state->sparse_lattice;
+    int j = old->slot[i];
+    return j >= 0 ? f[(size_t)k * old->stride + j] : w[k];
+}
+
+void SolverSparse_Build(SimulationState *state) {
+    int W = state->width;
+    int H = state->height;
+    int N = W * H;
+    const bool *barrier = state->barrier;
+
+    SparseLattice sp;
+    memset(&sp, 0, sizeof(sp));
+    sp.slot = (int*)malloc((size_t)N * sizeof(int));
+    sp.row_offset = (int*)malloc((H + 1) * sizeof(int));
+
+    // Numerar las celdas de fluido en orden de filas
+    int count = 0;
+    for (int y = 0; y < H; y++) {
+        sp.row_offset[y] = count;
+        for (int x = 0; x < W; x++) {
+            int i = y * W + x;
+            sp.slot[i] = barrier[i] ? -1 : count++;
+        }
+    }
+    sp.row_offset[H] = count;
+    sp.count = count;
+    sp.stride = (count + 15) & ~15;
+
+    int S = sp.stride;
+    int ghost = Q * S; // f[ghost + k] = w[k] (frontera abierta)
+    sp.cell = (int*)malloc(((size_t)count + 1) * sizeof(int));
+    sp.src = (int*)malloc(((size_t)(Q - 1) * S + 1) * sizeof(int));
+
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            int i = y * W + x;
+            int j = sp.slot[i];
+            if (j < 0) continue;
+            sp.cell[j] = i;
+            for (int k = 1; k < Q; k++) {
+                int nx = x - cx[k];
+                int ny = y - cy[k];
+                int src;
+                if (nx < 0 || nx >= W || ny < 0 || ny >= H) src = ghost + k;       // Frontera abierta
+                else if (barrier[ny * W + nx]) src = opp[k] * S + j;               // Rebote
+                else src = k * S + sp.slot[ny * W + nx];                           // Vecino
+                sp.src[(size_t)(k - 1) * S + j] = src;
+            }
+        }
+    }
+    // Relleno hasta el múltiplo de 16: apunta a valores válidos
+    for (int k = 1; k < Q; k++) {
+        for (int j = count; j < S; j++) sp.src[(size_t)(k - 1) * S + j] = ghost + k;
+    }
+
+    // Poblaciones: se conservan las de las celdas que ya eran fluido
+    size_t total = (size_t)Q * S + Q;
+    float *f = Solver_AllocPopulations(total);
+    float *new_f = Solver_AllocPopulations(total);
+    for (int k = 0; k < Q; k++) {
+        for (int j = 0; j < count; j++) {
+            f[(size_t)k * S + j] = OldPopulation(state, state->f, sp.cell[j], k);
+        }
+        for (int j = count; j < S; j++) f[(size_t)k * S + j] = w[k];
+        f[ghost + k] = w[k];
+    }
+    memcpy(new_f, f, total * sizeof(float));
+
+    Solver_ReleasePopulations(state, state->f);
+    Solver_ReleasePopulations(state, state->new_f);
+    if (state->sparse) SolverSparse_Free(&state->sparse_lattice);
+
+    state->f = f;
+    state->new_f = new_f;
+    state->sparse_lattice = sp;
+    state->sparse = true;
+}
+
+void SolverSparse_ToDense(SimulationState *state) {
+    if (!state->sparse) return;
+
+    int N = state->width * state->height;
+    state->stride = Solver_DenseStride(state->layout, N);
+    size_t total = (size_t)state->stride * Q;
+    float *f = Solver_AllocPopulations(total);
+    float *new_f = Solver_AllocPopulations(total);
+
+    // Las paredes no tienen poblaciones guardadas: quedan en reposo. Por
+    // celdas con el reparto del paso (primer toque de los arrays nuevos)
+    #pragma omp parallel for schedule(static) num_threads(state->num_threads)
+    for (int i = 0; i < N; i++) {
+        for (int k = 0; k < Q; k++) {
+            size_t p = PopIndex(state, i, k);
+            f[p] = OldPopulation(state, state->f, i, k);
+            new_f[p] = f[p];
+        }
+    }
+
+    Solver_ReleasePopulations(state, state->f);
+    Solver_ReleasePopulations(state, state->new_f);
+    SolverSparse_Free(&state->sparse_lattice);
+    state->f = f;
+    state->new_f = new_f;
+    state->sparse = false;
+}
+
+// Stream + collide de las celdas de fluido [j0, j1) (escalar)
+static void StreamCollideSparse(SimulationState *state, int j0, int j1, bool inlet_first) {
+    const SparseLattice *sp = &state->sparse_lattice;
+    const int S = sp->stride;
+    const float *f = state->f;
+    float *new_f = state->new_f;
+
+    for (int j = j0; j < j1; j++) {
+        float fin[Q];
+        fin[0] = f[j];
+        for (int k = 1; k < Q; k++) {
+            fin[k] = f[sp->src[(size_t)(k - 1) * S + j]];
+        }
+
+        float rho, ux, uy;
+        bool inlet = inlet_first && j == j0;
+        Lattice_Collide(fin, state->omega, inlet, state->inlet_velocity, &rho, &ux, &uy);
+
+        int i = sp->cell[j];
+        state->rho[i] = rho;
+        state->ux[i] = ux;
+        state->uy[i] = uy;
+        for (int k = 0; k < Q; k++) {
+            new_f[(size_t)k * S + j] = fin[k];
+        }
+    }
+}
+
+void SolverSparse_StepRows(SimulationState *state, int y0, int y1) {
+    const SparseLattice *sp = &state->sparse_lattice;
+    int W = state->width;
+
+    for (int y = y0; y < y1; y++) {
+        int j = sp->row_offset[y];
+        int end = sp->row_offset[y + 1];
+        if (j == end) continue;
+
+        // La primera celda de fluido de la fila puede ser el inlet (x = 0)
+        if (sp->cell[j] == y * W) {
+            StreamCollideSparse(state, j, j + 1, true);
+            j++;
+        }
+        if (state->isa == ISA_AVX512) j = SolverSimd_SparseAVX512(state, j, end);
+        else if (state->isa == ISA_AVX2) j = SolverSimd_SparseAVX2(state, j, end);
+        StreamCollideSparse(state, j, end, false);
+    }
+}
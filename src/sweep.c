@@ -0,0 +1,283 @@
+// Barrido de parámetros: corre una simulación por cada combinación de omega
+// y velocidad de entrada, varias a la vez (una por núcleo, con robo de
+// trabajo entre hilos), sobre la misma geometría compartida. Las grillas
+// chicas escalan mal con hilos dentro de una simulación; en paralelo unas
+// con otras llenan todos los núcleos. Una fila por corrida en un CSV.
+#include "state.h"
+#include "solver.h"
+#include "scenario.h"
+#include "config.h"
+#include "taskpool.h"
+#include "timer.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Cómo terminó una corrida
+typedef enum {
+    RUN_COMPLETED = 0, // Hizo todos los pasos
+    RUN_CONVERGED,     // El residual bajó de --converge-tol
+    RUN_DIVERGED       // Apareció un NaN/inf (omega o velocidad fuera de rango estable)
+} RunStatus;
+
+static const char *STATUS_NAMES[] = { "completed", "converged", "diverged" };
+
+typedef struct {
+    float *omegas;
+    int num_omegas;
+    float *velocities;
+    int num_velocities;
+    int width;
+    int height;
+    int scenario;
+    int steps;
+    float converge_tol;   // 0 = correr todos los pasos
+    int check_period;     // Cada cuántos pasos se miran residual y divergencia
+    int workers;          // 0 = uno por núcleo
+    int layout;
+    int isa;
+    const char *output;
+} SweepConfig;
+
+typedef struct {
+    float omega;
+    float inlet_velocity;
+    int status;           // RunStatus
+    int steps;            // Pasos hechos
+    SolverDiagnostics diagnostics; // Del último paso medido
+    double seconds;
+    int worker;
+} SweepResult;
+
+typedef struct {
+    const SweepConfig *cfg;
+    bool *barrier;        // Geometría compartida (solo lectura)
+    SweepResult *results; // Una por corrida, en el orden de la grilla de parámetros
+} Sweep;
+
+static void RunCase(void *arg, int index, int worker) {
+    Sweep *sweep = (Sweep*)arg;
+    const SweepConfig *cfg = sweep->cfg;
+    SweepResult *r = &sweep->results[index];
+    r->omega = cfg->omegas[index / cfg->num_velocities];
+    r->inlet_velocity = cfg->velocities[index % cfg->num_velocities];
+    r->status = RUN_COMPLETED;
+    r->worker = worker;
+
+    // Cada corrida con un solo hilo: el paralelismo está entre corridas.
+    // También la inicialización, así la memoria queda en el nodo del worker
+#ifdef _OPENMP
+    omp_set_num_threads(1);
+#endif
+    SimulationState state;
+    Solver_Init(&state, cfg->width, cfg->height);
+    Solver_ShareBarrier(&state, sweep->barrier);
+    Solver_SetThreads(&state, 1);
+    Solver_SetLayout(&state, (PopulationLayout)cfg->layout);
+    if (cfg->layout == LAYOUT_SOA) Solver_SetIsa(&state, (SolverIsa)cfg->isa);
+    state.omega = r->omega;
+    state.inlet_velocity = r->inlet_velocity;
+
+    double t0 = Timer_Now();
+    while (state.time_step < cfg->steps) {
+        Solver_RequestDiagnostics(&state);
+        Solver_Advance(&state, Config_NextEvent(state.time_step, cfg->check_period, cfg->steps) - state.time_step);
+
+        const SolverDiagnostics *d = &state.diagnostics;
+        if (!isfinite(d->mass) || !isfinite(d->max_velocity)) {
+            r->status = RUN_DIVERGED;
+            break;
+        }
+        if (cfg->converge_tol > 0.0f && d->residual < cfg->converge_tol) {
+            r->status = RUN_CONVERGED;
+            break;
+        }
+    }
+    r->seconds = Timer_Now() - t0;
+    r->steps = state.time_step;
+    r->diagnostics = state.diagnostics;
+    Solver_Cleanup(&state);
+
+    // Progreso por stderr (el orden de terminación depende de los hilos)
+    fprintf(stderr, "Corrida %d (omega %.3f, velocidad %.3f): %s en %d pasos, %.2f s\n",
+            index, r->omega, r->inlet_velocity, STATUS_NAMES[r->status], r->steps, r->seconds);
+}
+
+// "0.5,0.8,1.2" o "inicio:fin:cantidad" (extremos incluidos)
+static bool ParseValues(const char *text, float **out, int *count) {
+    float a, b;
+    int n;
+    char extra;
+    if (sscanf(text, "%f:%f:%d%c", &a, &b, &n, &extra) == 3) {
+        if (n < 1) return false;
+        *out = (float*)malloc(n * sizeof(float));
+        for (int i = 0; i < n; i++) (*out)[i] = n == 1 ? a : a + (b - a) * i / (n - 1);
+        *count = n;
+        return true;
+    }
+
+    int capacity = 1;
+    for (const char *c = text; *c; c++) capacity += *c == ',';
+    *out = (float*)malloc(capacity * sizeof(float));
+    *count = 0;
+    const char *p = text;
+    while (*p) {
+        char *end;
+        float value = strtof(p, &end);
+        if (end == p || (*end != ',' && *end != '\0')) return false;
+        (*out)[(*count)++] = value;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return *count > 0;
+}
+
+static void SetDefaults(SweepConfig *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    ParseValues("1.0:1.9:10", &cfg->omegas, &cfg->num_omegas);
+    ParseValues("0.02:0.12:6", &cfg->velocities, &cfg->num_velocities);
+    cfg->width = DEFAULT_GRID_W;
+    cfg->height = DEFAULT_GRID_H;
+    cfg->scenario = SCENARIO_CIRCLE;
+    cfg->steps = 2000;
+    cfg->converge_tol = 0.0f;
+    cfg->check_period = 100;
+    cfg->workers = 0;
+    cfg->layout = LAYOUT_SOA;
+    cfg->isa = ISA_AVX512;
+    cfg->output = "sweep_results.csv";
+}
+
+static bool ParseArgs(SweepConfig *cfg, int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Falta el valor de %s\n", arg);
+            return false;
+        }
+        const char *value = argv[++i];
+        bool ok;
+        if (strcmp(arg, "--omegas") == 0) {
+            free(cfg->omegas);
+            ok = ParseValues(value, &cfg->omegas, &cfg->num_omegas);
+        } else if (strcmp(arg, "--velocities") == 0) {
+            free(cfg->velocities);
+            ok = ParseValues(value, &cfg->velocities, &cfg->num_velocities);
+        }
+        else if (strcmp(arg, "--size") == 0)           ok = Config_ParseSize(value, &cfg->width, &cfg->height);
+        else if (strcmp(arg, "--scenario") == 0)       ok = ParseScenarioName(value, &cfg->scenario);
+        else if (strcmp(arg, "--steps") == 0)          ok = Config_ParseInt(value, &cfg->steps, 1);
+        else if (strcmp(arg, "--converge-tol") == 0)   ok = sscanf(value, "%f", &cfg->converge_tol) == 1;
+        else if (strcmp(arg, "--converge-every") == 0) ok = Config_ParseInt(value, &cfg->check_period, 1);
+        else if (strcmp(arg, "--workers") == 0)        ok = Config_ParseInt(value, &cfg->workers, 0);
+        else if (strcmp(arg, "--layout") == 0) {
+            ok = strcmp(value, "aos") == 0 || strcmp(value, "soa") == 0;
+            cfg->layout = strcmp(value, "aos") == 0 ? LAYOUT_AOS : LAYOUT_SOA;
+        } else if (strcmp(arg, "--isa") == 0) {
+            ok = true;
+            if (strcmp(value, "scalar") == 0) cfg->isa = ISA_SCALAR;
+            else if (strcmp(value, "avx2") == 0) cfg->isa = ISA_AVX2;
+            else if (strcmp(value, "avx512") == 0 || strcmp(value, "auto") == 0) cfg->isa = ISA_AVX512;
+            else ok = false;
+        }
+        else if (strcmp(arg, "--output") == 0) { cfg->output = value; ok = true; }
+        else {
+            fprintf(stderr, "Opcion desconocida: %s\n", arg);
+            return false;
+        }
+        if (!ok) {
+            fprintf(stderr, "Valor invalido para %s: %s\n", arg, value);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void PrintUsage(const char *program) {
+    printf("Uso: %s [opciones]\n", program);
+    printf("  --omegas LISTA          valores de omega: 0.8,1.2,1.6 o inicio:fin:cantidad (1.0:1.9:10)\n");
+    printf("  --velocities LISTA      velocidades de entrada, mismo formato (0.02:0.12:6)\n");
+    printf("  --size N|WxH            tamaño de la grilla (400)\n");
+    printf("  --scenario NOMBRE       none, circle, square o wall (circle)\n");
+    printf("  --steps N               pasos maximos por corrida (2000)\n");
+    printf("  --converge-tol F        corta una corrida al bajar el residual de F (0 = nunca)\n");
+    printf("  --converge-every N      cada cuantos pasos se miran residual y divergencia (100)\n");
+    printf("  --workers N             corridas simultaneas, 0 = una por nucleo (0)\n");
+    printf("  --layout aos|soa        orden de las poblaciones (soa)\n");
+    printf("  --isa auto|avx512|avx2|scalar  kernel maximo para soa\n");
+    printf("  --output ARCHIVO        tabla de resultados (sweep_results.csv)\n");
+}
+
+static bool WriteResults(const SweepConfig *cfg, const SweepResult *results, int count) {
+    FILE *out = fopen(cfg->output, "w");
+    if (out == NULL) return false;
+    fprintf(out, "run,omega,inlet_velocity,status,steps,residual,mass,kinetic_energy,"
+                 "max_velocity,seconds,mlups,worker\n");
+    double cells = (double)cfg->width * cfg->height;
+    for (int i = 0; i < count; i++) {
+        const SweepResult *r = &results[i];
+        double mlups = r->seconds > 0.0 ? cells * r->steps / r->seconds * 1e-6 : 0.0;
+        fprintf(out, "%d,%.6f,%.6f,%s,%d,%.6e,%.6f,%.6f,%.6f,%.3f,%.2f,%d\n", i, r->omega,
+                r->inlet_velocity, STATUS_NAMES[r->status], r->steps, r->diagnostics.residual,
+                r->diagnostics.mass, r->diagnostics.kinetic_energy, r->diagnostics.max_velocity,
+                r->seconds, mlups, r->worker);
+    }
+    return fclose(out) == 0;
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            PrintUsage(argv[0]);
+            return 0;
+        }
+    }
+
+    SweepConfig cfg;
+    SetDefaults(&cfg);
+    if (!ParseArgs(&cfg, argc, argv)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    // Geometría única para todas las corridas: solo hace falta barrier
+    SimulationState geometry;
+    memset(&geometry, 0, sizeof(geometry));
+    geometry.width = cfg.width;
+    geometry.height = cfg.height;
+    geometry.barrier = (bool*)calloc((size_t)cfg.width * cfg.height, sizeof(bool));
+    InitScenario(&geometry, cfg.scenario);
+
+    int count = cfg.num_omegas * cfg.num_velocities;
+    int workers = cfg.workers > 0 ? cfg.workers : TaskPool_DefaultWorkers();
+    Sweep sweep;
+    sweep.cfg = &cfg;
+    sweep.barrier = geometry.barrier;
+    sweep.results = (SweepResult*)calloc(count, sizeof(SweepResult));
+
+    printf("Barrido de %d x %d corridas (%d en total), grilla %dx%d, escenario %s, %d pasos, %d a la vez\n",
+           cfg.num_omegas, cfg.num_velocities, count, cfg.width, cfg.height,
+           ScenarioName(cfg.scenario), cfg.steps, workers);
+
+    double t0 = Timer_Now();
+    TaskPool_Run(count, workers, RunCase, &sweep);
+    double elapsed = Timer_Now() - t0;
+
+    double updates = 0.0;
+    for (int i = 0; i < count; i++) updates += (double)cfg.width * cfg.height * sweep.results[i].steps;
+    printf("Tiempo total: %.2f s, %.2f MLUPS sumando todas las corridas\n",
+           elapsed, elapsed > 0.0 ? updates / elapsed * 1e-6 : 0.0);
+
+    bool ok = WriteResults(&cfg, sweep.results, count);
+    if (ok) printf("Resultados en %s\n", cfg.output);
+    else fprintf(stderr, "No se pudo escribir %s\n", cfg.output);
+
+    free(sweep.results);
+    free(geometry.barrier);
+    free(cfg.omegas);
+    free(cfg.velocities);
+    return ok ? 0 : 1;
+}
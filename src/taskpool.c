@@ -0,0 +1,146 @@
+#include "taskpool.h"
+#include <stdbool.h>
+#include <stdlib.h>
+
+#if !defined(PLATFORM_WEB) && !defined(_WIN32)
+#define TASKPOOL_THREADED 1
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+int TaskPool_DefaultWorkers(void) {
+#ifdef TASKPOOL_THREADED
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#else
+    return 1;
+#endif
+}
+
+#ifdef TASKPOOL_THREADED
+
+// Tareas pendientes de un hilo: [begin, end). El dueño toma de begin y los
+// ladrones se llevan la mitad final. El relleno evita que dos colas
+// compartan una línea de caché.
+typedef struct {
+    pthread_mutex_t lock;
+    int begin;
+    int end;
+    char pad[64];
+} TaskQueue;
+
+typedef struct {
+    TaskQueue *queues;
+    int workers;
+    TaskFn fn;
+    void *arg;
+} TaskPool;
+
+typedef struct {
+    TaskPool *pool;
+    int worker;
+} WorkerArgs;
+
+// Próxima tarea propia, o -1 si no quedan
+static int PopOwn(TaskQueue *q) {
+    pthread_mutex_lock(&q->lock);
+    int task = q->begin < q->end ? q->begin++ : -1;
+    pthread_mutex_unlock(&q->lock);
+    return task;
+}
+
+// Roba la mitad final del tramo de 'victim' y la deja como tramo propio
+static bool Steal(TaskPool *pool, int worker, int victim) {
+    TaskQueue *v = &pool->queues[victim];
+    pthread_mutex_lock(&v->lock);
+    int available = v->end - v->begin;
+    int begin = 0, end = 0;
+    if (available > 0) {
+        int take = (available + 1) / 2;
+        end = v->end;
+        begin = end - take;
+        v->end = begin;
+    }
+    pthread_mutex_unlock(&v->lock);
+    if (begin == end) return false;
+
+    TaskQueue *own = &pool->queues[worker];
+    pthread_mutex_lock(&own->lock);
+    own->begin = begin;
+    own->end = end;
+    pthread_mutex_unlock(&own->lock);
+    return true;
+}
+
+static void *WorkerThread(void *data) {
+    WorkerArgs *args = (WorkerArgs*)data;
+    TaskPool *pool = args->pool;
+    int worker = args->worker;
+
+    for (;;) {
+        int task;
+        while ((task = PopOwn(&pool->queues[worker])) >= 0) {
+            pool->fn(pool->arg, task, worker);
+        }
+        // Sin tareas propias: recorrer a los demás empezando por el siguiente.
+        // Las tareas no crean tareas, así que si nadie tiene nada, terminó.
+        bool stolen = false;
+        for (int k = 1; k < pool->workers && !stolen; k++) {
+            stolen = Steal(pool, worker, (worker + k) % pool->workers);
+        }
+        if (!stolen) break;
+    }
+    return NULL;
+}
+
+void TaskPool_Run(int count, int workers, TaskFn fn, void *arg) {
+    if (workers <= 0) workers = TaskPool_DefaultWorkers();
+    if (workers > count) workers = count;
+    if (workers <= 1) {
+        for (int i = 0; i < count; i++) fn(arg, i, 0);
+        return;
+    }
+
+    TaskPool pool;
+    pool.queues = (TaskQueue*)calloc(workers, sizeof(TaskQueue));
+    pool.workers = workers;
+    pool.fn = fn;
+    pool.arg = arg;
+    for (int w = 0; w < workers; w++) {
+        pthread_mutex_init(&pool.queues[w].lock, NULL);
+        pool.queues[w].begin = (int)((long)count * w / workers);
+        pool.queues[w].end = (int)((long)count * (w + 1) / workers);
+    }
+
+    pthread_t *threads = (pthread_t*)malloc(workers * sizeof(pthread_t));
+    WorkerArgs *args = (WorkerArgs*)malloc(workers * sizeof(WorkerArgs));
+    bool *started = (bool*)calloc(workers, sizeof(bool));
+    for (int w = 1; w < workers; w++) {
+        args[w].pool = &pool;
+        args[w].worker = w;
+        started[w] = pthread_create(&threads[w], NULL, WorkerThread, &args[w]) == 0;
+    }
+    // El hilo que llama trabaja como el número 0 (si un hilo no arrancó, sus
+    // tareas se las roban los demás)
+    args[0].pool = &pool;
+    args[0].worker = 0;
+    WorkerThread(&args[0]);
+    for (int w = 1; w < workers; w++) {
+        if (started[w]) pthread_join(threads[w], NULL);
+    }
+
+    for (int w = 0; w < workers; w++) pthread_mutex_destroy(&pool.queues[w].lock);
+    free(started);
+    free(args);
+    free(threads);
+    free(pool.queues);
+}
+
+#else
+
+void TaskPool_Run(int count, int workers, TaskFn fn, void *arg) {
+    (void)workers;
+    for (int i = 0; i < count; i++) fn(arg, i, 0);
+}
+
+#endif
@@ -0,0 +1,95 @@
+#include "warmstart.h"
+#include "solver.h"
+#include "refine.h"
+#include "timer.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define WARMSTART_MIN_SIZE 8 // Una grilla gruesa más chica ya no sirve
+
+// Paredes de la grilla de la mitad de resolución: una celda gruesa es pared
+// si alguna de sus celdas finas lo es (no se pierden paredes finas)
+static void Downsample(const bool *fine, int FW, int FH, bool *coarse, int CW, int CH) {
+    for (int y = 0; y < CH; y++) {
+        for (int x = 0; x < CW; x++) {
+            bool wall = false;
+            for (int n = 0; n < 4; n++) {
+                int fx = 2 * x + (n & 1), fy = 2 * y + (n >> 1);
+                if (fx < FW && fy < FH && fine[fy * FW + fx]) wall = true;
+            }
+            coarse[y * CW + x] = wall;
+        }
+    }
+}
+
+// Misma viscosidad física con dx (y dt) 'ratio' veces más grandes
+static float CoarseOmega(float omega, float ratio) {
+    float tau = 0.5f + (1.0f / omega - 0.5f) / ratio;
+    float coarse = 1.0f / tau;
+    return coarse > WARMSTART_MAX_OMEGA ? WARMSTART_MAX_OMEGA : coarse;
+}
+
+// Pasos hasta que el residual baja de la tolerancia (o el tope)
+static int RunLevel(SimulationState *state, const WarmStartOptions *options) {
+    int period = options->check_period > 0 ? options->check_period : 100;
+    while (state->time_step < options->max_steps) {
+        int steps = period;
+        if (state->time_step + steps > options->max_steps) steps = options->max_steps - state->time_step;
+        Solver_RequestDiagnostics(state);
+        Solver_Advance(state, steps);
+        if (state->diagnostics.residual < options->tolerance) break;
+    }
+    return state->time_step;
+}
+
+void WarmStart_Run(SimulationState *state, const WarmStartOptions *options, FILE *log) {
+    // Tamaños de los niveles (0 = la grilla final) y sus paredes
+    int levels = 0;
+    int width[16], height[16];
+    bool *barrier[16];
+    width[0] = state->width;
+    height[0] = state->height;
+    barrier[0] = state->barrier;
+    while (levels < options->levels && levels < 15) {
+        int W = (width[levels] + 1) / 2, H = (height[levels] + 1) / 2;
+        if (W < WARMSTART_MIN_SIZE || H < WARMSTART_MIN_SIZE) break;
+        levels++;
+        width[levels] = W;
+        height[levels] = H;
+        barrier[levels] = (bool*)malloc((size_t)W * H * sizeof(bool));
+        Downsample(barrier[levels - 1], width[levels - 1], height[levels - 1], barrier[levels], W, H);
+    }
+    if (levels == 0) return;
+
+    SimulationState previous;
+    for (int l = levels; l >= 1; l--) {
+        double t0 = Timer_Now();
+        SimulationState level;
+        Solver_Init(&level, width[l], height[l]);
+        level.omega = CoarseOmega(state->omega, (float)state->width / width[l]);
+        level.inlet_velocity = state->inlet_velocity;
+        Solver_SetThreads(&level, state->num_threads);
+        Solver_SetLayout(&level, (PopulationLayout)state->layout);
+        if (state->layout == LAYOUT_SOA) Solver_SetIsa(&level, (SolverIsa)state->isa);
+        Solver_SetSparseThreshold(&level, state->sparse_threshold);
+        Solver_SetTemporalBlocking(&level, state->block_depth);
+        memcpy(level.barrier, barrier[l], (size_t)width[l] * height[l] * sizeof(bool));
+        level.barrier_dirty = true;
+
+        if (l < levels) {
+            Refine_Prolong(&previous, &level);
+            Solver_Cleanup(&previous);
+        }
+        int steps = RunLevel(&level, options);
+        if (log != NULL) {
+            fprintf(log, "Arranque %dx%d (omega %.3f): %d pasos, residual %.3e, %.3f s\n",
+                    level.width, level.height, level.omega, steps, level.diagnostics.residual,
+                    Timer_Now() - t0);
+        }
+        previous = level;
+        free(barrier[l]);
+    }
+
+    Refine_Prolong(&previous, state);
+    Solver_Cleanup(&previous);
+}